@@ -2,6 +2,13 @@
 #define __MEASURE
 
 #include <chrono>
+#ifdef __linux__
+	#include <linux/perf_event.h>
+	#include <sys/ioctl.h>
+	#include <sys/syscall.h>
+	#include <unistd.h>
+	#include <cstring>
+#endif
 
 namespace Time
 {
@@ -32,4 +39,48 @@ namespace Time
 		return duration.count();
 	}
 }
+
+//Hardware counter of data TLB misses of this thread. Only available on Linux, and only if perf events are allowed
+namespace DTlbMisses
+{
+	//Returns a handle to pass to Stop, or -1 if the counter isn't available
+	int Start()
+	{
+#ifdef __linux__
+		perf_event_attr attributes;
+		memset(&attributes, 0, sizeof(attributes));
+		attributes.size = sizeof(attributes);
+		attributes.type = PERF_TYPE_HW_CACHE;
+		attributes.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+		attributes.disabled = 1;
+		attributes.exclude_kernel = 1;
+		attributes.exclude_hv = 1;
+		int counter = (int)syscall(__NR_perf_event_open, &attributes, 0, -1, -1, 0);
+		if (counter != -1)
+		{
+			ioctl(counter, PERF_EVENT_IOC_RESET, 0);
+			ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+		}
+		return counter;
+#else
+		return -1;
+#endif
+	}
+
+	//Returns the misses since Start, or -1 if the counter isn't available
+	long long Stop(int counter)
+	{
+		long long misses = -1;
+#ifdef __linux__
+		if (counter != -1)
+		{
+			ioctl(counter, PERF_EVENT_IOC_DISABLE, 0);
+			if (read(counter, &misses, sizeof(misses)) != sizeof(misses))
+				misses = -1;
+			close(counter);
+		}
+#endif
+		return misses;
+	}
+}
 #endif // !__MEASURE
\ No newline at end of file
@@ -0,0 +1,72 @@
+#ifndef __BITUTILS
+#define __BITUTILS
+
+#include <cstdint>
+#ifdef _MSC_VER
+	#include <intrin.h>
+#endif
+
+//Small portable wrappers over the compiler bit scan intrinsics
+//None of them accept 0 as a value
+namespace Bits
+{
+	inline uint32_t CountTrailingZeros(uint32_t value)
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward(&index, value);
+		return (uint32_t)index;
+#else
+		return (uint32_t)__builtin_ctz(value);
+#endif
+	}
+
+	inline uint32_t FloorLog2(uint32_t value)
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanReverse(&index, value);
+		return (uint32_t)index;
+#else
+		return 31u - (uint32_t)__builtin_clz(value);
+#endif
+	}
+
+	inline uint32_t CountTrailingZeros64(uint64_t value)
+	{
+#if defined(_MSC_VER) && defined(_M_X64)
+		unsigned long index;
+		_BitScanForward64(&index, value);
+		return (uint32_t)index;
+#elif defined(_MSC_VER)
+		return (uint32_t)value != 0
+			? CountTrailingZeros((uint32_t)value)
+			: 32u + CountTrailingZeros((uint32_t)(value >> 32));
+#else
+		return (uint32_t)__builtin_ctzll(value);
+#endif
+	}
+
+	inline uint32_t CountLeadingZeros64(uint64_t value)
+	{
+#if defined(_MSC_VER) && defined(_M_X64)
+		unsigned long index;
+		_BitScanReverse64(&index, value);
+		return 63u - (uint32_t)index;
+#elif defined(_MSC_VER)
+		return (value >> 32) != 0
+			? 31u - FloorLog2((uint32_t)(value >> 32))
+			: 63u - FloorLog2((uint32_t)value);
+#else
+		return (uint32_t)__builtin_clzll(value);
+#endif
+	}
+
+	//Smallest N so that 2^N >= value
+	inline uint32_t CeilLog2(uint32_t value)
+	{
+		return value <= 1u ? 0u : FloorLog2(value - 1u) + 1u;
+	}
+}
+
+#endif // !__BITUTILS
\ No newline at end of file
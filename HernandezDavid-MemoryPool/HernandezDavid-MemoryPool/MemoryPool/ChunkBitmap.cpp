@@ -0,0 +1,299 @@
+#include "MemoryPool.h"
+#include "ChunkBitmap.h"
+#include "BitUtils.h"
+
+#include <assert.h>
+#if defined(__AVX2__)
+	#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define CHUNKBITMAP_SSE2
+	#include <emmintrin.h>
+#endif
+
+#define BITS_PER_WORD 64u
+#define ALL_FREE_WORD UINT64_MAX
+
+ChunkBitmap::ChunkBitmap()
+	: m_chunkBits()
+	, m_wordSummary()
+	, m_topSummary()
+	, m_chunkCount(0u)
+	, m_freeChunks(0u)
+{}
+
+void ChunkBitmap::Init(uint32_t chunkCount)
+{
+	m_chunkCount = chunkCount;
+	m_freeChunks = 0u;
+
+	const uint32_t chunkWords = (chunkCount + BITS_PER_WORD - 1) / BITS_PER_WORD;
+	const uint32_t summaryWords = (chunkWords + BITS_PER_WORD - 1) / BITS_PER_WORD;
+	const uint32_t topWords = (summaryWords + BITS_PER_WORD - 1) / BITS_PER_WORD;
+	m_chunkBits.assign(chunkWords, 0u);
+	m_wordSummary.assign(summaryWords, 0u);
+	m_topSummary.assign(topWords, 0u);
+
+	//Bits past the last chunk stay as "used" forever, so no run can go out of the pool
+	SetRange(0u, chunkCount);
+}
+
+void ChunkBitmap::Grow(uint32_t chunkCount)
+{
+	assert(chunkCount >= m_chunkCount);
+	m_chunkCount = chunkCount;
+
+	//Chunks past the old end were already kept as "used", so only new words are needed
+	const uint32_t chunkWords = (chunkCount + BITS_PER_WORD - 1) / BITS_PER_WORD;
+	const uint32_t summaryWords = (chunkWords + BITS_PER_WORD - 1) / BITS_PER_WORD;
+	const uint32_t topWords = (summaryWords + BITS_PER_WORD - 1) / BITS_PER_WORD;
+	m_chunkBits.resize(chunkWords, 0u);
+	m_wordSummary.resize(summaryWords, 0u);
+	m_topSummary.resize(topWords, 0u);
+}
+
+uint32_t ChunkBitmap::Claim(uint32_t chunks)
+{
+	const uint32_t firstChunk = (chunks == 1u ? FindFreeChunkFrom(0u) : FindRun(chunks));
+	if (firstChunk != INVALID_CHUNK_ID)
+		ClearRange(firstChunk, chunks);
+	return firstChunk;
+}
+
+bool ChunkBitmap::ClaimAt(uint32_t firstChunk, uint32_t chunks)
+{
+	if (firstChunk >= m_chunkCount || chunks > m_chunkCount - firstChunk)
+		return false;
+	uint32_t runChunks = 0u;
+	if (FindFreeRunFrom(firstChunk, runChunks) != firstChunk || runChunks < chunks)
+		return false;
+	ClearRange(firstChunk, chunks);
+	return true;
+}
+
+uint32_t ChunkBitmap::ClaimRun(uint32_t chunks, uint32_t maxChunks, uint32_t& claimedChunks)
+{
+	assert(chunks != 0u && maxChunks >= chunks);
+	//A run for all of them if there is one, otherwise the first one fitting at least *chunks*
+	uint32_t firstChunk = (maxChunks > chunks ? FindRun(maxChunks) : INVALID_CHUNK_ID);
+	if (firstChunk == INVALID_CHUNK_ID)
+		firstChunk = (chunks == 1u ? FindFreeChunkFrom(0u) : FindRun(chunks));
+	if (firstChunk == INVALID_CHUNK_ID)
+		return INVALID_CHUNK_ID;
+	uint32_t runChunks = 0u;
+	FindFreeRunFrom(firstChunk, runChunks);
+	claimedChunks = (runChunks < maxChunks ? runChunks : maxChunks) / chunks * chunks;
+	ClearRange(firstChunk, claimedChunks);
+	return firstChunk;
+}
+
+void ChunkBitmap::Release(uint32_t firstChunk, uint32_t chunks)
+{
+	assert(firstChunk + chunks <= m_chunkCount);
+	SetRange(firstChunk, chunks);
+}
+
+uint32_t ChunkBitmap::FindFreeChunkFrom(uint32_t chunkN) const
+{
+	uint32_t wordN = chunkN / BITS_PER_WORD;
+	if (wordN >= m_chunkBits.size())
+		return INVALID_CHUNK_ID;
+
+	uint64_t word = m_chunkBits[wordN] & (ALL_FREE_WORD << (chunkN % BITS_PER_WORD));
+	if (word != 0)
+		return wordN * BITS_PER_WORD + Bits::CountTrailingZeros64(word);
+
+	//Nothing left in this word, let the summaries find the next word with any free chunk
+	wordN++;
+	uint32_t summaryN = wordN / BITS_PER_WORD;
+	if (summaryN >= m_wordSummary.size())
+		return INVALID_CHUNK_ID;
+
+	uint64_t summary = m_wordSummary[summaryN] & (ALL_FREE_WORD << (wordN % BITS_PER_WORD));
+	if (summary == 0)
+	{
+		summaryN++;
+		uint32_t topN = summaryN / BITS_PER_WORD;
+		if (topN >= m_topSummary.size())
+			return INVALID_CHUNK_ID;
+
+		uint64_t top = m_topSummary[topN] & (ALL_FREE_WORD << (summaryN % BITS_PER_WORD));
+		while (top == 0)
+		{
+			if (++topN >= m_topSummary.size())
+				return INVALID_CHUNK_ID;
+			top = m_topSummary[topN];
+		}
+		summaryN = topN * BITS_PER_WORD + Bits::CountTrailingZeros64(top);
+		summary = m_wordSummary[summaryN];
+	}
+
+	wordN = summaryN * BITS_PER_WORD + Bits::CountTrailingZeros64(summary);
+	return wordN * BITS_PER_WORD + Bits::CountTrailingZeros64(m_chunkBits[wordN]);
+}
+
+uint32_t ChunkBitmap::FindFreeRunFrom(uint32_t chunkN, uint32_t& runChunks) const
+{
+	const uint32_t runStart = FindFreeChunkFrom(chunkN);
+	if (runStart == INVALID_CHUNK_ID)
+		return INVALID_CHUNK_ID;
+
+	//Free chunks from the start of the run until the end of its word
+	uint32_t wordN = runStart / BITS_PER_WORD;
+	const uint32_t chunksToWordEnd = BITS_PER_WORD - runStart % BITS_PER_WORD;
+	const uint64_t firstWord = m_chunkBits[wordN] >> (runStart % BITS_PER_WORD);
+	runChunks = (~firstWord != 0 ? Bits::CountTrailingZeros64(~firstWord) : BITS_PER_WORD);
+	if (runChunks < chunksToWordEnd)
+		return runStart;
+	runChunks = chunksToWordEnd;
+
+	//Whole free words, then the free chunks at the start of the first word that isn't
+	wordN++;
+	const uint32_t freeWords = CountFreeWordsFrom(wordN, (uint32_t)m_chunkBits.size() - wordN);
+	runChunks += freeWords * BITS_PER_WORD;
+	wordN += freeWords;
+	if (wordN < m_chunkBits.size())
+		runChunks += Bits::CountTrailingZeros64(~m_chunkBits[wordN]);
+	return runStart;
+}
+
+uint32_t ChunkBitmap::FindRun(uint32_t chunks) const
+{
+	const uint32_t chunkWords = (uint32_t)m_chunkBits.size();
+	//Free chunks at the end of the previous word, which may be the start of a run
+	uint32_t carriedChunks = 0u;
+
+	uint32_t firstFree = FindFreeChunkFrom(0u);
+	uint32_t wordN = (firstFree == INVALID_CHUNK_ID ? chunkWords : firstFree / BITS_PER_WORD);
+	while (wordN < chunkWords)
+	{
+		//Long runs go over whole free words, which can be checked several at a time
+		if (carriedChunks != 0 && chunks - carriedChunks >= BITS_PER_WORD)
+		{
+			const uint32_t freeWords = CountFreeWordsFrom(wordN, (chunks - carriedChunks) / BITS_PER_WORD);
+			carriedChunks += freeWords * BITS_PER_WORD;
+			wordN += freeWords;
+			if (carriedChunks >= chunks)
+				return wordN * BITS_PER_WORD - carriedChunks;
+			if (wordN >= chunkWords)
+				break;
+		}
+
+		const uint64_t word = m_chunkBits[wordN];
+		if (carriedChunks != 0)
+		{
+			const uint32_t leadingFree = (word == ALL_FREE_WORD ? BITS_PER_WORD : Bits::CountTrailingZeros64(~word));
+			if (carriedChunks + leadingFree >= chunks)
+				return wordN * BITS_PER_WORD - carriedChunks;
+			if (leadingFree != BITS_PER_WORD)
+				carriedChunks = 0u;
+		}
+
+		if (chunks <= BITS_PER_WORD)
+		{
+			//Leave a bit set only where *chunks* free chunks start inside this word
+			uint64_t runStarts = word;
+			for (uint32_t runLength = 1u; runLength < chunks;)
+			{
+				const uint32_t shift = (runLength < chunks - runLength ? runLength : chunks - runLength);
+				runStarts &= runStarts >> shift;
+				runLength += shift;
+			}
+			if (runStarts != 0)
+				return wordN * BITS_PER_WORD + Bits::CountTrailingZeros64(runStarts);
+		}
+
+		//A fully free word keeps the run going, otherwise only the free chunks at its end are carried
+		if (word == ALL_FREE_WORD)
+			carriedChunks += BITS_PER_WORD;
+		else
+			carriedChunks = Bits::CountLeadingZeros64(~word);
+
+		if (carriedChunks != 0)
+			wordN++;
+		else
+		{
+			const uint32_t nextFree = FindFreeChunkFrom((wordN + 1) * BITS_PER_WORD);
+			wordN = (nextFree == INVALID_CHUNK_ID ? chunkWords : nextFree / BITS_PER_WORD);
+		}
+	}
+	return INVALID_CHUNK_ID;
+}
+
+uint32_t ChunkBitmap::CountFreeWordsFrom(uint32_t wordN, uint32_t maxWords) const
+{
+	if (maxWords > m_chunkBits.size() - wordN)
+		maxWords = (uint32_t)m_chunkBits.size() - wordN;
+
+	const uint64_t* words = m_chunkBits.data() + wordN;
+	uint32_t count = 0u;
+#if defined(__AVX2__)
+	const __m256i allFree = _mm256_set1_epi64x(-1);
+	while (count + 4u <= maxWords)
+	{
+		const __m256i block = _mm256_loadu_si256((const __m256i*)(words + count));
+		if (_mm256_movemask_epi8(_mm256_cmpeq_epi64(block, allFree)) != -1)
+			break;
+		count += 4u;
+	}
+#elif defined(CHUNKBITMAP_SSE2)
+	const __m128i allFree = _mm_set1_epi32(-1);
+	while (count + 2u <= maxWords)
+	{
+		const __m128i block = _mm_loadu_si128((const __m128i*)(words + count));
+		if (_mm_movemask_epi8(_mm_cmpeq_epi32(block, allFree)) != 0xFFFF)
+			break;
+		count += 2u;
+	}
+#endif
+	while (count < maxWords && words[count] == ALL_FREE_WORD)
+		count++;
+	return count;
+}
+
+void ChunkBitmap::SetRange(uint32_t firstChunk, uint32_t chunks)
+{
+	const uint32_t lastChunk = firstChunk + chunks;
+	for (uint32_t chunkN = firstChunk; chunkN < lastChunk;)
+	{
+		const uint32_t wordN = chunkN / BITS_PER_WORD;
+		const uint32_t bit = chunkN % BITS_PER_WORD;
+		const uint32_t bitCount = (lastChunk - chunkN < BITS_PER_WORD - bit ? lastChunk - chunkN : BITS_PER_WORD - bit);
+		const uint64_t mask = (bitCount == BITS_PER_WORD ? ALL_FREE_WORD : ((1ull << bitCount) - 1u) << bit);
+
+		assert((m_chunkBits[wordN] & mask) == 0 && "Releasing chunks that were already free");
+		if (m_chunkBits[wordN] == 0)
+		{
+			const uint32_t summaryN = wordN / BITS_PER_WORD;
+			if (m_wordSummary[summaryN] == 0)
+				m_topSummary[summaryN / BITS_PER_WORD] |= 1ull << (summaryN % BITS_PER_WORD);
+			m_wordSummary[summaryN] |= 1ull << (wordN % BITS_PER_WORD);
+		}
+		m_chunkBits[wordN] |= mask;
+		chunkN += bitCount;
+	}
+	m_freeChunks += chunks;
+}
+
+void ChunkBitmap::ClearRange(uint32_t firstChunk, uint32_t chunks)
+{
+	const uint32_t lastChunk = firstChunk + chunks;
+	for (uint32_t chunkN = firstChunk; chunkN < lastChunk;)
+	{
+		const uint32_t wordN = chunkN / BITS_PER_WORD;
+		const uint32_t bit = chunkN % BITS_PER_WORD;
+		const uint32_t bitCount = (lastChunk - chunkN < BITS_PER_WORD - bit ? lastChunk - chunkN : BITS_PER_WORD - bit);
+		const uint64_t mask = (bitCount == BITS_PER_WORD ? ALL_FREE_WORD : ((1ull << bitCount) - 1u) << bit);
+
+		assert((m_chunkBits[wordN] & mask) == mask && "Claiming chunks that were not free");
+		m_chunkBits[wordN] &= ~mask;
+		if (m_chunkBits[wordN] == 0)
+		{
+			const uint32_t summaryN = wordN / BITS_PER_WORD;
+			m_wordSummary[summaryN] &= ~(1ull << (wordN % BITS_PER_WORD));
+			if (m_wordSummary[summaryN] == 0)
+				m_topSummary[summaryN / BITS_PER_WORD] &= ~(1ull << (summaryN % BITS_PER_WORD));
+		}
+		chunkN += bitCount;
+	}
+	m_freeChunks -= chunks;
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+#ifndef __CHUNKBITMAP
+#define __CHUNKBITMAP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+Keeps track of which chunks of a pool are free using one bit per chunk (1 = free)
+Two summary levels sit on top of the chunk bits:
+- Every bit of the first summary level is set if the matching chunk word has any free chunk
+- Every bit of the second summary level is set if the matching first level word has any bit set
+This allows skipping fully used parts of the pool without looking at them
+*/
+class ChunkBitmap
+{
+public:
+	ChunkBitmap(ChunkBitmap&) = delete;
+	ChunkBitmap();
+
+	//Must be called before using the bitmap
+	//All chunks start as free
+	void Init(uint32_t chunkCount);
+	//Add chunks at the end, up to *chunkCount*. They start as used
+	void Grow(uint32_t chunkCount);
+
+	//Find *chunks* contiguous free chunks and mark them as used
+	//Returns the first of them, or INVALID_CHUNK_ID if there is no run long enough
+	uint32_t Claim(uint32_t chunks);
+	//Mark *chunks* chunks, starting on *firstChunk*, as used if all of them are free. Returns whether they were
+	bool ClaimAt(uint32_t firstChunk, uint32_t chunks);
+	//Find the first run of *maxChunks* free chunks, or else the first one of at least *chunks*
+	//Mark as used as much of it as fits in *maxChunks*, in multiples of *chunks*
+	//Returns its first chunk and writes the chunks claimed on *claimedChunks*, or returns INVALID_CHUNK_ID if there is no run long enough
+	uint32_t ClaimRun(uint32_t chunks, uint32_t maxChunks, uint32_t& claimedChunks);
+	//Mark *chunks* chunks, starting on *firstChunk*, as free
+	void Release(uint32_t firstChunk, uint32_t chunks);
+
+	//Find the first run of free chunks starting at or after *chunkN*, as long as it goes
+	//Returns its first chunk and writes its length on *runChunks*, or returns INVALID_CHUNK_ID if there are no free chunks left
+	uint32_t FindFreeRunFrom(uint32_t chunkN, uint32_t& runChunks) const;
+
+	inline uint32_t GetFreeChunks() const { return m_freeChunks; }
+	//Bytes used by the bitmap and its summaries
+	inline size_t GetMetadataSize() const { return (m_chunkBits.size() + m_wordSummary.size() + m_topSummary.size()) * sizeof(uint64_t); }
+
+private:
+	//Find the first free chunk at or after *chunkN*. Returns INVALID_CHUNK_ID if there is none
+	uint32_t FindFreeChunkFrom(uint32_t chunkN) const;
+	//Find the first run of *chunks* free chunks
+	uint32_t FindRun(uint32_t chunks) const;
+	//Amount of words, starting on *wordN*, that have all their chunks free
+	uint32_t CountFreeWordsFrom(uint32_t wordN, uint32_t maxWords) const;
+
+	void SetRange(uint32_t firstChunk, uint32_t chunks);
+	void ClearRange(uint32_t firstChunk, uint32_t chunks);
+
+private:
+	std::vector<uint64_t> m_chunkBits;
+	std::vector<uint64_t> m_wordSummary;
+	std::vector<uint64_t> m_topSummary;
+
+	uint32_t m_chunkCount;
+	uint32_t m_freeChunks;
+};
+
+#endif // !__CHUNKBITMAP
\ No newline at end of file
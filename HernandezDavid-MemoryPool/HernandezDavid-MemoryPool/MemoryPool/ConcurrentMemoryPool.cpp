@@ -0,0 +1,225 @@
+#include "ConcurrentMemoryPool.h"
+#include "MemoryChunk.h"
+#include "BitUtils.h"
+#include "VirtualMemory.h"
+
+#include <algorithm>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <assert.h>
+
+ConcurrentMemoryPool::ConcurrentMemoryPool(uint32_t chunkSizeInBytes, uint32_t chunkCount)
+	: m_firstChunk(nullptr)
+	, m_nextFreeSlot(nullptr)
+	, m_carvedChunks(0u)
+	, m_usedChunks(0u)
+	, m_merges(0u)
+	, m_merging(false)
+	, m_chunkCount(chunkCount)
+	, m_chunkSize(chunkSizeInBytes)
+	, m_freeListCount(0u)
+	, m_pool(nullptr)
+{
+	assert(chunkSizeInBytes != 0 && chunkCount != 0 && chunkCount <= MAX_CHUNK_COUNT);
+	for (std::atomic<uint64_t>& freeList : m_freeLists)
+		freeList.store(MakeHead(0u, INVALID_CHUNK_ID), std::memory_order_relaxed);
+	//Tagged heads need 64 bit CAS, or the pool would be using locks behind the scenes
+	assert(m_freeLists[0].is_lock_free() && "64 bit atomics aren't lock-free on this platform");
+	m_freeListCount = Bits::FloorLog2(chunkCount) + 1u;
+
+	//Starts on a cache line like MemoryPool metadata, so the first headers don't share one with other heap data
+	m_firstChunk = NewChunkMetadata(m_chunkCount);
+	m_nextFreeSlot = new std::atomic<uint32_t>[m_chunkCount];
+	m_pool = (byte*)VirtualMemory::Reserve(VirtualMemory::RoundToPages((size_t)m_chunkSize * m_chunkCount));
+	assert(m_pool != nullptr && "Could not reserve the address space of the pool");
+	VirtualMemory::Commit(m_pool, VirtualMemory::RoundToPages((size_t)m_chunkSize * m_chunkCount));
+}
+
+ConcurrentMemoryPool::~ConcurrentMemoryPool()
+{
+	//Checking all memory has been released
+	assert(GetUsedChunks() == 0u && "ConcurrentMemoryPool destroyed with memory still in use");
+	VirtualMemory::Release(m_pool, VirtualMemory::RoundToPages((size_t)m_chunkSize * m_chunkCount));
+	delete[] m_nextFreeSlot;
+	DeleteChunkMetadata(m_firstChunk);
+}
+
+PoolPtr<byte> ConcurrentMemoryPool::Alloc(uint32_t bytes)
+{
+	const uint32_t chunks = (bytes != 0u ? (bytes - 1) / m_chunkSize + 1 : 1u);
+	if (chunks > m_chunkCount)
+		return PoolPtr<byte>();
+
+	//Every slot in the list of the next power of two fits, so the first one found is taken
+	const uint32_t firstFittingList = Bits::CeilLog2(chunks);
+	uint32_t slotStart = INVALID_CHUNK_ID;
+	uint32_t slotChunks = chunks;
+	while (slotStart == INVALID_CHUNK_ID)
+	{
+		for (uint32_t list = firstFittingList; list < m_freeListCount && slotStart == INVALID_CHUNK_ID; ++list)
+			slotStart = Pop(list);
+		if (slotStart != INVALID_CHUNK_ID)
+			slotChunks = m_firstChunk[slotStart].GetSlotChunks();
+		else
+			slotStart = Carve(chunks);
+
+		if (slotStart == INVALID_CHUNK_ID && MergeFreeSlots() == false)
+			return PoolPtr<byte>();
+	}
+
+	//What isn't needed goes back as a new free slot
+	if (slotChunks > chunks)
+		Push(slotStart + chunks, slotChunks - chunks);
+	m_firstChunk[slotStart].SetSlotHead(chunks, true);
+	m_usedChunks.fetch_add(chunks, std::memory_order_relaxed);
+
+	MemoryChunk* headChunk = m_firstChunk + slotStart;
+	byte* data = m_pool + (size_t)slotStart * m_chunkSize;
+#ifdef _DEBUG
+	return PoolPtr<byte>(headChunk, data, bytes);
+#else
+	return PoolPtr<byte>(headChunk, data);
+#endif
+}
+
+void ConcurrentMemoryPool::Free(MemoryChunk* chunk)
+{
+	assert(chunk >= m_firstChunk && chunk < m_firstChunk + m_chunkCount && chunk->IsHeader()
+		&& "Attempted to free memory not allocated in this pool");
+	const uint32_t chunks = chunk->GetSlotChunks();
+	m_usedChunks.fetch_sub(chunks, std::memory_order_relaxed);
+	Push((uint32_t)(chunk - m_firstChunk), chunks);
+}
+
+uint32_t ConcurrentMemoryPool::GetChunkAlignment() const
+{
+	//The pool starts on a page, so chunks are aligned on the lowest bit of their size up to a page
+	const uint32_t alignment = m_chunkSize & (~m_chunkSize + 1u);
+	return (alignment < VirtualMemory::GetPageSize() ? alignment : (uint32_t)VirtualMemory::GetPageSize());
+}
+
+bool ConcurrentMemoryPool::CheckIntegrity() const
+{
+	const uint32_t carvedChunks = m_carvedChunks.load(std::memory_order_acquire);
+	if (carvedChunks > m_chunkCount)
+		return false;
+
+	std::vector<bool> freeChunks(m_chunkCount, false);
+	uint64_t freeChunkCount = m_chunkCount - carvedChunks;
+	for (uint32_t list = 0u; list < CONCURRENT_POOL_FREE_LISTS; ++list)
+	{
+		for (uint32_t slot = GetHeadSlot(m_freeLists[list].load(std::memory_order_acquire)); slot != INVALID_CHUNK_ID;
+			slot = m_nextFreeSlot[slot].load(std::memory_order_relaxed))
+		{
+			//Every free slot must be in the list of its size, inside the carved part of the pool, and not overlap any other
+			const MemoryChunk& head = m_firstChunk[slot];
+			const uint32_t chunks = head.GetSlotChunks();
+			if (slot >= carvedChunks || head.IsUsed() || chunks == 0u || chunks > carvedChunks - slot
+				|| Bits::FloorLog2(chunks) != list)
+				return false;
+			for (uint32_t chunkN = slot; chunkN < slot + chunks; ++chunkN)
+			{
+				if (freeChunks[chunkN])
+					return false;
+				freeChunks[chunkN] = true;
+			}
+			freeChunkCount += chunks;
+		}
+	}
+	return freeChunkCount + GetUsedChunks() == m_chunkCount;
+}
+
+void ConcurrentMemoryPool::Push(uint32_t slotStart, uint32_t chunks)
+{
+	m_firstChunk[slotStart].SetSlotHead(chunks, false);
+	std::atomic<uint64_t>& freeList = m_freeLists[Bits::FloorLog2(chunks)];
+	uint64_t head = freeList.load(std::memory_order_relaxed);
+	do
+	{
+		m_nextFreeSlot[slotStart].store(GetHeadSlot(head), std::memory_order_relaxed);
+	} while (freeList.compare_exchange_weak(head, MakeHead(GetHeadTag(head) + 1u, slotStart),
+		std::memory_order_release, std::memory_order_relaxed) == false);
+}
+
+uint32_t ConcurrentMemoryPool::Pop(uint32_t list)
+{
+	std::atomic<uint64_t>& freeList = m_freeLists[list];
+	uint64_t head = freeList.load(std::memory_order_acquire);
+	while (GetHeadSlot(head) != INVALID_CHUNK_ID)
+	{
+		//If another thread pops this slot first, the tag changes and the CAS fails even if the slot is back on top
+		const uint32_t next = m_nextFreeSlot[GetHeadSlot(head)].load(std::memory_order_relaxed);
+		if (freeList.compare_exchange_weak(head, MakeHead(GetHeadTag(head) + 1u, next),
+			std::memory_order_acquire, std::memory_order_acquire))
+			return GetHeadSlot(head);
+	}
+	return INVALID_CHUNK_ID;
+}
+
+uint32_t ConcurrentMemoryPool::Carve(uint32_t chunks)
+{
+	uint32_t carvedChunks = m_carvedChunks.load(std::memory_order_acquire);
+	do
+	{
+		if (chunks > m_chunkCount - carvedChunks)
+			return INVALID_CHUNK_ID;
+	} while (m_carvedChunks.compare_exchange_weak(carvedChunks, carvedChunks + chunks,
+		std::memory_order_acq_rel, std::memory_order_acquire) == false);
+	return carvedChunks;
+}
+
+bool ConcurrentMemoryPool::MergeFreeSlots()
+{
+	const uint32_t merges = m_merges.load(std::memory_order_acquire);
+	if (m_merging.exchange(true, std::memory_order_acquire))
+	{
+		//Someone else is merging: wait for it and try again with what it leaves
+		//That merge may have been counted before *merges* was read, so it's also over once nobody is merging
+		while (m_merging.load(std::memory_order_acquire) && m_merges.load(std::memory_order_acquire) == merges)
+			std::this_thread::yield();
+		return true;
+	}
+
+	//Emptying all lists at once. Slots freed meanwhile land in the emptied lists and wait for the next merge
+	std::vector<std::pair<uint32_t, uint32_t>> slots;
+	for (uint32_t list = 0u; list < m_freeListCount; ++list)
+	{
+		uint64_t head = m_freeLists[list].load(std::memory_order_acquire);
+		while (m_freeLists[list].compare_exchange_weak(head, MakeHead(GetHeadTag(head) + 1u, INVALID_CHUNK_ID),
+			std::memory_order_acq_rel, std::memory_order_acquire) == false);
+		for (uint32_t slot = GetHeadSlot(head); slot != INVALID_CHUNK_ID; slot = m_nextFreeSlot[slot].load(std::memory_order_relaxed))
+			slots.push_back(std::make_pair(slot, m_firstChunk[slot].GetSlotChunks()));
+	}
+
+	bool merged = false;
+	if (slots.empty() == false)
+	{
+		std::sort(slots.begin(), slots.end());
+		uint32_t mergedSlots = 0u;
+		for (uint32_t n = 1u; n < slots.size(); ++n)
+		{
+			std::pair<uint32_t, uint32_t>& last = slots[mergedSlots];
+			if (last.first + last.second == slots[n].first)
+				last.second += slots[n].second;
+			else
+				slots[++mergedSlots] = slots[n];
+		}
+		merged = (mergedSlots + 1u != slots.size());
+		slots.resize(mergedSlots + 1u);
+
+		//A free slot right before the never used chunks is given back to them
+		uint32_t carvedChunks = slots.back().first + slots.back().second;
+		if (m_carvedChunks.compare_exchange_strong(carvedChunks, slots.back().first, std::memory_order_acq_rel))
+		{
+			slots.pop_back();
+			merged = true;
+		}
+		for (const std::pair<uint32_t, uint32_t>& slot : slots)
+			Push(slot.first, slot.second);
+	}
+
+	m_merges.fetch_add(1u, std::memory_order_release);
+	m_merging.store(false, std::memory_order_release);
+	return merged;
+}
\ No newline at end of file
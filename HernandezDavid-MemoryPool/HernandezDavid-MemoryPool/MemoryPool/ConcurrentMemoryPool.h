@@ -0,0 +1,120 @@
+#ifndef __CONCURRENTMEMORYPOOL
+#define __CONCURRENTMEMORYPOOL
+
+#include "MemoryPool.h"
+
+#include <atomic>
+#include <cstdint>
+
+//Free slots of 2^n to 2^(n+1)-1 chunks are kept in list n
+#define CONCURRENT_POOL_FREE_LISTS 32u
+
+/*
+Memory pool that can be used from any amount of threads at once, without locks
+- Chunks that were never used are carved from the end of the used part of the pool with a CAS
+- Free slots are kept in lock-free stacks (one per power of two range of sizes), linked by chunk index
+	Stack heads carry a tag that changes on every push and pop, so a stale head can't be swapped back in (ABA)
+- Allocations take a slot from the first stack whose slots always fit, and give back what they don't use
+- Free only pushes the slot to its stack. Neighbours are not merged on the spot
+Merging is deferred until an allocation finds nothing: then a single thread takes all free slots,
+merges the contiguous ones and puts them back. Threads allocating while it does wait for it to finish,
+so that is the only point where a thread may wait on another one
+MemoryPool stays as it is, so single threaded code doesn't pay for any atomic operation
+*/
+class ConcurrentMemoryPool
+{
+public:
+	ConcurrentMemoryPool(ConcurrentMemoryPool&) = delete;
+	ConcurrentMemoryPool(uint32_t chunkSizeInBytes, uint32_t chunkCount);
+	~ConcurrentMemoryPool();
+
+	//Allocate *bytes* space in the pool of uninitialized memory
+	//Returns an invalid PoolPtr if there is no slot big enough, even after merging
+	PoolPtr<byte> Alloc(uint32_t bytes);
+
+	//Allocate enough space for *amount* value initialized instances of *type* class
+	//There is no aligned allocation, so types aligned on more than GetChunkAlignment() get an invalid PoolPtr
+	template<class type>
+	PoolPtr<type> Alloc(uint32_t amount = 1);
+
+	//Release previously allocated memory. It can be released from any thread
+	template<class type>
+	void Free(PoolPtr<type>& toFree);
+
+	inline uint32_t GetChunkSize() const { return m_chunkSize; }
+	inline uint32_t GetChunkCount() const { return m_chunkCount; }
+	//Alignment every allocation is guaranteed to have
+	uint32_t GetChunkAlignment() const;
+	//Chunks currently allocated. Exact only while no other thread is allocating or freeing
+	inline uint32_t GetUsedChunks() const { return m_usedChunks.load(std::memory_order_relaxed); }
+
+	//Checks free slots don't overlap, stay inside the pool and, together with the used chunks, add up to the whole pool
+	//Must only be called while no other thread uses the pool
+	bool CheckIntegrity() const;
+
+private:
+	void Free(MemoryChunk* chunk);
+
+	void Push(uint32_t slotStart, uint32_t chunks);
+	//Returns INVALID_CHUNK_ID if the list is empty
+	uint32_t Pop(uint32_t list);
+	//Take *chunks* chunks that were never used. Returns INVALID_CHUNK_ID if there aren't enough left
+	uint32_t Carve(uint32_t chunks);
+	//Merge all free slots that are contiguous. Returns false if no allocation can succeed after it
+	bool MergeFreeSlots();
+
+	static inline uint64_t MakeHead(uint32_t tag, uint32_t slotStart) { return ((uint64_t)tag << 32) | slotStart; }
+	static inline uint32_t GetHeadTag(uint64_t head) { return (uint32_t)(head >> 32); }
+	static inline uint32_t GetHeadSlot(uint64_t head) { return (uint32_t)head; }
+
+private:
+	//Only the first chunk of every slot is meaningful: its size and used flag
+	//Slots are only touched by the thread owning them (an allocation, or a slot just popped), so these aren't atomic
+	MemoryChunk* m_firstChunk;
+	//Next free slot in the same stack, per chunk
+	std::atomic<uint32_t>* m_nextFreeSlot;
+	std::atomic<uint64_t> m_freeLists[CONCURRENT_POOL_FREE_LISTS];
+
+	//First chunk that was never used
+	std::atomic<uint32_t> m_carvedChunks;
+	std::atomic<uint32_t> m_usedChunks;
+	//Bumped every time a merge finishes, so threads that waited for one know it's done
+	std::atomic<uint32_t> m_merges;
+	std::atomic<bool> m_merging;
+
+	uint32_t m_chunkCount;
+	uint32_t m_chunkSize;
+	//Lists past this one can't hold any slot, since they'd be bigger than the pool
+	uint32_t m_freeListCount;
+	byte* m_pool;
+};
+
+template<class type>
+inline PoolPtr<type> ConcurrentMemoryPool::Alloc(uint32_t amount)
+{
+	//The size would be truncated to 32 bits, or the chunks aren't aligned enough for *type*
+	if ((uint64_t)sizeof(type) * amount > UINT32_MAX || alignof(type) > GetChunkAlignment())
+		return PoolPtr<type>(nullptr);
+
+	PoolPtr<byte> allocation = Alloc(sizeof(type) * amount);
+#ifdef _DEBUG
+	PoolPtr<type> ret(allocation.m_chunk, allocation.m_data, amount);
+#else
+	PoolPtr<type> ret(allocation.m_chunk, allocation.m_data);
+#endif
+	if (ret.IsValid())
+		MemoryPool::ValueInitialize(ret.GetData(), amount);
+	return ret;
+}
+
+template<class type>
+inline void ConcurrentMemoryPool::Free(PoolPtr<type>& toFree)
+{
+	if (toFree.IsValid())
+		Free(toFree.m_chunk);
+	//Mark as invalid the released PoolPtr
+	toFree.m_chunk = nullptr;
+	toFree.m_data = nullptr;
+}
+
+#endif // !__CONCURRENTMEMORYPOOL
\ No newline at end of file
@@ -0,0 +1,21 @@
+#include "FrameArena.h"
+
+#include <assert.h>
+
+FrameArena::FrameArena(MemoryPool& pool, uint32_t bytes)
+	: m_pool(pool)
+	, m_block(nullptr)
+	, m_capacity(bytes)
+	, m_offset(0u)
+{
+	m_block = (byte*)m_pool.Allocate(bytes);
+	assert(m_block != nullptr && "The pool has no room for the arena block");
+	if (m_block == nullptr)
+		m_capacity = 0u;
+}
+
+FrameArena::~FrameArena()
+{
+	if (m_block != nullptr)
+		m_pool.Deallocate(m_block);
+}
\ No newline at end of file
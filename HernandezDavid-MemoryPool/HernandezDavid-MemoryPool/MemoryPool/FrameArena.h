@@ -0,0 +1,116 @@
+#ifndef __FRAMEARENA
+#define __FRAMEARENA
+
+#include "MemoryPool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <assert.h>
+
+/*
+Linear allocator over a single block taken from a MemoryPool, for memory that dies all at once, like the allocations of a tick
+	FrameArena arena(pool, 64 * 1024);
+	Particle* particles = arena.NewArray<Particle>(count);
+	arena.Reset();		//At the end of the tick
+- Allocating just moves an offset forward. Nothing is freed on its own
+- Reset gives back everything in O(1), and ArenaScope gives back what was allocated while it lived
+- Destructors are never called, so only trivially destructible types can be built in it
+The pool must outlive the arena. Arenas aren't thread safe
+*/
+class FrameArena
+{
+public:
+	FrameArena(FrameArena&) = delete;
+	//Takes a block of *bytes* from *pool*, which has to have room for it
+	FrameArena(MemoryPool& pool, uint32_t bytes);
+	~FrameArena();
+
+	//Allocate *bytes* of uninitialized memory aligned to *alignment*, a power of two
+	//Returns nullptr if the block has no room left
+	inline void* Allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+
+	//Allocate and build a *type*, forwarding *args* to its constructor. Returns nullptr if there is no room
+	template<class type, class... Args>
+	type* New(Args&&... args);
+	//Allocate *amount* value initialized instances of *type*. Returns nullptr if there is no room
+	template<class type>
+	type* NewArray(uint32_t amount);
+
+	//Position of the arena, to roll back to it later
+	inline size_t GetMarker() const { return m_offset; }
+	//Give back everything allocated since *marker* was taken
+	inline void Rollback(size_t marker);
+	//Give back everything allocated
+	inline void Reset() { Rollback(0u); }
+
+	inline size_t GetCapacity() const { return m_capacity; }
+	inline size_t GetUsedBytes() const { return m_offset; }
+
+private:
+	MemoryPool& m_pool;
+	byte* m_block;
+	size_t m_capacity;
+	size_t m_offset;
+};
+
+/*
+Rolls its arena back to where it was when the scope was created once it goes away
+	{
+		ArenaScope scope(arena);
+		void* scratch = arena.Allocate(1024);
+	}	//scratch is given back here
+Scopes can be nested, but have to be destroyed in the reverse order they were created
+*/
+class ArenaScope
+{
+public:
+	ArenaScope(ArenaScope&) = delete;
+	explicit ArenaScope(FrameArena& arena) : m_arena(arena), m_marker(arena.GetMarker()) {}
+	~ArenaScope() { m_arena.Rollback(m_marker); }
+
+private:
+	FrameArena& m_arena;
+	size_t m_marker;
+};
+
+inline void* FrameArena::Allocate(size_t bytes, size_t alignment)
+{
+	assert(alignment != 0 && (alignment & (alignment - 1)) == 0 && "Alignment must be a power of two");
+	//Aligning the address itself, since the block is only aligned on the chunk alignment of the pool
+	const uintptr_t current = (uintptr_t)(m_block + m_offset);
+	const size_t start = m_offset + (size_t)((0u - current) & (alignment - 1));
+	if (start > m_capacity || bytes > m_capacity - start)
+		return nullptr;
+	m_offset = start + bytes;
+	return m_block + start;
+}
+
+template<class type, class... Args>
+inline type* FrameArena::New(Args&&... args)
+{
+	static_assert(std::is_trivially_destructible<type>::value, "FrameArena never calls destructors");
+	void* memory = Allocate(sizeof(type), alignof(type));
+	return (memory ? new(memory) type(std::forward<Args>(args)...) : nullptr);
+}
+
+template<class type>
+inline type* FrameArena::NewArray(uint32_t amount)
+{
+	static_assert(std::is_trivially_destructible<type>::value, "FrameArena never calls destructors");
+	type* instances = (type*)Allocate(sizeof(type) * (size_t)amount, alignof(type));
+	if (instances != nullptr)
+		for (uint32_t n = 0; n < amount; ++n)
+			new(instances + n) type();
+	return instances;
+}
+
+inline void FrameArena::Rollback(size_t marker)
+{
+	assert(marker <= m_offset && "Rolled back to a marker taken after a later rollback");
+	m_offset = marker;
+}
+
+#endif // !__FRAMEARENA
\ No newline at end of file
@@ -2,30 +2,64 @@
 #define __MEMORYCHUNK
 
 #include <cstdint>
+#include <memory>
+#include <new>
 
+//Set on the first and last chunks of a used slot
+#define CHUNK_USED_FLAG 0x80000000u
+//Set on the last chunk of a slot bigger than one chunk
+#define CHUNK_TAIL_FLAG 0x40000000u
+#define CHUNK_VALUE_MASK 0x3FFFFFFFu
+//Chunk indices have to fit in the value bits
+#define MAX_CHUNK_COUNT CHUNK_VALUE_MASK
+//Chunk metadata starts on a cache line, so a line never holds the end of something else
+#define METADATA_ALIGNMENT 64u
+
+/*
+Metadata of a single chunk, packed in 32 bits
+The data pointer and the chunk index are not stored, since both are derived from the chunk address
+Only the first and last chunks of a slot hold meaningful values:
+- First chunk: amount of chunks in the slot (avaliable ones if free, used ones if used)
+- Last chunk:  index of the first chunk of the slot, with the tail flag (boundary tag)
+	Single chunk slots only keep the first chunk value
+Both carry the used flag when the slot is used
+Anything else the engines need lives in their own parallel arrays, indexed by chunk
+*/
 struct MemoryChunk
 {
 	MemoryChunk(MemoryChunk&) = delete;
-	MemoryChunk(void* data = nullptr)
-		: m_data(data)
-		, m_avaliableContiguousChunks(0u)
-		, m_usedChunks(0u)
-		, m_used(false)
-		, m_chunkN(0u)
+	MemoryChunk()
+		: m_info(0u)
 	{}
 
-	~MemoryChunk()
-	{}
+	inline bool IsUsed() const { return (m_info & CHUNK_USED_FLAG) != 0; }
+	inline bool IsTail() const { return (m_info & CHUNK_TAIL_FLAG) != 0; }
+	//First chunk of a used slot, the only one a PoolPtr may reference
+	inline bool IsHeader() const { return (m_info & (CHUNK_USED_FLAG | CHUNK_TAIL_FLAG)) == CHUNK_USED_FLAG; }
 
-	inline bool IsUsed() const { return m_used; }
-	inline bool IsHeader() const { return IsUsed() && m_usedChunks != 0; }
+	//Amount of chunks of the slot starting on this chunk
+	inline uint32_t GetSlotChunks() const { return m_info & CHUNK_VALUE_MASK; }
+	//Index of the first chunk of the slot ending on this chunk, if it is a tail
+	inline uint32_t GetSlotStart() const { return m_info & CHUNK_VALUE_MASK; }
 
-	void* m_data;
-	uint32_t m_avaliableContiguousChunks;
-	uint32_t m_usedChunks;
-	bool m_used;
+	inline void SetSlotHead(uint32_t chunks, bool used) { m_info = chunks | (used ? CHUNK_USED_FLAG : 0u); }
+	inline void SetSlotTail(uint32_t slotStart, bool used) { m_info = slotStart | CHUNK_TAIL_FLAG | (used ? CHUNK_USED_FLAG : 0u); }
+	inline void Clear() { m_info = 0u; }
 
-	uint32_t m_chunkN;
+	uint32_t m_info;
 };
 
+//Empty metadata for *chunkCount* chunks, aligned on a cache line
+inline MemoryChunk* NewChunkMetadata(uint32_t chunkCount)
+{
+	MemoryChunk* chunks = (MemoryChunk*)::operator new(sizeof(MemoryChunk) * (size_t)chunkCount, std::align_val_t(METADATA_ALIGNMENT));
+	std::uninitialized_default_construct_n(chunks, chunkCount);
+	return chunks;
+}
+
+inline void DeleteChunkMetadata(MemoryChunk* chunks)
+{
+	::operator delete(chunks, std::align_val_t(METADATA_ALIGNMENT));
+}
+
 #endif // !__MEMORYCHUNK
\ No newline at end of file
@@ -1,39 +1,166 @@
 #include "MemoryChunk.h"
 #include "MemoryPool.h"
+#include "BitUtils.h"
+#include "VirtualMemory.h"
+#include "PoolRegistry.h"
 
 #include <assert.h>
 #include <fstream>
 #include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <new>
 
-MemoryPool::MemoryPool(uint32_t chunkSizeInBytes, uint32_t chunkCount)
+//Pages with any used chunk in them, for the decay purging
+#define PAGE_NOT_FREE 0u
+//Pages already purged
+#define PAGE_PURGED UINT64_MAX
+//Chunk sizes that aren't a power of two need a division to find a chunk from an address
+#define NO_CHUNK_SHIFT UINT32_MAX
+
+MemoryPool::MemoryPool(uint32_t chunkSizeInBytes, uint32_t chunkCount, PoolEngine engine, const PoolGrowth& growth, PoolPages pages)
 	: m_firstChunk(nullptr)
 	, m_freeSlotMarkers()
 	, m_dirtyFreeSlotMarkers(0u)
+	, m_markerSlots()
+	, m_engine(engine)
+	, m_sizeClasses()
+	, m_chunkBitmap()
+	, m_tlsf()
+	, m_batchSlots()
 	, m_chunkCount(chunkCount)
 	, m_chunkSize(chunkSizeInBytes)
+	, m_chunkShift(chunkSizeInBytes != 0 && (chunkSizeInBytes & (chunkSizeInBytes - 1)) == 0 ? Bits::FloorLog2(chunkSizeInBytes) : NO_CHUNK_SHIFT)
+	, m_growth(growth)
+	, m_maxChunkCount(chunkCount)
+	, m_reservedMemory(false)
+	, m_externalMemory(false)
+	, m_pageSize(pages == PoolPages::Huge ? VirtualMemory::GetHugePageSize() : VirtualMemory::GetPageSize())
+	, m_hugePages(VirtualMemory::HugePages::None)
+	, m_purgeDecay(0u)
+	, m_lazyPurge(false)
+	, m_pageFreeSince()
+	, m_lastDecayPurge(0u)
 	, m_pool(nullptr)
 {
-	assert(chunkSizeInBytes != 0 && chunkCount != 0);
+	assert(chunkSizeInBytes != 0 && chunkCount != 0 && chunkCount <= MAX_CHUNK_COUNT);
+
+	if (growth.m_maxChunkCount > chunkCount)
+	{
+		assert(growth.m_maxChunkCount <= MAX_CHUNK_COUNT);
+		m_maxChunkCount = growth.m_maxChunkCount;
+	}
+	//Metadata only needs to come from the OS if it has to grow, or to be backed by huge pages too
+	m_reservedMemory = (m_maxChunkCount > m_chunkCount || pages == PoolPages::Huge);
 
-	m_firstChunk = new MemoryChunk[m_chunkCount];
-	m_pool = new byte[GetPoolSize()];
-	
-	//Initializing all chunks to their default values
-	for (uint32_t chunkN = 0; chunkN < m_chunkCount; ++chunkN)
+	VirtualMemory::HugePages metadataPages = VirtualMemory::HugePages::None;
+	if (m_reservedMemory)
+	{
+		//Address space for the biggest the pool can get is reserved up front, so growing never moves anything
+		//Fresh pages are zeroed, which is the empty state of the chunk metadata
+		const size_t metadataBytes = VirtualMemory::RoundToPages(sizeof(MemoryChunk) * (size_t)m_maxChunkCount, m_pageSize);
+		m_firstChunk = (MemoryChunk*)(pages == PoolPages::Huge
+			? VirtualMemory::ReserveHuge(metadataBytes, metadataPages)
+			: VirtualMemory::Reserve(metadataBytes));
+		assert(m_firstChunk != nullptr && "Could not reserve the address space of the pool");
+		VirtualMemory::Commit(m_firstChunk, VirtualMemory::RoundToPages(sizeof(MemoryChunk) * (size_t)m_chunkCount, m_pageSize));
+	}
+	else
 	{
-		MemoryChunk* chunkPtr = m_firstChunk + chunkN;
-		chunkPtr->m_usedChunks = 0u;
-		chunkPtr->m_avaliableContiguousChunks = 0;
-		//Pointer to the alloted piece of memory from the pool
-		chunkPtr->m_data = m_pool + (GetChunkSize() * chunkN);
-		chunkPtr->m_chunkN = chunkN;
+		//All chunks start with empty metadata
+		m_firstChunk = NewChunkMetadata(m_chunkCount);
 	}
 
-	m_freeSlotMarkers.reserve(m_chunkCount / 5);
+	//The data always comes straight from the OS, page aligned, so free pages can be given back with Trim
+	//Huge pages are aligned on their size, so slots of power of two sizes never straddle two of them
+	const size_t dataBytes = VirtualMemory::RoundToPages((size_t)m_chunkSize * m_maxChunkCount, m_pageSize);
+	m_pool = (byte*)(pages == PoolPages::Huge
+		? VirtualMemory::ReserveHuge(dataBytes, m_hugePages)
+		: VirtualMemory::Reserve(dataBytes));
+	assert(m_pool != nullptr && "Could not reserve the address space of the pool");
+	VirtualMemory::Commit(m_pool, VirtualMemory::RoundToPages((size_t)m_chunkSize * m_chunkCount, m_pageSize));
+
+	InitEngine();
+	PoolRegistry::Register(*this, m_pool, (size_t)m_chunkSize * m_maxChunkCount);
+}
+
+MemoryPool::MemoryPool(uint32_t chunkSizeInBytes, uint32_t chunkCount, byte* memory, PoolEngine engine)
+	: m_firstChunk(nullptr)
+	, m_freeSlotMarkers()
+	, m_dirtyFreeSlotMarkers(0u)
+	, m_markerSlots()
+	, m_engine(engine)
+	, m_sizeClasses()
+	, m_chunkBitmap()
+	, m_tlsf()
+	, m_batchSlots()
+	, m_chunkCount(chunkCount)
+	, m_chunkSize(chunkSizeInBytes)
+	, m_chunkShift(chunkSizeInBytes != 0 && (chunkSizeInBytes & (chunkSizeInBytes - 1)) == 0 ? Bits::FloorLog2(chunkSizeInBytes) : NO_CHUNK_SHIFT)
+	, m_growth()
+	, m_maxChunkCount(chunkCount)
+	, m_reservedMemory(false)
+	, m_externalMemory(true)
+	, m_pageSize(VirtualMemory::GetPageSize())
+	, m_hugePages(VirtualMemory::HugePages::None)
+	, m_purgeDecay(0u)
+	, m_lazyPurge(false)
+	, m_pageFreeSince()
+	, m_lastDecayPurge(0u)
+	, m_pool(memory)
+{
+	assert(chunkSizeInBytes != 0 && chunkCount != 0 && chunkCount <= MAX_CHUNK_COUNT);
+	//Trim only purges whole pages, which it finds counting from the start of the pool
+	assert(memory != nullptr && (size_t)memory % m_pageSize == 0 && "Pool memory must be page aligned");
+	m_firstChunk = NewChunkMetadata(m_chunkCount);
+	InitEngine();
+	PoolRegistry::Register(*this, m_pool, (size_t)m_chunkSize * m_maxChunkCount);
+}
+
+void MemoryPool::InitEngine()
+{
+	if (m_engine == PoolEngine::Bitmap)
+	{
+		//The bitmap engine doesn't use any marker, all chunks simply start as free
+		m_chunkBitmap.Init(m_chunkCount);
+		return;
+	}
+	if (m_engine == PoolEngine::Tlsf)
+	{
+		//The whole pool starts as a single free slot, only tracked by the TLSF lists
+		m_tlsf.Init(m_firstChunk, m_chunkCount);
+		SetSlot(m_firstChunk, GetChunkCount(), false);
+		m_tlsf.Insert(0u, GetChunkCount());
+		return;
+	}
+	if (m_engine == PoolEngine::Buddy)
+	{
+		//Blocks of 2^N chunks are kept in the size class of 2^N, so every bucket is the free list of one order
+		m_sizeClasses.Init(m_firstChunk, m_chunkCount);
+		//Pools that aren't a power of two start split in the biggest blocks that fit, each one aligned on its size
+		for (uint32_t blockStart = 0u; blockStart < m_chunkCount;)
+		{
+			const uint32_t blockChunks = 1u << Bits::FloorLog2(m_chunkCount - blockStart);
+			SetSlot(m_firstChunk + blockStart, blockChunks, false);
+			m_sizeClasses.Insert(blockStart, blockChunks);
+			blockStart += blockChunks;
+		}
+		return;
+	}
+
+	m_markerSlots.resize(m_chunkCount);
+	if (m_engine == PoolEngine::SegregatedFreeMarkers)
+		m_sizeClasses.Init(m_firstChunk, m_chunkCount);
+
+	//There can't be more free slots than half the chunks, since two free slots are always separated by a used one
+	//All markers are allocated up front as "dirty" ones so adding markers never needs to grow the vector
+	m_freeSlotMarkers.resize((m_chunkCount + 1) / 2, nullptr);
+	m_dirtyFreeSlotMarkers = (uint32_t)m_freeSlotMarkers.size();
 	//Adding a marker at the start of the pool as the first "free" spot avaliable
 	AddFreeSlotMarker(m_firstChunk);
-	m_firstChunk->m_avaliableContiguousChunks = GetChunkCount();
-
+	SetSlot(m_firstChunk, GetChunkCount(), false);
+	IndexFreeSlot(m_firstChunk);
 }
 
 MemoryPool::~MemoryPool()
@@ -41,121 +168,724 @@ MemoryPool::~MemoryPool()
 	//Checking there are no dangling PoolPtrs and that all of them have been freed
 	//If there is a single free slot marker and the end of the pool is clean, no reserved memory is left
 	// --- Commenting this assert will still ensure there are no leaks, but may lead to invalid pointers
-	assert(m_freeSlotMarkers.size() - m_dirtyFreeSlotMarkers == 1
+	assert(UsesFreeMarkers() == false
+		|| (m_freeSlotMarkers.size() - m_dirtyFreeSlotMarkers == 1
 		&& m_freeSlotMarkers[0] == m_firstChunk
-		&& (m_firstChunk + GetChunkCount() - 1)->IsUsed() == false);
+		&& (m_firstChunk + GetChunkCount() - 1)->IsUsed() == false));
+	assert(m_engine != PoolEngine::Bitmap || m_chunkBitmap.GetFreeChunks() == GetChunkCount());
+	assert(m_engine != PoolEngine::Tlsf || m_tlsf.GetFreeChunks() == GetChunkCount());
+	assert(m_engine != PoolEngine::Buddy || GetFreeChunks() == GetChunkCount());
+
+	PoolRegistry::Unregister(*this);
+	if (m_externalMemory == false)
+		VirtualMemory::Release(m_pool, VirtualMemory::RoundToPages((size_t)m_chunkSize * m_maxChunkCount, m_pageSize));
+	if (m_reservedMemory)
+		VirtualMemory::Release(m_firstChunk, VirtualMemory::RoundToPages(sizeof(MemoryChunk) * (size_t)m_maxChunkCount, m_pageSize));
+	else
+		DeleteChunkMetadata(m_firstChunk);
+}
+
+void MemoryPool::Reset()
+{
+	//Free slots are only read at their ends, so once the engine forgets every slot, writing the ends of
+	//a single free slot covering the whole pool is enough. The bitmap engine doesn't even need that
+	//Heads of old allocations are left as they were though, so their PoolPtrs would still look valid
+	m_batchSlots.clear();
+#ifdef _DEBUG
+	//Debug builds wipe them, so stale PoolPtrs are invalid and freeing them asserts
+	memset((void*)m_firstChunk, 0, sizeof(MemoryChunk) * (size_t)m_chunkCount);
+#endif
+	if (m_engine == PoolEngine::Tlsf)
+		m_tlsf.Clear();
+	else if (m_engine == PoolEngine::Buddy || m_engine == PoolEngine::SegregatedFreeMarkers)
+		m_sizeClasses.Clear();
+	if (UsesFreeMarkers())
+		std::fill(m_freeSlotMarkers.begin(), m_freeSlotMarkers.end() - m_dirtyFreeSlotMarkers, nullptr);
+	//The bitmap engine clears a bit per chunk, which is still a few words per thousand chunks
+	InitEngine();
 
-	delete[] m_pool;
-	delete[] m_firstChunk;
+	if (m_purgeDecay != 0u)
+		TrackReleasedPages(0u, m_chunkCount);
 }
 
 PoolPtr<byte> MemoryPool::Alloc(uint32_t bytes)
 {
-	//Amount of chunks required
-	uint32_t chunksOccupied = ChunksToFit(bytes);
+	MemoryChunk* headChunk = AllocSlot(ChunksToFit(bytes));
+	if (headChunk == nullptr)
+		return PoolPtr<byte>(nullptr);
 
-	//Find the first slot big enough to fit our data
-	uint32_t freeSlotIndex = FindSlotFor(chunksOccupied);
-	if (freeSlotIndex == INVALID_CHUNK_ID)
+#ifdef _DEBUG
+	return PoolPtr<byte>(headChunk, GetChunkData(headChunk), bytes);
+#else
+	return PoolPtr<byte>(headChunk, GetChunkData(headChunk));
+#endif
+}
+
+PoolPtr<byte> MemoryPool::Alloc(uint32_t bytes, uint32_t& usableBytes)
+{
+	PoolPtr<byte> allocation = Alloc(bytes);
+	usableBytes = (allocation.IsValid() ? allocation.m_chunk->GetSlotChunks() * m_chunkSize : 0u);
+	return allocation;
+}
+
+void* MemoryPool::Allocate(size_t bytes)
+{
+	if (bytes > UINT32_MAX)
+		return nullptr;
+	MemoryChunk* headChunk = AllocSlot(ChunksToFit((uint32_t)bytes));
+	return (headChunk != nullptr ? GetChunkData(headChunk) : nullptr);
+}
+
+void* MemoryPool::Allocate(size_t bytes, size_t& usableBytes)
+{
+	void* memory = Allocate(bytes);
+	usableBytes = (memory != nullptr ? GetUsableSize(memory) : 0u);
+	return memory;
+}
+
+PoolPtr<byte> MemoryPool::AllocAligned(uint32_t bytes, uint32_t alignment)
+{
+	MemoryChunk* headChunk = AllocAlignedSlot(bytes, alignment);
+	if (headChunk == nullptr)
 		return PoolPtr<byte>(nullptr);
 
-	//We're guaranteed that this chunk is free and has more than *bytes* of free space
-	MemoryChunk* headChunk = m_freeSlotMarkers[freeSlotIndex];
+#ifdef _DEBUG
+	return PoolPtr<byte>(headChunk, GetChunkData(headChunk), bytes);
+#else
+	return PoolPtr<byte>(headChunk, GetChunkData(headChunk));
+#endif
+}
+
+void* MemoryPool::AllocateAligned(size_t bytes, size_t alignment)
+{
+	if (bytes > UINT32_MAX || alignment > UINT32_MAX)
+		return nullptr;
+	MemoryChunk* headChunk = AllocAlignedSlot((uint32_t)bytes, (uint32_t)alignment);
+	return (headChunk != nullptr ? GetChunkData(headChunk) : nullptr);
+}
+
+bool MemoryPool::Realloc(PoolPtr<byte>& toResize, uint32_t bytes)
+{
+	if (toResize.IsValid() == false)
+	{
+		toResize = Alloc(bytes);
+		return toResize.IsValid();
+	}
+
+	const uint32_t chunks = ChunksToFit(bytes);
+	MemoryChunk* headChunk = toResize.m_chunk;
+	if (ResizeSlotInPlace(headChunk, chunks) == false)
+	{
+		headChunk = MoveSlot(headChunk, chunks);
+		if (headChunk == nullptr)
+			return false;
+	}
+#ifdef _DEBUG
+	toResize = PoolPtr<byte>(headChunk, GetChunkData(headChunk), bytes);
+#else
+	toResize = PoolPtr<byte>(headChunk, GetChunkData(headChunk));
+#endif
+	return true;
+}
+
+bool MemoryPool::TryExpandInPlace(PoolPtr<byte>& toResize, uint32_t bytes)
+{
+	assert(toResize.IsValid() && "Attempted to expand an invalid poolPtr");
+	if (ResizeSlotInPlace(toResize.m_chunk, ChunksToFit(bytes)) == false)
+		return false;
+#ifdef _DEBUG
+	toResize.m_allocatedInstances = bytes;
+#endif
+	return true;
+}
+
+uint32_t MemoryPool::GetUsableSize(const PoolPtrBase& allocation) const
+{
+	assert(allocation.IsValid());
+	return allocation.m_chunk->GetSlotChunks() * m_chunkSize;
+}
+
+void* MemoryPool::Reallocate(void* memory, size_t bytes)
+{
+	if (memory == nullptr)
+		return Allocate(bytes);
+	if (bytes > UINT32_MAX)
+		return nullptr;
+
+	const uint32_t chunks = ChunksToFit((uint32_t)bytes);
+	MemoryChunk* headChunk = GetChunkFor(memory);
+	if (ResizeSlotInPlace(headChunk, chunks))
+		return memory;
+	headChunk = MoveSlot(headChunk, chunks);
+	return (headChunk != nullptr ? GetChunkData(headChunk) : nullptr);
+}
+
+size_t MemoryPool::GetUsableSize(const void* memory) const
+{
+	const MemoryChunk* headChunk = GetChunkFor(memory);
+	assert(headChunk->IsHeader() && headChunk->IsUsed() && "Memory isn't the start of an allocation");
+	return (size_t)headChunk->GetSlotChunks() * m_chunkSize;
+}
+
+uint32_t MemoryPool::AllocBatch(uint32_t count, uint32_t bytes, PoolPtr<byte>* allocations)
+{
+	return AllocBatchSlots(count, ChunksToFit(bytes), [this, allocations, bytes](MemoryChunk* headChunk) mutable
+	{
+#ifdef _DEBUG
+		*allocations++ = PoolPtr<byte>(headChunk, GetChunkData(headChunk), bytes);
+#else
+		*allocations++ = PoolPtr<byte>(headChunk, GetChunkData(headChunk));
+#endif
+	});
+}
+
+void MemoryPool::FreeBatch(PoolPtr<byte>* allocations, uint32_t count)
+{
+	m_batchSlots.clear();
+	for (uint32_t n = 0u; n < count; ++n)
+	{
+		if (allocations[n].IsValid())
+			m_batchSlots.push_back(allocations[n].m_chunk);
+		//Mark as invalid the released PoolPtr
+		allocations[n].m_chunk = nullptr;
+		allocations[n].m_data = nullptr;
+	}
+	FreeBatchSlots();
+}
+
+uint32_t MemoryPool::AllocateBatch(uint32_t count, size_t bytes, void** allocations)
+{
+	if (bytes > UINT32_MAX)
+		return 0u;
+	return AllocBatchSlots(count, ChunksToFit((uint32_t)bytes), [this, allocations](MemoryChunk* headChunk) mutable
+	{
+		*allocations++ = GetChunkData(headChunk);
+	});
+}
+
+void MemoryPool::DeallocateBatch(void** allocations, uint32_t count)
+{
+	m_batchSlots.clear();
+	for (uint32_t n = 0u; n < count; ++n)
+	{
+		if (allocations[n] != nullptr)
+			m_batchSlots.push_back(GetChunkFor(allocations[n]));
+	}
+	FreeBatchSlots();
+}
+
+template<class Output>
+uint32_t MemoryPool::AllocBatchSlots(uint32_t count, uint32_t chunks, Output output)
+{
+	assert(chunks != 0u && "Attempted to allocate a batch of empty slots");
+	if (chunks > m_maxChunkCount)
+		return 0u;
+	//Nothing to share the search with
+	if (count == 1u)
+	{
+		MemoryChunk* headChunk = AllocSlot(chunks);
+		if (headChunk == nullptr)
+			return 0u;
+		output(headChunk);
+		return 1u;
+	}
+
+	uint32_t allocated = 0u;
+	while (allocated < count)
+	{
+		uint32_t slots = 0u;
+		uint32_t slotStride = 0u;
+		MemoryChunk* runStart = ClaimSlotRun(chunks, count - allocated, slots, slotStride);
+		if (runStart == nullptr)
+		{
+			//Full pools grow by one slot, and the next runs come from the new chunks
+			runStart = GrowAndClaimSlot(chunks);
+			if (runStart == nullptr)
+				break;
+			slots = 1u;
+			slotStride = chunks;
+		}
+
+		if (m_purgeDecay != 0u)
+			TrackClaimedPages(GetChunkIndex(runStart), slots * slotStride);
+		for (MemoryChunk* headChunk = runStart; slots != 0u; --slots, headChunk += slotStride)
+		{
+			SetSlot(headChunk, chunks, true);
+			output(headChunk);
+			allocated++;
+		}
+	}
+	return allocated;
+}
+
+MemoryChunk* MemoryPool::ClaimSlotRun(uint32_t chunks, uint32_t maxSlots, uint32_t& slots, uint32_t& slotStride)
+{
+	slotStride = chunks;
+	//Runs for the whole batch are looked for first, so most batches come from a single one
+	//Wanting more chunks than the pool may have is the same as wanting all of them
+	if ((uint64_t)maxSlots * chunks > m_maxChunkCount)
+		maxSlots = m_maxChunkCount / chunks;
+	const uint32_t maxChunks = maxSlots * chunks;
+	switch (m_engine)
+	{
+	case PoolEngine::Bitmap:
+	{
+		uint32_t claimedChunks = 0u;
+		const uint32_t runStart = m_chunkBitmap.ClaimRun(chunks, maxChunks, claimedChunks);
+		if (runStart == INVALID_CHUNK_ID)
+			return nullptr;
+		slots = claimedChunks / chunks;
+		return m_firstChunk + runStart;
+	}
+	case PoolEngine::Tlsf:
+	{
+		uint32_t runStart = (maxChunks > chunks ? m_tlsf.FindSlotFor(maxChunks) : INVALID_CHUNK_ID);
+		if (runStart == INVALID_CHUNK_ID)
+			runStart = m_tlsf.FindSlotFor(chunks);
+		if (runStart == INVALID_CHUNK_ID)
+			return nullptr;
+		const uint32_t avaliableChunks = m_firstChunk[runStart].GetSlotChunks();
+		slots = (avaliableChunks >= maxChunks ? maxSlots : avaliableChunks / chunks);
+		return ClaimFromTlsfSlot(runStart, slots * chunks);
+	}
+	case PoolEngine::Buddy:
+	{
+		//A block split in equal parts is made of blocks aligned on their size, so each part is a block of its own
+		slotStride = 1u << Bits::CeilLog2(chunks);
+		for (slots = 1u << Bits::FloorLog2(maxChunks / chunks); slots != 0u; slots /= 2u)
+		{
+			MemoryChunk* runStart = ClaimBuddySlot(slots * slotStride);
+			if (runStart != nullptr)
+				return runStart;
+		}
+		return nullptr;
+	}
+	default:
+	{
+		uint32_t freeSlotIndex = (maxChunks > chunks ? FindSlotFor(maxChunks) : INVALID_CHUNK_ID);
+		if (freeSlotIndex == INVALID_CHUNK_ID)
+			freeSlotIndex = FindSlotFor(chunks);
+		if (freeSlotIndex == INVALID_CHUNK_ID)
+			return nullptr;
+		const uint32_t avaliableChunks = m_freeSlotMarkers[freeSlotIndex]->GetSlotChunks();
+		slots = (avaliableChunks >= maxChunks ? maxSlots : avaliableChunks / chunks);
+		return ClaimFromFreeMarkerSlot(freeSlotIndex, slots * chunks);
+	}
+	}
+}
+
+void MemoryPool::FreeBatchSlots()
+{
+	//Buddy blocks only merge with their buddies, which Free already does, and a single slot has nothing to merge with
+	if (m_engine == PoolEngine::Buddy || m_batchSlots.size() == 1u)
+	{
+		for (MemoryChunk* toFree : m_batchSlots)
+			Free(toFree);
+		return;
+	}
+
+	std::sort(m_batchSlots.begin(), m_batchSlots.end());
+	for (size_t n = 0u; n < m_batchSlots.size();)
+	{
+		//Slots right after each other become a single used slot, which is then freed in one go
+		MemoryChunk* runStart = m_batchSlots[n];
+		uint32_t runChunks = runStart->GetSlotChunks();
+		for (n++; n < m_batchSlots.size() && m_batchSlots[n] == runStart + runChunks; n++)
+		{
+			MemoryChunk* slotStart = m_batchSlots[n];
+			assert(slotStart->IsHeader() && slotStart->IsUsed() && "Attempted to free a chunk which is not the first of a used slot");
+			runChunks += slotStart->GetSlotChunks();
+			//Nothing starts here anymore, so any PoolPtr still referencing this chunk is no longer valid
+			slotStart->Clear();
+		}
+		assert((n == m_batchSlots.size() || m_batchSlots[n] != m_batchSlots[n - 1]) && "Attempted to free a slot twice in the same batch");
+		if (runChunks != runStart->GetSlotChunks())
+			SetSlot(runStart, runChunks, true);
+		Free(runStart);
+	}
+}
+
+void MemoryPool::Deallocate(void* memory)
+{
+	//Like free, releasing nullptr does nothing
+	if (memory != nullptr)
+		Free(GetChunkFor(memory));
+}
+
+void MemoryPool::Deallocate(void* memory, size_t bytes)
+{
+	if (memory == nullptr)
+		return;
+	MemoryChunk* headChunk = GetChunkFor(memory);
+	(void)bytes;
+	assert(bytes <= UINT32_MAX && headChunk->IsHeader() && headChunk->GetSlotChunks() == ChunksToFit((uint32_t)bytes)
+		&& "Deallocated size doesn't match the allocated one");
+	Free(headChunk);
+}
+
+inline MemoryChunk* MemoryPool::AllocSlot(uint32_t chunksOccupied)
+{
+	assert(chunksOccupied != 0u && "Attempted to allocate an empty slot");
+	if (chunksOccupied > m_maxChunkCount)
+		return nullptr;
+
+	//Find the first slot big enough to fit our data and take it out of the free memory
+	MemoryChunk* headChunk = ClaimSlot(chunksOccupied);
+	if (headChunk == nullptr)
+	{
+		//Only full pools get here, so growing doesn't cost anything to the usual allocations
+		headChunk = GrowAndClaimSlot(chunksOccupied);
+		if (headChunk == nullptr)
+			return nullptr;
+	}
+
+	//Mark the first and last chunks of the slot as used, and how many chunks it manages
+	//No one should request intermediary chunks if all behaves as expected
+	SetSlot(headChunk, chunksOccupied, true);
+	if (m_purgeDecay != 0u)
+		TrackClaimedPages(GetChunkIndex(headChunk), chunksOccupied);
+	return headChunk;
+}
+
+MemoryChunk* MemoryPool::AllocAlignedSlot(uint32_t bytes, uint32_t alignment)
+{
+	assert(alignment != 0u && (alignment & (alignment - 1u)) == 0u && "Alignment must be a power of two");
+	assert(alignment <= m_pageSize && "Alignments bigger than the pool pages are not supported");
+	const uint32_t chunks = ChunksToFit(bytes);
+	if (alignment <= GetChunkAlignment())
+		return AllocSlot(chunks);
+
+	//The pool starts on a page, so one of every *step* chunks is aligned
+	const uint32_t step = alignment / GetChunkAlignment();
+	if (m_engine == PoolEngine::Buddy)
+	{
+		//Blocks are aligned on their size, so a block of at least *step* chunks is aligned. Halves it doesn't need go back
+		MemoryChunk* headChunk = AllocSlot(chunks > step ? chunks : step);
+		if (headChunk != nullptr)
+			ShrinkUsedSlot(headChunk, chunks);
+		return headChunk;
+	}
+
+	//Room for the allocation from any chunk, giving back what is left in front of the first aligned chunk and after the allocation
+	if ((uint64_t)chunks + step - 1u > m_maxChunkCount)
+		return nullptr;
+	MemoryChunk* headChunk = AllocSlot(chunks + step - 1u);
+	if (headChunk == nullptr)
+		return nullptr;
+	const uint32_t leadingChunks = (step - GetChunkIndex(headChunk) % step) % step;
+	if (leadingChunks != 0u)
+	{
+		MemoryChunk* alignedChunk = SplitUsedSlot(headChunk, leadingChunks);
+		Free(headChunk);
+		headChunk = alignedChunk;
+	}
+	ShrinkUsedSlot(headChunk, chunks);
+	return headChunk;
+}
+
+MemoryChunk* MemoryPool::SplitUsedSlot(MemoryChunk* slotStart, uint32_t firstChunks)
+{
+	const uint32_t slotChunks = slotStart->GetSlotChunks();
+	assert(slotStart->IsHeader() && firstChunks != 0u && firstChunks < slotChunks);
+	SetSlot(slotStart, firstChunks, true);
+	SetSlot(slotStart + firstChunks, slotChunks - firstChunks, true);
+	return slotStart + firstChunks;
+}
+
+void MemoryPool::ShrinkUsedSlot(MemoryChunk* slotStart, uint32_t chunks)
+{
+	uint32_t slotChunks = slotStart->GetSlotChunks();
+	assert(slotStart->IsHeader() && chunks != 0u && chunks <= slotChunks);
+	if (m_engine == PoolEngine::Buddy)
+	{
+		//Blocks have to stay aligned on their size, so only whole upper halves can be given back
+		slotChunks = 1u << Bits::CeilLog2(slotChunks);
+		while (slotChunks / 2u >= chunks)
+		{
+			slotChunks /= 2u;
+			SetSlot(slotStart + slotChunks, slotChunks, true);
+			Free(slotStart + slotChunks);
+		}
+		SetSlot(slotStart, chunks, true);
+	}
+	else if (chunks < slotChunks)
+		Free(SplitUsedSlot(slotStart, chunks));
+}
+
+bool MemoryPool::ResizeSlotInPlace(MemoryChunk* slotStart, uint32_t chunks)
+{
+	const uint32_t slotChunks = slotStart->GetSlotChunks();
+	assert(slotStart->IsHeader() && slotStart->IsUsed() && chunks != 0u && "Attempted to resize an invalid slot");
+	if (chunks <= slotChunks)
+	{
+		ShrinkUsedSlot(slotStart, chunks);
+		return true;
+	}
+
+	if (m_engine == PoolEngine::Buddy)
+	{
+		//Only the chunks the block already holds can be used, its buddy may be anywhere in the free lists
+		if (chunks > 1u << Bits::CeilLog2(slotChunks))
+			return false;
+		SetSlot(slotStart, chunks, true);
+		return true;
+	}
+
+	//The following chunks have to be free and enough, and are taken out of the free memory as if they were allocated
+	const uint32_t missingChunks = chunks - slotChunks;
+	const uint32_t followingChunk = GetChunkIndex(slotStart) + slotChunks;
+	if (followingChunk >= m_chunkCount || missingChunks > m_chunkCount - followingChunk)
+		return false;
+	MemoryChunk* followingSlot = m_firstChunk + followingChunk;
+	if (m_engine == PoolEngine::Bitmap)
+	{
+		if (m_chunkBitmap.ClaimAt(followingChunk, missingChunks) == false)
+			return false;
+	}
+	else
+	{
+		if (followingSlot->IsUsed() || followingSlot->GetSlotChunks() < missingChunks)
+			return false;
+		if (m_engine == PoolEngine::Tlsf)
+			ClaimFromTlsfSlot(followingChunk, missingChunks);
+		else
+			ClaimFromFreeMarkerSlot(m_markerSlots[followingChunk], missingChunks);
+		//Nothing starts here anymore
+		followingSlot->Clear();
+	}
 
-	//Mark this chunk as the first of a slot, and how many chunks it manages
-	headChunk->m_usedChunks = chunksOccupied;
-	headChunk->m_used = true;
-	//Minus one, because "chunks occupied" already includes the current chunk
-	MemoryChunk* endCHunk = headChunk + chunksOccupied - 1;
-	//We only need to mark as "used" the first and last chunks of the used slot.
-	//No one should request intermediary slots if all behaves as expected
-	endCHunk->m_used = true;
+	SetSlot(slotStart, chunks, true);
+	if (m_purgeDecay != 0u)
+		TrackClaimedPages(followingChunk, missingChunks);
+	return true;
+}
+
+MemoryChunk* MemoryPool::MoveSlot(MemoryChunk* slotStart, uint32_t chunks)
+{
+	const uint32_t slotChunks = slotStart->GetSlotChunks();
+	MemoryChunk* headChunk = AllocSlot(chunks);
+	if (headChunk == nullptr)
+		return nullptr;
+	memcpy(GetChunkData(headChunk), GetChunkData(slotStart), (size_t)(slotChunks < chunks ? slotChunks : chunks) * m_chunkSize);
+	Free(slotStart);
+	return headChunk;
+}
+
+inline MemoryChunk* MemoryPool::ClaimSlot(uint32_t chunks)
+{
+	switch (m_engine)
+	{
+	case PoolEngine::Bitmap: return ClaimBitmapSlot(chunks);
+	case PoolEngine::Tlsf: return ClaimTlsfSlot(chunks);
+	case PoolEngine::Buddy: return ClaimBuddySlot(chunks);
+	default: return ClaimFreeMarkerSlot(chunks);
+	}
+}
+
+MemoryChunk* MemoryPool::GrowAndClaimSlot(uint32_t chunks)
+{
+	MemoryChunk* headChunk = nullptr;
+	//The new chunks are merged with any free slot at the end of the pool, so a smaller growth may already be enough
+	while (headChunk == nullptr && m_chunkCount < m_maxChunkCount)
+	{
+		uint32_t addedChunks = (m_growth.m_policy == PoolGrowthPolicy::Double ? m_chunkCount : m_growth.m_stepChunks);
+		if (addedChunks < m_growth.m_stepChunks)
+			addedChunks = m_growth.m_stepChunks;
+		if (addedChunks < chunks)
+			addedChunks = chunks;
+		if (addedChunks > m_maxChunkCount - m_chunkCount)
+			addedChunks = m_maxChunkCount - m_chunkCount;
+
+		if (AddChunks(m_chunkCount + addedChunks) == false)
+			return nullptr;
+		headChunk = ClaimSlot(chunks);
+	}
+	return headChunk;
+}
+
+bool MemoryPool::AddChunks(uint32_t newChunkCount)
+{
+	assert(m_reservedMemory && newChunkCount > m_chunkCount && newChunkCount <= m_maxChunkCount);
+
+	//Only the pages not committed yet are committed, both for the metadata and the data
+	const size_t committedMetadata = VirtualMemory::RoundToPages(sizeof(MemoryChunk) * (size_t)m_chunkCount, m_pageSize);
+	const size_t committedData = VirtualMemory::RoundToPages((size_t)m_chunkSize * m_chunkCount, m_pageSize);
+	const size_t newMetadata = VirtualMemory::RoundToPages(sizeof(MemoryChunk) * (size_t)newChunkCount, m_pageSize);
+	const size_t newData = VirtualMemory::RoundToPages((size_t)m_chunkSize * newChunkCount, m_pageSize);
+	if (VirtualMemory::Commit((byte*)m_firstChunk + committedMetadata, newMetadata - committedMetadata) == false
+		|| VirtualMemory::Commit(m_pool + committedData, newData - committedData) == false)
+		return false;
+
+	const uint32_t firstNewChunk = m_chunkCount;
+	const uint32_t addedChunks = newChunkCount - m_chunkCount;
+	MemoryChunk* newChunks = m_firstChunk + firstNewChunk;
+	m_chunkCount = newChunkCount;
+
+	//The new chunks are handed to the engine as if they were a used slot being freed, so they merge with their neighbours
+	switch (m_engine)
+	{
+	case PoolEngine::Bitmap:
+		m_chunkBitmap.Grow(m_chunkCount);
+		m_chunkBitmap.Release(firstNewChunk, addedChunks);
+		break;
+	case PoolEngine::Tlsf:
+		m_tlsf.Init(m_firstChunk, m_chunkCount);
+		SetSlot(newChunks, addedChunks, true);
+		ReleaseTlsfSlot(newChunks, newChunks + addedChunks - 1);
+		break;
+	case PoolEngine::Buddy:
+		m_sizeClasses.Init(m_firstChunk, m_chunkCount);
+		//Blocks have to be aligned on their size, so the new chunks are split in the biggest blocks that keep that
+		for (uint32_t blockStart = firstNewChunk; blockStart < m_chunkCount;)
+		{
+			uint32_t blockChunks = 1u << Bits::FloorLog2(m_chunkCount - blockStart);
+			const uint32_t alignment = blockStart & (0u - blockStart);
+			if (alignment < blockChunks)
+				blockChunks = alignment;
+			SetSlot(m_firstChunk + blockStart, blockChunks, true);
+			ReleaseBuddySlot(m_firstChunk + blockStart);
+			blockStart += blockChunks;
+		}
+		break;
+	default:
+		m_markerSlots.resize(m_chunkCount);
+		if (m_engine == PoolEngine::SegregatedFreeMarkers)
+			m_sizeClasses.Init(m_firstChunk, m_chunkCount);
+		//New markers are added as dirty ones, which are always kept at the end
+		m_dirtyFreeSlotMarkers += (m_chunkCount + 1) / 2 - (uint32_t)m_freeSlotMarkers.size();
+		m_freeSlotMarkers.resize((m_chunkCount + 1) / 2, nullptr);
+		SetSlot(newChunks, addedChunks, true);
+		ReleaseFreeMarkerSlot(newChunks, newChunks + addedChunks - 1);
+		break;
+	}
+	return true;
+}
+
+MemoryChunk* MemoryPool::ClaimFreeMarkerSlot(uint32_t chunks)
+{
+	uint32_t freeSlotIndex = FindSlotFor(chunks);
+	if (freeSlotIndex == INVALID_CHUNK_ID)
+		return nullptr;
+
+	return ClaimFromFreeMarkerSlot(freeSlotIndex, chunks);
+}
+
+MemoryChunk* MemoryPool::ClaimFromFreeMarkerSlot(uint32_t freeSlotIndex, uint32_t chunks)
+{
+	//We're guaranteed that this chunk is free and has more than *chunks* contiguous free chunks
+	MemoryChunk* headChunk = m_freeSlotMarkers[freeSlotIndex];
+	const uint32_t avaliableChunks = headChunk->GetSlotChunks();
 
 	//If the chunk following the reserved memory is free, move the "free marker" pointer to there
-	if (IsLastChunk(endCHunk) == false && (endCHunk + 1)->IsUsed() == false)
+	if (avaliableChunks > chunks)
 	{
-		m_freeSlotMarkers[freeSlotIndex] = (endCHunk + 1);
-		(endCHunk + 1)->m_avaliableContiguousChunks = headChunk->m_avaliableContiguousChunks - chunksOccupied;
+		MemoryChunk* remainingSlot = headChunk + chunks;
+		m_freeSlotMarkers[freeSlotIndex] = remainingSlot;
+		m_markerSlots[GetChunkIndex(remainingSlot)] = freeSlotIndex;
+		//Also updates the boundary tag at the end of the remaining free slot
+		SetSlot(remainingSlot, avaliableChunks - chunks, false);
+		if (m_engine == PoolEngine::SegregatedFreeMarkers)
+			m_sizeClasses.Replace(GetChunkIndex(headChunk), avaliableChunks, GetChunkIndex(remainingSlot), avaliableChunks - chunks);
 	}
 	//Else, nullify the "free marker"
 	else
 	{
+		UnindexFreeSlot(headChunk);
 		NullifyFreeSlotMarker(freeSlotIndex);
 	}
-	headChunk->m_avaliableContiguousChunks = 0;
+	return headChunk;
+}
 
-#ifdef _DEBUG
-	return PoolPtr<byte>(headChunk, bytes);
-#else
-	return PoolPtr<byte>(headChunk);
-#endif
+MemoryChunk* MemoryPool::ClaimBitmapSlot(uint32_t chunks)
+{
+	uint32_t chunkN = m_chunkBitmap.Claim(chunks);
+	return (chunkN != INVALID_CHUNK_ID ? m_firstChunk + chunkN : nullptr);
+}
+
+MemoryChunk* MemoryPool::ClaimTlsfSlot(uint32_t chunks)
+{
+	const uint32_t slotStart = m_tlsf.FindSlotFor(chunks);
+	if (slotStart == INVALID_CHUNK_ID)
+		return nullptr;
+	return ClaimFromTlsfSlot(slotStart, chunks);
+}
+
+MemoryChunk* MemoryPool::ClaimFromTlsfSlot(uint32_t slotStart, uint32_t chunks)
+{
+	MemoryChunk* headChunk = m_firstChunk + slotStart;
+	const uint32_t avaliableChunks = headChunk->GetSlotChunks();
+	m_tlsf.Remove(slotStart, avaliableChunks);
+
+	//Whatever is left after the allocation goes back to the list matching its new size
+	if (avaliableChunks > chunks)
+	{
+		SetSlot(headChunk + chunks, avaliableChunks - chunks, false);
+		m_tlsf.Insert(slotStart + chunks, avaliableChunks - chunks);
+	}
+	return headChunk;
+}
+
+MemoryChunk* MemoryPool::ClaimBuddySlot(uint32_t chunks)
+{
+	const uint32_t order = Bits::CeilLog2(chunks);
+	if (order >= SIZE_CLASS_COUNT || (1u << order) > m_chunkCount)
+		return nullptr;
+	const uint32_t blockChunks = 1u << order;
+
+	//The smallest free block of this order or above
+	const uint32_t blockStart = m_sizeClasses.FindSlotFor(blockChunks);
+	if (blockStart == INVALID_CHUNK_ID)
+		return nullptr;
+
+	MemoryChunk* headChunk = m_firstChunk + blockStart;
+	uint32_t avaliableChunks = headChunk->GetSlotChunks();
+	m_sizeClasses.Remove(blockStart, avaliableChunks);
+
+	//Split the block in halves until it's as small as needed, giving back the upper halves
+	while (avaliableChunks > blockChunks)
+	{
+		avaliableChunks >>= 1;
+		SetSlot(headChunk + avaliableChunks, avaliableChunks, false);
+		m_sizeClasses.Insert(blockStart + avaliableChunks, avaliableChunks);
+	}
+	return headChunk;
 }
 
 void MemoryPool::Free(MemoryChunk* toFree)
 {
 	//Checking ToFree is a valid pointer and it belongs to this specific pool
 	if (toFree
-		&& toFree->m_data == m_pool + (m_chunkSize * toFree->m_chunkN)
-		&& toFree->IsUsed() == true
-		&& toFree->m_usedChunks != 0)
+		&& toFree >= m_firstChunk && toFree < m_firstChunk + m_chunkCount
+		&& toFree->IsHeader())
 		{
-			//Minus one, because "usedChunks" already includes the first one
-			MemoryChunk* lastChunk = toFree + toFree->m_usedChunks - 1;
-			assert(lastChunk->IsUsed() == true && (lastChunk->m_usedChunks == 0 || toFree->m_usedChunks == 1));
-
-			toFree->m_used = false;
-			lastChunk->m_used = false;
+			//Minus one, because the slot chunks already include the first one
+			MemoryChunk* lastChunk = toFree + toFree->GetSlotChunks() - 1;
+			assert(lastChunk->IsUsed() == true && (lastChunk->IsTail() || lastChunk == toFree));
+			const uint32_t freedChunk = GetChunkIndex(toFree);
+			const uint32_t freedChunks = toFree->GetSlotChunks();
 
-			//If the chunk following the last chunk was "free", it will have been marked as a "free slot start"
-			//We need to remove that marker since it's no longer the start, and replace it by the new "first chunk" of the slot
-			if (IsLastChunk(lastChunk) == false && (lastChunk+1)->m_avaliableContiguousChunks != 0)
+			if (m_engine == PoolEngine::Bitmap)
 			{
-				std::vector<MemoryChunk*>::iterator followingFreeSlot = std::find(m_freeSlotMarkers.begin(), m_freeSlotMarkers.end(), lastChunk + 1);
-				assert(followingFreeSlot != m_freeSlotMarkers.end());
-
-				//Take note of how many contiguous chunks are avaliable starting on "firstChunk"
-				toFree->m_avaliableContiguousChunks = (*followingFreeSlot)->m_avaliableContiguousChunks + toFree->m_usedChunks;
-				(*followingFreeSlot)->m_avaliableContiguousChunks = 0;
-
-				//If this is the first chunk or the previous chunks are already used, we need to mark this as a "start" of a free slot
-				if (IsFirstChunk(toFree) || (toFree -1)->IsUsed() == true)
-				{
-					*followingFreeSlot = toFree;
-				}
-				//If the chunk previous to "firstChunk" is not used, we can nullify the "slot marker" and we'll need to update the "avaliable chunks" of the marker this chunks now belong to
-				else
-				{
-					NullifyFreeSlotMarker(followingFreeSlot);
-
-					m_freeSlotMarkers[FindPreceedingSlotMarker(toFree)]->m_avaliableContiguousChunks += toFree->m_avaliableContiguousChunks;
-					toFree->m_avaliableContiguousChunks = 0;
-				}
+				m_chunkBitmap.Release(GetChunkIndex(toFree), toFree->GetSlotChunks());
+				toFree->Clear();
 			}
-			//If the chunk following the reserved slot is occupied, we'll need to create a new marker or update the previous one
+			else if (m_engine == PoolEngine::Tlsf)
+				ReleaseTlsfSlot(toFree, lastChunk);
+			else if (m_engine == PoolEngine::Buddy)
+				ReleaseBuddySlot(toFree);
 			else
-			{
-				//If this is the first chunk or the previous chunks are already used, we need to mark this as a "start" of a free slot
-				if ( IsFirstChunk(toFree) || (toFree -1)->IsUsed() == true)
-				{
-					AddFreeSlotMarker(toFree);
-					//Since the chunk following the last chunk was used, this means this slot is as big as the space we released
-					toFree->m_avaliableContiguousChunks = toFree->m_usedChunks;
-				}
-				else
-				{
-					m_freeSlotMarkers[FindPreceedingSlotMarker(toFree)]->m_avaliableContiguousChunks += toFree->m_usedChunks;
-				}
-			}
+				ReleaseFreeMarkerSlot(toFree, lastChunk);
 
-			toFree->m_usedChunks = 0u;
+			if (m_purgeDecay != 0u)
+				TrackReleasedPages(freedChunk, freedChunks);
 	}
 	else
 	{
 		if (toFree == nullptr)
 			assert(false && "Attempted to free an invalid poolPtr");
-		else if (toFree->m_data != m_pool + (m_chunkSize * toFree->m_chunkN))
+		else if (toFree < m_firstChunk || toFree >= m_firstChunk + m_chunkCount)
 			assert(false && "Attempted to free a chunk allocated in a diferent pool");
-		else if (toFree->m_usedChunks == 0)
+		else if (toFree->IsTail())
 			assert(false && "Attempted to free a chunk which is not the first of an allocated slot");
 		else if (toFree->IsUsed() == false)
 			assert(false && "Attempted to free an unused/unhandled chunk");
@@ -164,28 +894,154 @@ void MemoryPool::Free(MemoryChunk* toFree)
 	}
 }
 
-inline uint32_t MemoryPool::GetPoolSize() const
+void MemoryPool::ReleaseFreeMarkerSlot(MemoryChunk* toFree, MemoryChunk* lastChunk)
+{
+	const uint32_t usedChunks = toFree->GetSlotChunks();
+	//If the last chunk of the previous slot isn't used, the released slot will be merged into it
+	const bool preceededByFreeSlot = IsFirstChunk(toFree) == false && (toFree - 1)->IsUsed() == false;
+
+	//If the chunk following the last chunk was "free", it will have been marked as a "free slot start"
+	//We need to remove that marker since it's no longer the start, and replace it by the new "first chunk" of the slot
+	if (IsLastChunk(lastChunk) == false && (lastChunk + 1)->IsUsed() == false)
+	{
+		MemoryChunk* followingFreeSlot = lastChunk + 1;
+		const uint32_t followingSlotMarker = m_markerSlots[GetChunkIndex(followingFreeSlot)];
+		const uint32_t followingChunks = followingFreeSlot->GetSlotChunks();
+		assert(m_freeSlotMarkers[followingSlotMarker] == followingFreeSlot);
+		UnindexFreeSlot(followingFreeSlot);
+
+		//If this is the first chunk or the previous chunks are already used, we need to mark this as a "start" of a free slot
+		if (preceededByFreeSlot == false)
+		{
+			m_freeSlotMarkers[followingSlotMarker] = toFree;
+			m_markerSlots[GetChunkIndex(toFree)] = followingSlotMarker;
+			//Take note of how many contiguous chunks are avaliable starting on "toFree"
+			//The end of the following free slot will also be the end of the merged one
+			SetSlot(toFree, usedChunks + followingChunks, false);
+			IndexFreeSlot(toFree);
+		}
+		//If the chunk previous to "toFree" is not used, we can nullify the "slot marker" and we'll need to update the "avaliable chunks" of the marker this chunks now belong to
+		else
+		{
+			NullifyFreeSlotMarker(followingSlotMarker);
+
+			MemoryChunk* preceedingFreeSlot = GetSlotStart(toFree - 1);
+			UnindexFreeSlot(preceedingFreeSlot);
+			SetSlot(preceedingFreeSlot, preceedingFreeSlot->GetSlotChunks() + usedChunks + followingChunks, false);
+			IndexFreeSlot(preceedingFreeSlot);
+			//Nothing starts here anymore, so any PoolPtr still referencing this chunk is no longer valid
+			toFree->Clear();
+		}
+	}
+	//If the chunk following the reserved slot is occupied, we'll need to create a new marker or update the previous one
+	else
+	{
+		//If this is the first chunk or the previous chunks are already used, we need to mark this as a "start" of a free slot
+		if (preceededByFreeSlot == false)
+		{
+			AddFreeSlotMarker(toFree);
+			//Since the chunk following the last chunk was used, this means this slot is as big as the space we released
+			SetSlot(toFree, usedChunks, false);
+			IndexFreeSlot(toFree);
+		}
+		else
+		{
+			MemoryChunk* preceedingFreeSlot = GetSlotStart(toFree - 1);
+			UnindexFreeSlot(preceedingFreeSlot);
+			SetSlot(preceedingFreeSlot, preceedingFreeSlot->GetSlotChunks() + usedChunks, false);
+			IndexFreeSlot(preceedingFreeSlot);
+			//A single chunk slot has just been turned into the tail of the merged one
+			if (toFree != lastChunk)
+				toFree->Clear();
+		}
+	}
+}
+
+void MemoryPool::ReleaseTlsfSlot(MemoryChunk* toFree, MemoryChunk* lastChunk)
 {
-	return m_chunkCount * m_chunkSize;
+	MemoryChunk* slotStart = toFree;
+	uint32_t chunks = toFree->GetSlotChunks();
+
+	//Boundary tags tell if the neighbours are free, so merging never looks further than one chunk away
+	if (IsLastChunk(lastChunk) == false && (lastChunk + 1)->IsUsed() == false)
+	{
+		MemoryChunk* followingFreeSlot = lastChunk + 1;
+		m_tlsf.Remove(GetChunkIndex(followingFreeSlot), followingFreeSlot->GetSlotChunks());
+		chunks += followingFreeSlot->GetSlotChunks();
+	}
+	if (IsFirstChunk(toFree) == false && (toFree - 1)->IsUsed() == false)
+	{
+		slotStart = GetSlotStart(toFree - 1);
+		m_tlsf.Remove(GetChunkIndex(slotStart), slotStart->GetSlotChunks());
+		chunks += slotStart->GetSlotChunks();
+		//Nothing starts here anymore, so any PoolPtr still referencing this chunk is no longer valid
+		toFree->Clear();
+	}
+
+	SetSlot(slotStart, chunks, false);
+	m_tlsf.Insert(GetChunkIndex(slotStart), chunks);
 }
 
-inline uint32_t MemoryPool::GetChunkSize() const
+void MemoryPool::ReleaseBuddySlot(MemoryChunk* toFree)
 {
-	return m_chunkSize;
+	uint32_t blockStart = GetChunkIndex(toFree);
+	uint32_t blockChunks = 1u << Bits::CeilLog2(toFree->GetSlotChunks());
+
+	//Blocks are aligned on their size, so the buddy of a block is the one with the bit of its size flipped
+	//Its first chunk is always the start of some block, so its metadata tells if it's free and whole
+	for (uint32_t buddyStart = blockStart ^ blockChunks;
+		buddyStart + blockChunks <= m_chunkCount;
+		buddyStart = blockStart ^ blockChunks)
+	{
+		MemoryChunk* buddy = m_firstChunk + buddyStart;
+		if (buddy->IsUsed() || buddy->GetSlotChunks() != blockChunks)
+			break;
+
+		m_sizeClasses.Remove(buddyStart, blockChunks);
+		//The upper half is no longer the start of anything
+		m_firstChunk[blockStart > buddyStart ? blockStart : buddyStart].Clear();
+		blockStart = (blockStart < buddyStart ? blockStart : buddyStart);
+		blockChunks <<= 1;
+	}
+
+	SetSlot(m_firstChunk + blockStart, blockChunks, false);
+	m_sizeClasses.Insert(blockStart, blockChunks);
 }
 
-inline uint32_t MemoryPool::GetChunkCount() const
+uint32_t MemoryPool::GetMaxChunkCount() const
 {
-	return m_chunkCount;
+	return m_maxChunkCount;
 }
 
 uint32_t MemoryPool::GetFreeChunks() const
 {
+	if (m_engine == PoolEngine::Bitmap)
+		return m_chunkBitmap.GetFreeChunks();
+	if (m_engine == PoolEngine::Tlsf)
+		return m_tlsf.GetFreeChunks();
+	if (m_engine == PoolEngine::Buddy)
+	{
+		//Walking the blocks, since used blocks may hold more chunks than the slot they keep
+		uint32_t ret = 0u;
+		for (uint32_t chunkN = 0u; chunkN < m_chunkCount;)
+		{
+			const MemoryChunk& block = m_firstChunk[chunkN];
+			if (block.IsUsed())
+				chunkN += 1u << Bits::CeilLog2(block.GetSlotChunks());
+			else
+			{
+				ret += block.GetSlotChunks();
+				chunkN += block.GetSlotChunks();
+			}
+		}
+		return ret;
+	}
+
 	uint32_t ret = 0u;
 	std::for_each(m_freeSlotMarkers.begin(), m_freeSlotMarkers.end() - m_dirtyFreeSlotMarkers,
 		[&ret](MemoryChunk* freeSlot)
 	{
-		ret += freeSlot->m_avaliableContiguousChunks;
+		ret += freeSlot->GetSlotChunks();
 	});
 	return ret;
 }
@@ -195,6 +1051,163 @@ uint32_t MemoryPool::GetUsedChunks() const
 	return GetChunkCount() - GetFreeChunks();
 }
 
+size_t MemoryPool::GetMetadataSize() const
+{
+	size_t ret = sizeof(MemoryChunk) * m_chunkCount;
+	if (m_engine == PoolEngine::Bitmap)
+		return ret + m_chunkBitmap.GetMetadataSize();
+	if (m_engine == PoolEngine::Tlsf)
+		return ret + TlsfIndex::GetMetadataBytesPerChunk() * m_chunkCount;
+	if (m_engine == PoolEngine::Buddy)
+		return ret + SizeClassIndex::GetMetadataBytesPerChunk() * m_chunkCount;
+
+	ret += sizeof(uint32_t) * m_markerSlots.size();
+	ret += sizeof(MemoryChunk*) * m_freeSlotMarkers.size();
+	if (m_engine == PoolEngine::SegregatedFreeMarkers)
+		ret += SizeClassIndex::GetMetadataBytesPerChunk() * m_chunkCount;
+	return ret;
+}
+
+size_t MemoryPool::Trim(bool lazy)
+{
+	return PurgeFreePages(false, lazy);
+}
+
+void MemoryPool::SetPurgeDecay(uint32_t decayMilliseconds, bool lazy)
+{
+	m_purgeDecay = decayMilliseconds;
+	m_lazyPurge = lazy;
+	if (decayMilliseconds == 0u)
+	{
+		m_pageFreeSince.clear();
+		return;
+	}
+
+	//Everything counts as free from now on. Used pages are never inside a free run, so they won't be purged
+	m_lastDecayPurge = GetDecayClock();
+	m_pageFreeSince.assign(VirtualMemory::RoundToPages((size_t)m_chunkSize * m_maxChunkCount, m_pageSize) / m_pageSize, m_lastDecayPurge);
+}
+
+template<class Func>
+void MemoryPool::ForEachFreeRun(Func func) const
+{
+	switch (m_engine)
+	{
+	case PoolEngine::FreeMarkers:
+	case PoolEngine::SegregatedFreeMarkers:
+		//Free slots are never contiguous, so every marker is a whole run
+		for (uint32_t n = 0; n < m_freeSlotMarkers.size() - m_dirtyFreeSlotMarkers; ++n)
+			func(GetChunkIndex(m_freeSlotMarkers[n]), m_freeSlotMarkers[n]->GetSlotChunks());
+		break;
+	case PoolEngine::Bitmap:
+	{
+		uint32_t runChunks = 0u;
+		for (uint32_t runStart = m_chunkBitmap.FindFreeRunFrom(0u, runChunks); runStart != INVALID_CHUNK_ID;
+			runStart = m_chunkBitmap.FindFreeRunFrom(runStart + runChunks, runChunks))
+			func(runStart, runChunks);
+		break;
+	}
+	default:
+	{
+		//Walking the slots through their first chunks. Contiguous free buddy blocks are joined in a single run
+		uint32_t runStart = INVALID_CHUNK_ID;
+		for (uint32_t chunkN = 0u; chunkN < m_chunkCount;)
+		{
+			const MemoryChunk& slot = m_firstChunk[chunkN];
+			if (slot.IsUsed())
+			{
+				if (runStart != INVALID_CHUNK_ID)
+					func(runStart, chunkN - runStart);
+				runStart = INVALID_CHUNK_ID;
+				chunkN += (m_engine == PoolEngine::Buddy ? 1u << Bits::CeilLog2(slot.GetSlotChunks()) : slot.GetSlotChunks());
+			}
+			else
+			{
+				if (runStart == INVALID_CHUNK_ID)
+					runStart = chunkN;
+				chunkN += slot.GetSlotChunks();
+			}
+		}
+		if (runStart != INVALID_CHUNK_ID)
+			func(runStart, m_chunkCount - runStart);
+		break;
+	}
+	}
+}
+
+size_t MemoryPool::PurgeFreePages(bool onlyDecayed, bool lazy)
+{
+	const size_t pageSize = m_pageSize;
+	const uint64_t now = GetDecayClock();
+	size_t purgedBytes = 0u;
+
+	ForEachFreeRun([&](uint32_t firstChunk, uint32_t chunks)
+	{
+		//Only pages fully inside the run can be purged, the ones on its edges are shared with used chunks
+		const size_t firstPage = ((size_t)firstChunk * m_chunkSize + pageSize - 1) / pageSize;
+		const size_t endPage = ((size_t)firstChunk + chunks) * m_chunkSize / pageSize;
+		if (m_pageFreeSince.empty())
+		{
+			if (endPage > firstPage)
+			{
+				VirtualMemory::Purge(m_pool + firstPage * pageSize, (endPage - firstPage) * pageSize, lazy);
+				purgedBytes += (endPage - firstPage) * pageSize;
+			}
+			return;
+		}
+
+		//With decay purging pages are purged only once, grouping contiguous ones in a single call
+		size_t rangeStart = endPage;
+		for (size_t page = firstPage; page <= endPage; ++page)
+		{
+			const bool purge = page < endPage && m_pageFreeSince[page] != PAGE_PURGED
+				&& (onlyDecayed == false || (m_pageFreeSince[page] != PAGE_NOT_FREE && now - m_pageFreeSince[page] >= m_purgeDecay));
+			if (purge && rangeStart == endPage)
+				rangeStart = page;
+			else if (purge == false && rangeStart != endPage)
+			{
+				VirtualMemory::Purge(m_pool + rangeStart * pageSize, (page - rangeStart) * pageSize, lazy);
+				purgedBytes += (page - rangeStart) * pageSize;
+				for (; rangeStart < page; ++rangeStart)
+					m_pageFreeSince[rangeStart] = PAGE_PURGED;
+				rangeStart = endPage;
+			}
+		}
+	});
+	return purgedBytes;
+}
+
+void MemoryPool::TrackClaimedPages(uint32_t firstChunk, uint32_t chunks)
+{
+	const size_t pageSize = m_pageSize;
+	const size_t endPage = (((size_t)firstChunk + chunks) * m_chunkSize + pageSize - 1) / pageSize;
+	for (size_t page = (size_t)firstChunk * m_chunkSize / pageSize; page < endPage; ++page)
+		m_pageFreeSince[page] = PAGE_NOT_FREE;
+}
+
+void MemoryPool::TrackReleasedPages(uint32_t firstChunk, uint32_t chunks)
+{
+	//Pages shared with used chunks get a time too, but they are never inside a free run until those are freed as well
+	const size_t pageSize = m_pageSize;
+	const uint64_t now = GetDecayClock();
+	const size_t endPage = (((size_t)firstChunk + chunks) * m_chunkSize + pageSize - 1) / pageSize;
+	for (size_t page = (size_t)firstChunk * m_chunkSize / pageSize; page < endPage; ++page)
+		m_pageFreeSince[page] = now;
+
+	//Looking for decayed pages every half decay period keeps them from staying free much longer than the decay
+	if (now - m_lastDecayPurge >= m_purgeDecay / 2u)
+	{
+		m_lastDecayPurge = now;
+		PurgeFreePages(true, m_lazyPurge);
+	}
+}
+
+uint64_t MemoryPool::GetDecayClock()
+{
+	//Never returns PAGE_NOT_FREE
+	return (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count() + 1u;
+}
+
 void MemoryPool::DumpMemoryToFile(const std::string& fileName, const std::string& identifier) const
 {
 	std::ofstream file;
@@ -220,23 +1233,20 @@ void MemoryPool::DumpChunksToFile(const std::string& fileName, const std::string
 			<< " |  Pool size: " << GetPoolSize()
 			<< " |" << std::endl;
 
-		bool inUsedMemory = false;
+		uint32_t usedSlotEnd = 0u;
 		for(uint32_t n = 0; n < m_chunkCount; n++)
 		{
 			MemoryChunk* chunk = m_firstChunk + n;
-			if (chunk->IsUsed() && chunk->m_usedChunks != 0)
+			if (n >= usedSlotEnd && chunk->IsHeader())
 			{
-				file << "|<" << chunk->m_usedChunks << "- ";
-				inUsedMemory = true;
+				file << "|<" << chunk->GetSlotChunks() << "- ";
+				usedSlotEnd = n + chunk->GetSlotChunks();
 			}
 
-			file.write((char*)chunk->m_data, GetChunkSize());
+			file.write((char*)GetChunkData(chunk), GetChunkSize());
 
-			if (inUsedMemory == true && chunk->IsUsed() == true && chunk->m_usedChunks == 0)
-			{
+			if (n + 1 == usedSlotEnd)
 				file << ">|";
-				inUsedMemory = false;
-			}				
 
 			file << "|";
 		}
@@ -263,19 +1273,21 @@ void MemoryPool::DumpDetailedDebugChunksToFile(const std::string& fileName, cons
 		{
 			MemoryChunk* chunk = m_firstChunk + n;
 
-			file << " | Chunk " << chunk->m_chunkN
-				<< "\t| Used: " << (chunk->IsUsed() ? "true" : "false")
-				<< "\t| Avaliable: " << chunk->m_avaliableContiguousChunks
-				<< "\t| Used chunks: " << chunk->m_usedChunks << " |";
+			file << " | Chunk " << n
+				<< "\t| Used: " << (chunk->IsUsed() ? "true" : "false");
+			if (chunk->IsTail())
+				file << "\t| Slot start: " << chunk->GetSlotStart() << " |";
+			else
+				file << "\t| Slot chunks: " << chunk->GetSlotChunks() << " |";
 
-			if (std::find(m_freeSlotMarkers.begin(), m_freeSlotMarkers.end(), chunk) != m_freeSlotMarkers.end())
+			if (IsChunkMarkedAsFreeSlotStart(chunk))
 			{
 				file << " <-- Marked as free slot start";
 			}
 
 			file  << std::endl;
 			file << "   ";
-			file.write((char*)chunk->m_data, GetChunkSize());
+			file.write((char*)GetChunkData(chunk), GetChunkSize());
 			file << std::endl;
 		}
 
@@ -285,12 +1297,18 @@ void MemoryPool::DumpDetailedDebugChunksToFile(const std::string& fileName, cons
 
 uint32_t MemoryPool::FindSlotFor(uint32_t requiredChunks) const
 {
+	if (m_engine == PoolEngine::SegregatedFreeMarkers)
+	{
+		uint32_t freeSlot = m_sizeClasses.FindSlotFor(requiredChunks);
+		return freeSlot != INVALID_CHUNK_ID ? m_markerSlots[freeSlot] : INVALID_CHUNK_ID;
+	}
+
 	uint32_t ret = (uint32_t)m_freeSlotMarkers.size() - m_dirtyFreeSlotMarkers;
 	for (std::vector<MemoryChunk*>::const_reverse_iterator freeSlot = m_freeSlotMarkers.rbegin() + m_dirtyFreeSlotMarkers;
 		freeSlot != m_freeSlotMarkers.crend(); freeSlot++)
 	{
 		ret--;
-		if ((*freeSlot)->m_avaliableContiguousChunks >= requiredChunks)
+		if ((*freeSlot)->GetSlotChunks() >= requiredChunks)
 			return ret;
 	}
 	return INVALID_CHUNK_ID;
@@ -298,51 +1316,81 @@ uint32_t MemoryPool::FindSlotFor(uint32_t requiredChunks) const
 
 uint32_t MemoryPool::ChunksToFit(uint32_t bytesOfSpace) const
 {
-	//Rounding up the division
-	return (bytesOfSpace + m_chunkSize - 1) / m_chunkSize;
+	//Empty allocations still take a chunk, so they get a pointer of their own like malloc(0)
+	if (bytesOfSpace == 0u)
+		return 1u;
+	//Rounding up the division, in 64 bits so sizes close to 4GB don't wrap around
+	return (uint32_t)(((uint64_t)bytesOfSpace + m_chunkSize - 1u) / m_chunkSize);
 }
 
 void MemoryPool::AddFreeSlotMarker(MemoryChunk* chunk)
 {
 	//All "dirty" or "nullptr" free markers should be at the end of the array
-	if (m_dirtyFreeSlotMarkers != 0)
-	{
-		m_freeSlotMarkers[m_freeSlotMarkers.size() - m_dirtyFreeSlotMarkers] = chunk;
-		m_dirtyFreeSlotMarkers--;
-	}
-	else
-	{
-		m_freeSlotMarkers.push_back(nullptr);
-		m_freeSlotMarkers[m_freeSlotMarkers.size() - m_dirtyFreeSlotMarkers - 1] = chunk;
-	}
+	//The array is created with as many markers as the pool may ever need, so there is always a dirty one
+	assert(m_dirtyFreeSlotMarkers != 0);
+	const uint32_t markerSlot = (uint32_t)m_freeSlotMarkers.size() - m_dirtyFreeSlotMarkers;
+	m_freeSlotMarkers[markerSlot] = chunk;
+	m_markerSlots[GetChunkIndex(chunk)] = markerSlot;
+	m_dirtyFreeSlotMarkers--;
 }
 
-uint32_t MemoryPool::FindPreceedingSlotMarker(MemoryChunk* chunk) const
+inline void MemoryPool::IndexFreeSlot(MemoryChunk* chunk)
 {
-	assert(m_freeSlotMarkers.size() > m_dirtyFreeSlotMarkers);
-	uint32_t candidate = INVALID_CHUNK_ID;
-	uint32_t candidateDistance = UINT32_MAX;
-	for (int32_t index = (uint32_t)m_freeSlotMarkers.size() - 1u - m_dirtyFreeSlotMarkers; index >= 0; --index)
-	{
-		if (chunk->m_chunkN > m_freeSlotMarkers[index]->m_chunkN &&
-			chunk->m_chunkN - m_freeSlotMarkers[index]->m_chunkN < candidateDistance)
-		{
-			candidateDistance = chunk->m_chunkN - m_freeSlotMarkers[index]->m_chunkN;
-			candidate = index;
-		}
-	}
-	assert(candidate != INVALID_CHUNK_ID);
-	return candidate;
+	if (m_engine == PoolEngine::SegregatedFreeMarkers)
+		m_sizeClasses.Insert(GetChunkIndex(chunk), chunk->GetSlotChunks());
+}
+
+inline void MemoryPool::UnindexFreeSlot(MemoryChunk* chunk)
+{
+	if (m_engine == PoolEngine::SegregatedFreeMarkers)
+		m_sizeClasses.Remove(GetChunkIndex(chunk), chunk->GetSlotChunks());
+}
+
+inline MemoryChunk* MemoryPool::GetSlotStart(MemoryChunk* slotEnd) const
+{
+	//Single chunk slots have no tail, their only chunk is the start
+	return slotEnd->IsTail() ? m_firstChunk + slotEnd->GetSlotStart() : slotEnd;
+}
+
+inline void MemoryPool::SetSlot(MemoryChunk* slotStart, uint32_t chunks, bool used)
+{
+	slotStart->SetSlotHead(chunks, used);
+	if (chunks > 1)
+		(slotStart + chunks - 1)->SetSlotTail(GetChunkIndex(slotStart), used);
+}
+
+inline uint32_t MemoryPool::GetChunkIndex(const MemoryChunk* chunk) const
+{
+	return (uint32_t)(chunk - m_firstChunk);
+}
+
+inline byte* MemoryPool::GetChunkData(const MemoryChunk* chunk) const
+{
+	return m_pool + (size_t)GetChunkIndex(chunk) * m_chunkSize;
+}
+
+inline MemoryChunk* MemoryPool::GetChunkFor(const void* data) const
+{
+	const size_t offset = (size_t)((const byte*)data - m_pool);
+	assert((const byte*)data >= m_pool && offset < (size_t)m_chunkCount * m_chunkSize
+		&& "Attempted to free memory allocated in a diferent pool");
+	assert(offset % m_chunkSize == 0 && "Attempted to free a pointer which is not the start of an allocation");
+	return m_firstChunk + (m_chunkShift != NO_CHUNK_SHIFT ? offset >> m_chunkShift : offset / m_chunkSize);
 }
 
 inline bool MemoryPool::IsFirstChunk(MemoryChunk* chunk) const
 {
-	return chunk->m_chunkN == 0;
+	return chunk == m_firstChunk;
 }
 
 inline bool MemoryPool::IsLastChunk(MemoryChunk* chunk) const
 {
-	return chunk->m_chunkN == m_chunkCount - 1;
+	return chunk == m_firstChunk + m_chunkCount - 1;
+}
+
+inline bool MemoryPool::UsesFreeMarkers() const
+{
+	return m_engine == PoolEngine::FreeMarkers || m_engine == PoolEngine::SegregatedFreeMarkers;
 }
 
 void MemoryPool::NullifyFreeSlotMarker(uint32_t index)
@@ -354,13 +1402,15 @@ void MemoryPool::NullifyFreeSlotMarker(std::vector<MemoryChunk*>::iterator it)
 {
 	uint32_t lastUsedMarker = (uint32_t)(m_freeSlotMarkers.size()) - m_dirtyFreeSlotMarkers - 1;
 	(*it) = m_freeSlotMarkers[lastUsedMarker];
+	m_markerSlots[GetChunkIndex(*it)] = (uint32_t)(it - m_freeSlotMarkers.begin());
 	m_freeSlotMarkers[lastUsedMarker] = nullptr;
 	m_dirtyFreeSlotMarkers++;
 }
 
 bool MemoryPool::IsChunkMarkedAsFreeSlotStart(MemoryChunk* chunk) const
 {
-	if (chunk == nullptr)
+	if (chunk == nullptr || UsesFreeMarkers() == false || chunk->IsUsed() || chunk->IsTail())
 		return false;
-	return chunk->m_avaliableContiguousChunks != 0;
+	const uint32_t markerSlot = m_markerSlots[GetChunkIndex(chunk)];
+	return markerSlot < m_freeSlotMarkers.size() - m_dirtyFreeSlotMarkers && m_freeSlotMarkers[markerSlot] == chunk;
 }
\ No newline at end of file
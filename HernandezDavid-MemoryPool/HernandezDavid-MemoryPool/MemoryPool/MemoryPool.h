@@ -2,10 +2,18 @@
 #define __MEMORYPOOL
 
 #include "PoolPtr.h"
+#include "SizeClassIndex.h"
+#include "ChunkBitmap.h"
+#include "TlsfIndex.h"
+#include "VirtualMemory.h"
 
 #include <vector>
 #include <cstdint>
+#include <cstring>
+#include <new>
 #include <string>
+#include <type_traits>
+#include <utility>
 
 #define INVALID_CHUNK_ID UINT32_MAX
 
@@ -13,10 +21,64 @@ typedef unsigned char byte;
 
 struct MemoryChunk;
 
+//Bookkeeping method used by a pool to find free slots
+enum class PoolEngine
+{
+	//Free slots are found by iterating over all free slot markers
+	FreeMarkers,
+	//Same as FreeMarkers, but markers are also indexed in size class buckets
+	//Finding a free slot doesn't depend on how fragmented the pool is, unless only the class of the request itself is left
+	SegregatedFreeMarkers,
+	//No markers, a bitmap with one bit per chunk keeps track of free chunks
+	//Slots are found by scanning the bitmap, which is small enough to stay in cache
+	Bitmap,
+	//No markers, free slots are kept in two-level segregated fit lists
+	//Alloc and Free never iterate anything, so their worst case cost is bounded
+	Tlsf,
+	//Binary buddy system: slots are rounded up to power of two blocks, aligned on their size
+	//A block's buddy is found by flipping one bit of its chunk index, so merging needs no search
+	Buddy
+};
+
+//How a pool gets more chunks when it runs out of memory
+enum class PoolGrowthPolicy
+{
+	//Adds the same amount of chunks every time
+	Linear,
+	//Doubles the amount of chunks every time
+	Double
+};
+
+//Size of the memory pages behind a pool
+enum class PoolPages
+{
+	//Regular OS pages, usually 4KB
+	Regular,
+	//Huge pages, usually 2MB, for both the data and the chunk metadata
+	//Cuts down TLB misses on big pools accessed all over the place, at the cost of committing memory in 2MB steps
+	Huge
+};
+
+struct PoolGrowth
+{
+	PoolGrowth(uint32_t maxChunkCount = 0u, PoolGrowthPolicy policy = PoolGrowthPolicy::Double, uint32_t stepChunks = 0u)
+		: m_maxChunkCount(maxChunkCount)
+		, m_policy(policy)
+		, m_stepChunks(stepChunks)
+	{}
+
+	//Max amount of chunks the pool may reach. Address space for all of them is reserved up front
+	//The pool never grows if this isn't bigger than its initial chunk count
+	uint32_t m_maxChunkCount;
+	PoolGrowthPolicy m_policy;
+	//Chunks added every time with the linear policy, and minimum amount added with any policy
+	uint32_t m_stepChunks;
+};
+
 /*
 Glossary
 - Memory pool: The class that owns the reserved memory and manages the chunks
-- Chunk: Struct in charge of a small piece of the pool memory
+- Chunk: Small piece of the pool memory, with a 32 bit metadata struct in charge of it
 - Slot: Group of chunks used together when memory required > chunk size.
 	Free slots are the entirety of contiguous free chunks.
 	Used slots are the amount of chunks taken by a single allocation.
@@ -28,34 +90,125 @@ public:
 	MemoryPool(MemoryPool&) = delete;
 	//Less/bigger chunks will result in a quicker execution, but more memory overhead
 	//More/smaller chunks will result in slower execution, but less memory overhead
-	MemoryPool(uint32_t chunkSizeInBytes, uint32_t chunkCount);
+	//Growable pools reserve address space for *growth.m_maxChunkCount* chunks and only commit what they use
+	//Growing never moves memory, so PoolPtrs stay valid
+	//Huge page pools use explicit huge pages if the system has enough of them, otherwise they ask for transparent ones
+	MemoryPool(uint32_t chunkSizeInBytes, uint32_t chunkCount, PoolEngine engine = PoolEngine::FreeMarkers,
+		const PoolGrowth& growth = PoolGrowth(), PoolPages pages = PoolPages::Regular);
+	//Pool over memory owned by someone else, page aligned and big enough for all the chunks
+	//It can't grow, and the memory isn't released with the pool
+	MemoryPool(uint32_t chunkSizeInBytes, uint32_t chunkCount, byte* memory, PoolEngine engine = PoolEngine::FreeMarkers);
 	~MemoryPool();
 
 	//Allocate *bytes* space in the pool of uninitialized memory
 	//PoolPtr will point at the first byte of the stored memory
 	PoolPtr<byte> Alloc(uint32_t bytes);
+	//Same, writing on *usableBytes* the space really allocated, rounded up to whole chunks
+	PoolPtr<byte> Alloc(uint32_t bytes, uint32_t& usableBytes);
 
-	//Allocate enough space for *amount* instances of *type* class
-	//Constructor will be called on all of them
+	//Allocate enough space for *amount* instances of *type* class, aligned as *type* requires
+	//Constructor will be called on all of them. Trivial types are just zeroed
 	template<class type>
 	PoolPtr<type> Alloc(uint32_t amount = 1);
+	//Value initialize *amount* instances of *type* at *data*, as Alloc<type> does. Trivial types are zeroed in one go
+	template<class type>
+	static void ValueInitialize(type* data, uint32_t amount);
+
+	//Allocate and construct a *type*, forwarding *args* to its constructor
+	template<class type, class... Args>
+	PoolPtr<type> New(Args&&... args);
+	//Allocate and construct *amount* instances of *type*, each one from *args*
+	//Without arguments trivial types are left uninitialized
+	//If a constructor throws, the instances already built are destroyed and the memory released
+	template<class type, class... Args>
+	PoolPtr<type> NewArray(uint32_t amount, const Args&... args);
+	//Destroy and release what New or Alloc<type> allocated. Destructors are only called if *type* has a non trivial one
+	template<class type>
+	void Delete(PoolPtr<type>& toDelete);
+	//Same for the *amount* instances allocated by NewArray or Alloc<type>
+	template<class type>
+	void DeleteArray(PoolPtr<type>& toDelete, uint32_t amount);
+
+	//Allocate *bytes* space aligned on *alignment*, a power of two up to the page size
+	//Alignments up to GetChunkAlignment() cost nothing. Bigger ones take a bigger slot and give back what they don't use
+	PoolPtr<byte> AllocAligned(uint32_t bytes, uint32_t alignment);
 
 	//Release previously allocated memory
 	//Will fail if PoolPtr isn't allocated, is allocated on a diferent pool or was already freed
 	template<class type>
 	void Free(PoolPtr<type>& toFree);
 
+	//Resize the allocation of *toResize* to *bytes*, keeping its content
+	//It grows into the free chunks following it when there are enough, and shrinking gives its last chunks back
+	//Otherwise the content is copied to a new allocation. If there is no room for it, returns false and *toResize* is untouched
+	//An invalid *toResize* gets a new allocation
+	bool Realloc(PoolPtr<byte>& toResize, uint32_t bytes);
+	//Same, but never moving the allocation. Returns false if the chunks following it aren't free
+	//Buddy blocks can only grow up to the size of the block holding them
+	bool TryExpandInPlace(PoolPtr<byte>& toResize, uint32_t bytes);
+
+	//Allocate *count* slots of *bytes* space each at once, writing them on *allocations*
+	//Runs of free chunks are carved into as many slots as they fit, so the engine searches once per run instead of once per slot
+	//Returns how many were allocated, which is less than *count* only if the pool is full
+	uint32_t AllocBatch(uint32_t count, uint32_t bytes, PoolPtr<byte>* allocations);
+	//Release *count* allocations at once. Invalid ones are skipped, and all of them are invalidated
+	//They are sorted by address, and neighbouring ones are given back as a single slot
+	void FreeBatch(PoolPtr<byte>* allocations, uint32_t count);
+
+	//Space really allocated for *allocation*, its chunks times the chunk size
+	uint32_t GetUsableSize(const PoolPtrBase& allocation) const;
+
+	//Plain pointer versions of Alloc and Free, to plug the pool into code that doesn't know about PoolPtr
+	//Returns nullptr if there is no slot big enough. Like malloc(0), empty allocations still take a chunk
+	void* Allocate(size_t bytes);
+	void* Allocate(size_t bytes, size_t& usableBytes);
+	void* AllocateAligned(size_t bytes, size_t alignment);
+	//Like realloc: nullptr gets a new allocation, and returns nullptr leaving *memory* allocated if there is no room
+	void* Reallocate(void* memory, size_t bytes);
+	size_t GetUsableSize(const void* memory) const;
+	//The chunk of *memory* is found from its offset in the pool, so nothing is stored next to it
+	//Releasing nullptr does nothing
+	void Deallocate(void* memory);
+	//Same, for callers that know the allocated size. Debug builds check it matches the allocation
+	void Deallocate(void* memory, size_t bytes);
+	uint32_t AllocateBatch(uint32_t count, size_t bytes, void** allocations);
+	//nullptr entries are skipped
+	void DeallocateBatch(void** allocations, uint32_t count);
+
+	//Free every allocation at once, leaving the pool as it was when created, apart from its size if it grew
+	//Allocations aren't walked, so it costs the same however many there are. Destructors are not called
+	//Every PoolPtr and pointer to the pool memory is left dangling. Only debug builds make those PoolPtrs invalid
+	void Reset();
+
 	//Returns pool size un bytes
 	inline uint32_t GetPoolSize() const;
 	//Returns chunk size in bytes
 	inline uint32_t GetChunkSize() const;
+	//Alignment every allocation has, the biggest power of two dividing the chunk size, up to the page size
+	inline uint32_t GetChunkAlignment() const;
 	inline uint32_t GetChunkCount() const;
+	//Amount of chunks the pool may grow up to
+	uint32_t GetMaxChunkCount() const;
+	//Whether *memory* is inside the address space of the pool, including the part it may grow into
+	inline bool Owns(const void* memory) const;
+	//Kind of huge pages actually backing the pool data
+	inline VirtualMemory::HugePages GetHugePages() const { return m_hugePages; }
 
 	//Returns the amount of free chunks in the pool
 	//If memory is fragmented, may not be representative of max alloc size avaliable
 	uint32_t GetFreeChunks() const;
 	//Returns the amount of used chunks
 	uint32_t GetUsedChunks() const;
+	//Returns the amount of bytes used to keep track of the chunks, markers and engine structures
+	size_t GetMetadataSize() const;
+
+	//Give the physical memory behind whole free pages back to the OS, returning the amount of bytes purged
+	//Purged pages stay usable, and get memory behind them again once they're used
+	//Lazy purges let the OS take the memory only when it needs it, which is cheaper but doesn't lower resident memory right away
+	size_t Trim(bool lazy = false);
+	//Purge pages automatically once they have been free for *decayMilliseconds*. 0 disables it
+	//This is checked when memory is freed, so pools that stop freeing memory only purge when Trim is called
+	void SetPurgeDecay(uint32_t decayMilliseconds, bool lazy = false);
 
 
 	//Appends a dump of the raw content of the pool into a file.
@@ -76,21 +229,90 @@ public:
 	void DumpDetailedDebugChunksToFile(const std::string& fileName, const std::string& identifier = "") const;
 
 private:
+	friend class OwnedMemoryPool;
+
+	//Set up the engine bookkeeping, once the chunks and their memory exist
+	void InitEngine();
 	//Release the memory this chunk is holding
 	//Will fail if the chunk is not from this pool or this chunk is not the first in a used slot
 	void Free(MemoryChunk* toFree);
+	//Claim and mark as used a slot of *chunks* chunks, growing the pool if needed. Returns nullptr if there is none
+	inline MemoryChunk* AllocSlot(uint32_t chunks);
+	//Same, for a slot big enough for *bytes* starting on an address aligned on *alignment*
+	MemoryChunk* AllocAlignedSlot(uint32_t bytes, uint32_t alignment);
+	//Turn the used slot starting at *slotStart* into two used slots, the first one of *firstChunks* chunks. Returns the second one
+	MemoryChunk* SplitUsedSlot(MemoryChunk* slotStart, uint32_t firstChunks);
+	//Give the chunks of the used slot starting at *slotStart* past the first *chunks* back to the free memory
+	//Buddy blocks can only give back whole halves, so they may keep a few more
+	void ShrinkUsedSlot(MemoryChunk* slotStart, uint32_t chunks);
+	//Room for *amount* instances of *type*, aligned as it requires and not constructed
+	template<class type>
+	PoolPtr<type> AllocUninitialized(uint32_t amount);
+	//Claim *count* used slots of *chunks* chunks, calling *output(slotStart)* for each of them. Returns how many were claimed
+	template<class Output>
+	uint32_t AllocBatchSlots(uint32_t count, uint32_t chunks, Output output);
+	//Take out of the free memory a run of chunks holding from one up to *maxSlots* slots of *chunks* chunks, returning its first chunk
+	//Writes on *slots* how many it holds, and on *slotStride* the chunks between them, which buddy blocks round up to a power of two
+	MemoryChunk* ClaimSlotRun(uint32_t chunks, uint32_t maxSlots, uint32_t& slots, uint32_t& slotStride);
+	//Free the used slots on m_batchSlots, merging neighbouring ones before giving them back
+	void FreeBatchSlots();
+	//Resize the used slot starting at *slotStart* to *chunks* chunks without moving it. Returns false if it can't grow
+	bool ResizeSlotInPlace(MemoryChunk* slotStart, uint32_t chunks);
+	//Move the allocation starting at *slotStart* to a new slot of *chunks* chunks, copying its content. Returns nullptr if there is no room
+	MemoryChunk* MoveSlot(MemoryChunk* slotStart, uint32_t chunks);
+	//Take *chunks* contiguous free chunks out of the free memory with the pool engine
+	inline MemoryChunk* ClaimSlot(uint32_t chunks);
+	//Grow the pool until a slot of *chunks* chunks can be claimed. Returns nullptr if the max size is reached
+	MemoryChunk* GrowAndClaimSlot(uint32_t chunks);
+	//Commit the memory and metadata of the chunks up to *newChunkCount*, and hand them to the engine as free memory
+	bool AddChunks(uint32_t newChunkCount);
+	//Call *func(firstChunk, chunks)* for every run of contiguous free chunks
+	template<class Func>
+	void ForEachFreeRun(Func func) const;
+	//Purge the pages fully inside free runs. If *onlyDecayed* is set, only the ones free for longer than the purge decay
+	size_t PurgeFreePages(bool onlyDecayed, bool lazy);
+	//Keep track of when pages become free for the decay purging
+	void TrackClaimedPages(uint32_t firstChunk, uint32_t chunks);
+	void TrackReleasedPages(uint32_t firstChunk, uint32_t chunks);
+	static uint64_t GetDecayClock();
+	//Take *chunks* contiguous free chunks out of the free memory, returning the first of them
+	//Returns nullptr if there is no slot big enough
+	MemoryChunk* ClaimFreeMarkerSlot(uint32_t chunks);
+	MemoryChunk* ClaimBitmapSlot(uint32_t chunks);
+	MemoryChunk* ClaimTlsfSlot(uint32_t chunks);
+	MemoryChunk* ClaimBuddySlot(uint32_t chunks);
+	//Take the first *chunks* chunks out of the known free slot starting at *slotStart*
+	MemoryChunk* ClaimFromFreeMarkerSlot(uint32_t freeSlotIndex, uint32_t chunks);
+	MemoryChunk* ClaimFromTlsfSlot(uint32_t slotStart, uint32_t chunks);
+	//Give back the used slot from *toFree* to *lastChunk* to the free markers, merging it with its free neighbours
+	void ReleaseFreeMarkerSlot(MemoryChunk* toFree, MemoryChunk* lastChunk);
+	//Give back the used slot from *toFree* to *lastChunk* to the TLSF lists, merging it with its free neighbours
+	void ReleaseTlsfSlot(MemoryChunk* toFree, MemoryChunk* lastChunk);
+	//Give back the block holding the used slot starting at *toFree*, merging it with its buddies while they are free
+	void ReleaseBuddySlot(MemoryChunk* toFree);
 	//Find a free slot with at least *requiredChunks* of contiguous avaliable chunks
 	uint32_t FindSlotFor(uint32_t requiredChunks) const;
 	//Calculate the amount of chunks needed to fit *bytesOfSpace*
 	uint32_t ChunksToFit(uint32_t bytesOfSpace) const;
 	//Add a new Free slot marker onto the chunk
 	void AddFreeSlotMarker(MemoryChunk* chunk);
-	//Find the "Free slot marker" inmediately preceeding the requested chunk
-	//Will assert if no slot is avaliable for the requested chunk
-	uint32_t FindPreceedingSlotMarker(MemoryChunk* chunk) const;
+	//Keep the size class buckets up to date when the free slot starting at *chunk* appears or disappears
+	//Does nothing unless the pool uses the segregated engine
+	inline void IndexFreeSlot(MemoryChunk* chunk);
+	inline void UnindexFreeSlot(MemoryChunk* chunk);
+	//Find the first chunk of a free or used slot from its last chunk, using the boundary tag stored there
+	inline MemoryChunk* GetSlotStart(MemoryChunk* slotEnd) const;
+	//Write the first and last chunk metadata of a slot of *chunks* chunks
+	inline void SetSlot(MemoryChunk* slotStart, uint32_t chunks, bool used);
 
+	inline uint32_t GetChunkIndex(const MemoryChunk* chunk) const;
+	inline byte* GetChunkData(const MemoryChunk* chunk) const;
+	//Chunk holding *data*, found with a shift or a division of its offset in the pool
+	inline MemoryChunk* GetChunkFor(const void* data) const;
 	inline bool IsFirstChunk(MemoryChunk* chunk) const;
 	inline bool IsLastChunk(MemoryChunk* chunk) const;
+	//Whether the engine keeps track of free slots with free slot markers
+	inline bool UsesFreeMarkers() const;
 
 	//Erase the slot marker with the passed index
 	void NullifyFreeSlotMarker(uint32_t index);
@@ -104,34 +326,174 @@ private:
 
 	std::vector<MemoryChunk*> m_freeSlotMarkers;
 	uint32_t m_dirtyFreeSlotMarkers;
+	//Parallel to the chunks: index in m_freeSlotMarkers of every free slot start
+	std::vector<uint32_t> m_markerSlots;
+
+	PoolEngine m_engine;
+	//Size class buckets of the segregated engine, also used as the per order free lists of the buddy engine
+	SizeClassIndex m_sizeClasses;
+	ChunkBitmap m_chunkBitmap;
+	TlsfIndex m_tlsf;
+	//Scratch space of FreeBatch, kept to not allocate on every batch
+	std::vector<MemoryChunk*> m_batchSlots;
 
 	uint32_t m_chunkCount;
 	uint32_t m_chunkSize;
+	//Log2 of the chunk size if it's a power of two, so chunks are found from addresses with a shift
+	uint32_t m_chunkShift;
+
+	PoolGrowth m_growth;
+	uint32_t m_maxChunkCount;
+	//Whether the chunk metadata lives in reserved address space instead of the heap, so it can grow or use huge pages
+	bool m_reservedMemory;
+	//Whether the pool data belongs to someone else
+	bool m_externalMemory;
+	//Granularity memory is committed and purged with: the regular or huge page size
+	size_t m_pageSize;
+	VirtualMemory::HugePages m_hugePages;
+
+	//Decay purging, in milliseconds
+	uint32_t m_purgeDecay;
+	bool m_lazyPurge;
+	//Time every page of the pool data became free, or PAGE_NOT_FREE / PAGE_PURGED. Only used with decay purging
+	std::vector<uint64_t> m_pageFreeSince;
+	uint64_t m_lastDecayPurge;
 
 	byte* m_pool;
 };
 
+inline uint32_t MemoryPool::GetPoolSize() const
+{
+	return m_chunkCount * m_chunkSize;
+}
+
+inline uint32_t MemoryPool::GetChunkSize() const
+{
+	return m_chunkSize;
+}
+
+inline uint32_t MemoryPool::GetChunkAlignment() const
+{
+	const uint32_t alignment = m_chunkSize & (~m_chunkSize + 1u);
+	return (alignment < m_pageSize ? alignment : (uint32_t)m_pageSize);
+}
+
+inline uint32_t MemoryPool::GetChunkCount() const
+{
+	return m_chunkCount;
+}
+
+inline bool MemoryPool::Owns(const void* memory) const
+{
+	return (const byte*)memory >= m_pool && (const byte*)memory < m_pool + (size_t)m_maxChunkCount * m_chunkSize;
+}
+
 template<class type>
-inline PoolPtr<type> MemoryPool::Alloc(uint32_t amount)
+inline PoolPtr<type> MemoryPool::AllocUninitialized(uint32_t amount)
 {
+	//The size would be truncated to 32 bits
+	if ((uint64_t)sizeof(type) * amount > UINT32_MAX)
+		return PoolPtr<type>(nullptr);
+	PoolPtr<byte> allocation = (alignof(type) <= GetChunkAlignment()
+		? Alloc(sizeof(type) * amount)
+		: AllocAligned(sizeof(type) * amount, alignof(type)));
 #ifdef _DEBUG
-	PoolPtr<type> ret(Alloc(sizeof(type) * amount).m_chunk, amount);
+	return PoolPtr<type>(allocation.m_chunk, allocation.m_data, amount);
 #else
-	PoolPtr<type> ret(Alloc(sizeof(type) * amount).m_chunk);
+	return PoolPtr<type>(allocation.m_chunk, allocation.m_data);
 #endif
+}
+
+template<class type>
+inline PoolPtr<type> MemoryPool::Alloc(uint32_t amount)
+{
+	PoolPtr<type> ret = AllocUninitialized<type>(amount);
 	if (ret.IsValid())
+		ValueInitialize(ret.GetData(), amount);
+	return ret;
+}
+
+template<class type>
+inline void MemoryPool::ValueInitialize(type* data, uint32_t amount)
+{
+	//Value initializing a trivial type only zeroes it, which is done in one go
+	if (std::is_trivially_default_constructible<type>::value)
+		memset((void*)data, 0, sizeof(type) * amount);
+	else
 	{
-		type* chunkData = ret.GetData();
 		for (uint32_t n = 0; n < amount; n++)
 		{
 			//Calling constructor of "type" with a placement new
-			new(chunkData) type();
-			chunkData ++;
+			new(data) type();
+			data ++;
+		}
+	}
+}
+
+template<class type, class... Args>
+inline PoolPtr<type> MemoryPool::New(Args&&... args)
+{
+	PoolPtr<type> ret = AllocUninitialized<type>(1);
+	if (ret.IsValid())
+	{
+		try
+		{
+			new(ret.GetData()) type(std::forward<Args>(args)...);
+		}
+		catch (...)
+		{
+			Free(ret);
+			throw;
 		}
 	}
 	return ret;
 }
 
+template<class type, class... Args>
+inline PoolPtr<type> MemoryPool::NewArray(uint32_t amount, const Args&... args)
+{
+	PoolPtr<type> ret = AllocUninitialized<type>(amount);
+	if (ret.IsValid() == false || (sizeof...(Args) == 0 && std::is_trivially_default_constructible<type>::value))
+		return ret;
+
+	type* chunkData = ret.GetData();
+	uint32_t constructed = 0;
+	try
+	{
+		for (; constructed < amount; constructed++)
+			new(chunkData + constructed) type(args...);
+	}
+	catch (...)
+	{
+		for (uint32_t n = 0; n < constructed; n++)
+			chunkData[n].~type();
+		Free(ret);
+		throw;
+	}
+	return ret;
+}
+
+template<class type>
+inline void MemoryPool::Delete(PoolPtr<type>& toDelete)
+{
+	DeleteArray(toDelete, 1);
+}
+
+template<class type>
+inline void MemoryPool::DeleteArray(PoolPtr<type>& toDelete, uint32_t amount)
+{
+#ifdef _DEBUG
+	assert((toDelete.IsValid() == false || toDelete.m_allocatedInstances == amount) && "Deleted amount doesn't match the allocated one");
+#endif
+	if (std::is_trivially_destructible<type>::value == false && toDelete.IsValid())
+	{
+		type* chunkData = toDelete.GetData();
+		for (uint32_t n = 0; n < amount; n++)
+			chunkData[n].~type();
+	}
+	Free(toDelete);
+}
+
 template<class type>
 inline void MemoryPool::Free(PoolPtr<type>& toFree)
 {
@@ -139,6 +501,7 @@ inline void MemoryPool::Free(PoolPtr<type>& toFree)
 		Free(toFree.m_chunk);
 	//Mark as invalid the released PoolPtr
 	toFree.m_chunk = nullptr;
+	toFree.m_data = nullptr;
 }
 
 #endif // !__MEMORYCHUNK
\ No newline at end of file
@@ -0,0 +1,134 @@
+#ifndef __OBJECTPOOL
+#define __OBJECTPOOL
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+#include <assert.h>
+
+/*
+Pool of objects of a single type, all of them in one contiguous buffer
+- Free slots are kept in an intrusive singly linked list threaded through the slots themselves
+- Slots that were never used are handed out in order, so creating the pool doesn't touch its memory
+Acquire and Release are O(1) and never search for anything
+
+With *recycleObjects* set, released objects are not destroyed, and acquiring gives back an already
+built object as it was left. Its constructor only runs the first time a slot is used, and all
+objects are destroyed with the pool. Useful for objects that are expensive to build
+*/
+template<class T, bool recycleObjects = false>
+class ObjectPool
+{
+	static_assert(alignof(T) <= alignof(std::max_align_t), "Over-aligned types are not supported by ObjectPool");
+public:
+	ObjectPool(ObjectPool&) = delete;
+	ObjectPool(uint32_t objectCount);
+	~ObjectPool();
+
+	//Get an object out of the pool, or nullptr if the pool is full
+	//Arguments are passed to the constructor. When recycling objects, they are only used for objects built for the first time
+	template<class... Args>
+	T* Acquire(Args&&... args);
+
+	//Give back an object acquired from this pool
+	//Its destructor is called unless the pool recycles objects
+	void Release(T* object);
+
+	inline uint32_t GetCapacity() const { return m_objectCount; }
+	inline uint32_t GetLiveObjects() const { return m_liveObjects; }
+
+private:
+	//While a slot is free, its first bytes link it to the next free one
+	//Recycled objects are still alive when free, so their link is kept in front of them instead
+	struct FreeSlot
+	{
+		FreeSlot* m_next;
+	};
+
+	static const size_t OBJECT_OFFSET = (recycleObjects
+		? (sizeof(FreeSlot) + alignof(T) - 1) / alignof(T) * alignof(T)
+		: 0u);
+	static const size_t SLOT_ALIGNMENT = (alignof(T) > alignof(FreeSlot) ? alignof(T) : alignof(FreeSlot));
+	static const size_t SLOT_SIZE = ((OBJECT_OFFSET + (sizeof(T) > sizeof(FreeSlot) ? sizeof(T) : sizeof(FreeSlot)))
+		+ SLOT_ALIGNMENT - 1) / SLOT_ALIGNMENT * SLOT_ALIGNMENT;
+
+	inline unsigned char* GetSlot(uint32_t slotN) const { return m_pool + SLOT_SIZE * slotN; }
+
+private:
+	unsigned char* m_pool;
+	FreeSlot* m_freeSlots;
+
+	//Slots before this one have been handed out at least once
+	uint32_t m_usedSlots;
+	uint32_t m_liveObjects;
+	uint32_t m_objectCount;
+};
+
+template<class T, bool recycleObjects>
+inline ObjectPool<T, recycleObjects>::ObjectPool(uint32_t objectCount)
+	: m_pool(nullptr)
+	, m_freeSlots(nullptr)
+	, m_usedSlots(0u)
+	, m_liveObjects(0u)
+	, m_objectCount(objectCount)
+{
+	assert(objectCount != 0);
+	m_pool = new unsigned char[SLOT_SIZE * objectCount];
+}
+
+template<class T, bool recycleObjects>
+inline ObjectPool<T, recycleObjects>::~ObjectPool()
+{
+	//Checking all objects have been released
+	assert(m_liveObjects == 0 && "ObjectPool destroyed with objects still in use");
+
+	//Recycled objects are still alive, they are destroyed with the pool
+	if (recycleObjects)
+	{
+		for (uint32_t n = 0; n < m_usedSlots; ++n)
+			((T*)(GetSlot(n) + OBJECT_OFFSET))->~T();
+	}
+	delete[] m_pool;
+}
+
+template<class T, bool recycleObjects>
+template<class... Args>
+inline T* ObjectPool<T, recycleObjects>::Acquire(Args&&... args)
+{
+	FreeSlot* slot = m_freeSlots;
+	if (slot != nullptr)
+	{
+		m_freeSlots = slot->m_next;
+		m_liveObjects++;
+		if (recycleObjects)
+			return (T*)((unsigned char*)slot + OBJECT_OFFSET);
+		return new((unsigned char*)slot + OBJECT_OFFSET) T(std::forward<Args>(args)...);
+	}
+
+	if (m_usedSlots == m_objectCount)
+		return nullptr;
+
+	m_liveObjects++;
+	return new(GetSlot(m_usedSlots++) + OBJECT_OFFSET) T(std::forward<Args>(args)...);
+}
+
+template<class T, bool recycleObjects>
+inline void ObjectPool<T, recycleObjects>::Release(T* object)
+{
+	unsigned char* slot = (unsigned char*)object - OBJECT_OFFSET;
+	//Checking the object belongs to this pool and is the start of a slot
+	assert(object != nullptr && slot >= m_pool && slot < GetSlot(m_usedSlots)
+		&& (size_t)(slot - m_pool) % SLOT_SIZE == 0
+		&& "Attempted to release an object not acquired from this pool");
+
+	if (recycleObjects == false)
+		object->~T();
+
+	FreeSlot* freeSlot = (FreeSlot*)slot;
+	freeSlot->m_next = m_freeSlots;
+	m_freeSlots = freeSlot;
+	m_liveObjects--;
+}
+
+#endif // !__OBJECTPOOL
\ No newline at end of file
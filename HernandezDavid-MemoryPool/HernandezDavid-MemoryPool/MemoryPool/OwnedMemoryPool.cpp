@@ -0,0 +1,65 @@
+#include "OwnedMemoryPool.h"
+#include "MemoryChunk.h"
+
+#include <assert.h>
+
+OwnedMemoryPool::OwnedMemoryPool(uint32_t chunkSizeInBytes, uint32_t chunkCount, PoolEngine engine, const PoolGrowth& growth)
+	: m_pool(chunkSizeInBytes, chunkCount, engine, growth)
+	, m_owner(std::this_thread::get_id())
+	, m_remoteFrees(INVALID_CHUNK_ID)
+	, m_nextRemoteFree(nullptr)
+{
+	//Sized for the biggest the pool can get, since other threads may be pushing while it grows
+	m_nextRemoteFree = new std::atomic<uint32_t>[m_pool.GetMaxChunkCount()];
+}
+
+OwnedMemoryPool::~OwnedMemoryPool()
+{
+	//Whoever destroys the pool owns it from now on, and frees what other threads left behind
+	TakeOwnership();
+	DrainRemoteFrees();
+	delete[] m_nextRemoteFree;
+}
+
+PoolPtr<byte> OwnedMemoryPool::Alloc(uint32_t bytes)
+{
+	assert(IsOwner() && "Only the owner thread can allocate from an OwnedMemoryPool");
+	if (m_remoteFrees.load(std::memory_order_relaxed) != INVALID_CHUNK_ID)
+		DrainRemoteFrees();
+	return m_pool.Alloc(bytes);
+}
+
+uint32_t OwnedMemoryPool::DrainRemoteFrees()
+{
+	assert(IsOwner() && "Only the owner thread can drain the remote frees of an OwnedMemoryPool");
+	//Taking the whole list at once. Slots freed from now on start a new one
+	uint32_t chunkN = m_remoteFrees.exchange(INVALID_CHUNK_ID, std::memory_order_acquire);
+	if (chunkN == INVALID_CHUNK_ID)
+		return 0u;
+
+	//Released as a single batch, so slots next to each other are merged before going back to the engine
+	m_pool.m_batchSlots.clear();
+	for (; chunkN != INVALID_CHUNK_ID; chunkN = m_nextRemoteFree[chunkN].load(std::memory_order_relaxed))
+		m_pool.m_batchSlots.push_back(m_pool.m_firstChunk + chunkN);
+	const uint32_t freedSlots = (uint32_t)m_pool.m_batchSlots.size();
+	m_pool.FreeBatchSlots();
+	return freedSlots;
+}
+
+void OwnedMemoryPool::Free(MemoryChunk* chunk)
+{
+	if (IsOwner())
+		m_pool.Free(chunk);
+	else
+		PushRemoteFree((uint32_t)(chunk - m_pool.m_firstChunk));
+}
+
+void OwnedMemoryPool::PushRemoteFree(uint32_t chunkN)
+{
+	//Only the owner takes slots out, and always the whole list, so a plain CAS push has no ABA problem
+	uint32_t lastFree = m_remoteFrees.load(std::memory_order_relaxed);
+	do
+	{
+		m_nextRemoteFree[chunkN].store(lastFree, std::memory_order_relaxed);
+	} while (m_remoteFrees.compare_exchange_weak(lastFree, chunkN, std::memory_order_release, std::memory_order_relaxed) == false);
+}
\ No newline at end of file
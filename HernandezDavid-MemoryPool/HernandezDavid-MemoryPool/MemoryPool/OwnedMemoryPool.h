@@ -0,0 +1,82 @@
+#ifndef __OWNEDMEMORYPOOL
+#define __OWNEDMEMORYPOOL
+
+#include "MemoryPool.h"
+
+#include <atomic>
+#include <thread>
+#include <cstdint>
+
+/*
+MemoryPool owned by a single thread, which is the only one allowed to allocate from it
+Any thread can free its memory:
+- The owner frees it right away, exactly like MemoryPool
+- Other threads push the slot to a lock-free list of remote frees, without touching the pool
+The owner drains that list on its next Alloc, freeing all of its slots as one batch like FreeBatch, so neighbours are merged first
+Remote frees are linked through an array of chunk indices, so freed memory isn't written and any chunk size works
+*/
+class OwnedMemoryPool
+{
+public:
+	OwnedMemoryPool(OwnedMemoryPool&) = delete;
+	//The calling thread becomes the owner
+	OwnedMemoryPool(uint32_t chunkSizeInBytes, uint32_t chunkCount, PoolEngine engine = PoolEngine::Tlsf,
+		const PoolGrowth& growth = PoolGrowth());
+	//Can be destroyed from any thread, once no other thread may free memory anymore
+	~OwnedMemoryPool();
+
+	//Allocate *bytes* space in the pool of uninitialized memory. Only the owner thread may call it
+	PoolPtr<byte> Alloc(uint32_t bytes);
+
+	//Allocate enough space for *amount* instances of *type* class. Only the owner thread may call it
+	//Constructor will be called on all of them
+	template<class type>
+	PoolPtr<type> Alloc(uint32_t amount = 1);
+
+	//Release previously allocated memory, from any thread
+	template<class type>
+	void Free(PoolPtr<type>& toFree);
+
+	//Free the memory released by other threads so far. Only the owner thread may call it
+	//Alloc already does it, this is for owners that stop allocating for a while. Returns the amount of slots freed
+	uint32_t DrainRemoteFrees();
+
+	//Make the calling thread the owner, for pools created by one thread and handed to another
+	inline void TakeOwnership() { m_owner = std::this_thread::get_id(); }
+	inline bool IsOwner() const { return std::this_thread::get_id() == m_owner; }
+
+	//The pool itself, only to be used by the owner thread
+	inline MemoryPool& GetPool() { return m_pool; }
+
+private:
+	void Free(MemoryChunk* chunk);
+	void PushRemoteFree(uint32_t chunkN);
+
+private:
+	MemoryPool m_pool;
+	std::thread::id m_owner;
+
+	//Last slot freed by another thread, and the one freed before it for every slot on the list
+	std::atomic<uint32_t> m_remoteFrees;
+	std::atomic<uint32_t>* m_nextRemoteFree;
+};
+
+template<class type>
+inline PoolPtr<type> OwnedMemoryPool::Alloc(uint32_t amount)
+{
+	if (m_remoteFrees.load(std::memory_order_relaxed) != INVALID_CHUNK_ID)
+		DrainRemoteFrees();
+	return m_pool.Alloc<type>(amount);
+}
+
+template<class type>
+inline void OwnedMemoryPool::Free(PoolPtr<type>& toFree)
+{
+	if (toFree.IsValid())
+		Free(toFree.m_chunk);
+	//Mark as invalid the released PoolPtr
+	toFree.m_chunk = nullptr;
+	toFree.m_data = nullptr;
+}
+
+#endif // !__OWNEDMEMORYPOOL
\ No newline at end of file
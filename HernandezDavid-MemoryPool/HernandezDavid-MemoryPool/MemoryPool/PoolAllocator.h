@@ -0,0 +1,80 @@
+#ifndef __POOLALLOCATOR
+#define __POOLALLOCATOR
+
+#include "MemoryPool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+
+/*
+Standard allocator drawing from a MemoryPool, so containers can keep their nodes and buffers in it
+	std::map<int, int, std::less<int>, PoolAllocator<std::pair<const int, int>>> map(PoolAllocator<std::pair<const int, int>>(pool));
+- Copies and rebound copies share the same pool, and compare equal only if they do
+- It's propagated on copy, move and swap, so memory always goes back to the pool it came from
+- Throws std::bad_alloc when the pool is full, as containers expect
+The pool isn't owned, and must outlive every container using it
+*/
+template<class T>
+class PoolAllocator
+{
+public:
+	typedef T value_type;
+	typedef std::true_type propagate_on_container_copy_assignment;
+	typedef std::true_type propagate_on_container_move_assignment;
+	typedef std::true_type propagate_on_container_swap;
+	typedef std::false_type is_always_equal;
+
+	template<class U>
+	struct rebind
+	{
+		typedef PoolAllocator<U> other;
+	};
+
+	explicit PoolAllocator(MemoryPool& pool) noexcept : m_pool(&pool) {}
+	template<class U>
+	PoolAllocator(const PoolAllocator<U>& other) noexcept : m_pool(&other.GetPool()) {}
+
+	T* allocate(size_t count);
+	void deallocate(T* memory, size_t count) noexcept;
+
+	inline MemoryPool& GetPool() const noexcept { return *m_pool; }
+
+private:
+	MemoryPool* m_pool;
+};
+
+template<class T, class U>
+inline bool operator==(const PoolAllocator<T>& a, const PoolAllocator<U>& b) noexcept
+{
+	return &a.GetPool() == &b.GetPool();
+}
+
+template<class T, class U>
+inline bool operator!=(const PoolAllocator<T>& a, const PoolAllocator<U>& b) noexcept
+{
+	return !(a == b);
+}
+
+template<class T>
+inline T* PoolAllocator<T>::allocate(size_t count)
+{
+	if (count > UINT32_MAX / sizeof(T))
+		throw std::bad_alloc();
+	//Allocations are already aligned on the chunk alignment, only over-aligned types need more
+	void* memory = (alignof(T) <= m_pool->GetChunkAlignment()
+		? m_pool->Allocate(count * sizeof(T))
+		: m_pool->AllocateAligned(count * sizeof(T), alignof(T)));
+	if (memory == nullptr)
+		throw std::bad_alloc();
+	return static_cast<T*>(memory);
+}
+
+template<class T>
+inline void PoolAllocator<T>::deallocate(T* memory, size_t count) noexcept
+{
+	m_pool->Deallocate(memory, count * sizeof(T));
+}
+
+#endif // !__POOLALLOCATOR
\ No newline at end of file
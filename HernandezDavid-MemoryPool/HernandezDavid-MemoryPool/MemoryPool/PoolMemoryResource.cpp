@@ -0,0 +1,50 @@
+#include "PoolMemoryResource.h"
+#include "VirtualMemory.h"
+
+#include <cstring>
+#include <new>
+#include <assert.h>
+
+PoolMemoryResource::PoolMemoryResource(MemoryPool& pool)
+	: m_pool(&pool)
+	, m_pageSize(VirtualMemory::GetPageSize())
+{
+}
+
+void* PoolMemoryResource::do_allocate(size_t bytes, size_t alignment)
+{
+	assert(alignment != 0u && (alignment & (alignment - 1u)) == 0u && "Alignment must be a power of two");
+	if (alignment <= m_pageSize)
+	{
+		void* memory = m_pool->AllocateAligned(bytes, alignment);
+		if (memory == nullptr)
+			throw std::bad_alloc();
+		return memory;
+	}
+
+	byte* memory = (byte*)m_pool->Allocate(GetPaddedSize(bytes, alignment));
+	if (memory == nullptr)
+		throw std::bad_alloc();
+	byte* aligned = (byte*)(((uintptr_t)memory + sizeof(uint32_t) + alignment - 1u) & ~(uintptr_t)(alignment - 1u));
+	const uint32_t offset = (uint32_t)(aligned - memory);
+	memcpy(aligned - sizeof(uint32_t), &offset, sizeof(uint32_t));
+	return aligned;
+}
+
+void PoolMemoryResource::do_deallocate(void* memory, size_t bytes, size_t alignment)
+{
+	if (alignment <= m_pageSize)
+	{
+		m_pool->Deallocate(memory, bytes);
+		return;
+	}
+
+	uint32_t offset;
+	memcpy(&offset, (byte*)memory - sizeof(uint32_t), sizeof(uint32_t));
+	m_pool->Deallocate((byte*)memory - offset, GetPaddedSize(bytes, alignment));
+}
+
+bool PoolMemoryResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+	return this == &other;
+}
\ No newline at end of file
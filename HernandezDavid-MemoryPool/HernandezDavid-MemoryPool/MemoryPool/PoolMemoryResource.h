@@ -0,0 +1,40 @@
+#ifndef __POOLMEMORYRESOURCE
+#define __POOLMEMORYRESOURCE
+
+#include "MemoryPool.h"
+
+#include <cstddef>
+#include <memory_resource>
+
+/*
+Polymorphic memory resource serving its memory from a MemoryPool, for std::pmr containers
+	std::pmr::vector<int> vector(&resource);
+It can also be the upstream of the standard pool and monotonic resources, which then take their buffers from the pool
+- Alignments up to a page are served straight from the pool, which aligns the slots itself
+- Bigger alignments get a bigger allocation, with the distance to its start stored right before the aligned address
+- Throws std::bad_alloc when the pool is full
+Two resources are only equal if they are the same object. The pool isn't owned, and must outlive the resource
+*/
+class PoolMemoryResource : public std::pmr::memory_resource
+{
+public:
+	explicit PoolMemoryResource(MemoryPool& pool);
+
+	inline MemoryPool& GetPool() const { return *m_pool; }
+
+protected:
+	void* do_allocate(size_t bytes, size_t alignment) override;
+	void do_deallocate(void* memory, size_t bytes, size_t alignment) override;
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+private:
+	//Bytes taken from the pool for an over-aligned allocation
+	static inline size_t GetPaddedSize(size_t bytes, size_t alignment) { return bytes + alignment - 1 + sizeof(uint32_t); }
+
+private:
+	MemoryPool* m_pool;
+	//Biggest alignment the pool can give its slots
+	size_t m_pageSize;
+};
+
+#endif // !__POOLMEMORYRESOURCE
\ No newline at end of file
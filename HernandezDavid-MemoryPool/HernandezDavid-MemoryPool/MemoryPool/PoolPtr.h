@@ -10,16 +10,16 @@ template<typename T>
 class PoolPtr : public PoolPtrBase
 {
 public:
-	PoolPtr(MemoryChunk* referencedChunk = nullptr)
-		: PoolPtrBase(referencedChunk)
+	PoolPtr(MemoryChunk* referencedChunk = nullptr, void* data = nullptr)
+		: PoolPtrBase(referencedChunk, data)
 #ifdef _DEBUG
 		, m_allocatedInstances(0u)
 #endif
 	{}
 
 #ifdef _DEBUG
-	PoolPtr(MemoryChunk* referencedChunk, unsigned int allocatedInstances)
-		: PoolPtrBase(referencedChunk)
+	PoolPtr(MemoryChunk* referencedChunk, void* data, unsigned int allocatedInstances)
+		: PoolPtrBase(referencedChunk, data)
 		, m_allocatedInstances(allocatedInstances)
 	{}
 
@@ -1,25 +1,26 @@
 #include "MemoryChunk.h"
 #include "PoolPtrBase.h"
 
-PoolPtrBase::PoolPtrBase(MemoryChunk* referencedChunk)
+PoolPtrBase::PoolPtrBase(MemoryChunk* referencedChunk, void* data)
 	: m_chunk(referencedChunk)
+	, m_data(data)
 {}
 
 bool PoolPtrBase::IsValid() const
 {
-	return m_chunk && m_chunk->m_usedChunks != 0;
+	return m_chunk && m_chunk->IsHeader();
 }
 
 void* PoolPtrBase::GetRawData()
 {
 	if (IsValid())
-		return m_chunk->m_data;
+		return m_data;
 	return nullptr;
 }
 
 const void* PoolPtrBase::GetRawData() const
 {
 	if (IsValid())
-		return m_chunk->m_data;
+		return m_data;
 	return nullptr;
 }
\ No newline at end of file
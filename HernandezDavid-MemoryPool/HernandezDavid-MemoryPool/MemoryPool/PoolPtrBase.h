@@ -6,7 +6,7 @@ struct MemoryChunk;
 class PoolPtrBase
 {
 public:
-	PoolPtrBase(MemoryChunk* referencedChunk);
+	PoolPtrBase(MemoryChunk* referencedChunk, void* data);
 
 	bool IsValid() const;
 protected:
@@ -14,7 +14,13 @@ protected:
 	const void* GetRawData() const;
 private:
 	friend class MemoryPool;
+	friend class ThreadCachedPool;
+	friend class ConcurrentMemoryPool;
+	friend class OwnedMemoryPool;
+	//Chunk metadata is used to know if the allocation is still alive
+	//The data pointer is kept too, since chunks don't store it anymore
 	MemoryChunk* m_chunk;
+	void* m_data;
 };
 
 #endif // !__POOLPTRBASE
\ No newline at end of file
@@ -0,0 +1,74 @@
+#include "PoolRegistry.h"
+
+#include <algorithm>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+#include <assert.h>
+
+//Generation 0 is never current, so the empty remembered pools never match
+thread_local PoolRegistry::FoundPool PoolRegistry::s_lastFound = { 0u, 0u, nullptr, 0u };
+std::atomic<uint64_t> PoolRegistry::s_generation(1u);
+
+namespace
+{
+	struct RegisteredPool
+	{
+		uintptr_t m_begin;
+		uintptr_t m_end;
+		MemoryPool* m_pool;
+	};
+
+	//Built on first use, since pools may be created by other static constructors
+	std::shared_mutex& GetRegistryMutex()
+	{
+		static std::shared_mutex registryMutex;
+		return registryMutex;
+	}
+
+	//Sorted by address. Pools never overlap, so the only one that may hold an address is the last one starting before it
+	std::vector<RegisteredPool>& GetRegisteredPools()
+	{
+		static std::vector<RegisteredPool> registeredPools;
+		return registeredPools;
+	}
+}
+
+void PoolRegistry::Register(MemoryPool& pool, const void* memory, size_t bytes)
+{
+	const RegisteredPool registered = { (uintptr_t)memory, (uintptr_t)memory + bytes, &pool };
+	std::unique_lock<std::shared_mutex> lock(GetRegistryMutex());
+	std::vector<RegisteredPool>& pools = GetRegisteredPools();
+	std::vector<RegisteredPool>::iterator position = std::upper_bound(pools.begin(), pools.end(), registered,
+		[](const RegisteredPool& a, const RegisteredPool& b) { return a.m_begin < b.m_begin; });
+	assert((position == pools.end() || position->m_begin >= registered.m_end)
+		&& (position == pools.begin() || (position - 1)->m_end <= registered.m_begin) && "Pools can't overlap");
+	pools.insert(position, registered);
+}
+
+void PoolRegistry::Unregister(MemoryPool& pool)
+{
+	std::unique_lock<std::shared_mutex> lock(GetRegistryMutex());
+	std::vector<RegisteredPool>& pools = GetRegisteredPools();
+	std::vector<RegisteredPool>::iterator position = std::find_if(pools.begin(), pools.end(),
+		[&pool](const RegisteredPool& registered) { return registered.m_pool == &pool; });
+	assert(position != pools.end() && "Unregistering a pool that wasn't registered");
+	if (position != pools.end())
+		pools.erase(position);
+	s_generation.fetch_add(1u, std::memory_order_release);
+}
+
+MemoryPool* PoolRegistry::FindOwnerSlow(const void* memory)
+{
+	const uintptr_t address = (uintptr_t)memory;
+	std::shared_lock<std::shared_mutex> lock(GetRegistryMutex());
+	const std::vector<RegisteredPool>& pools = GetRegisteredPools();
+	std::vector<RegisteredPool>::const_iterator position = std::upper_bound(pools.begin(), pools.end(), address,
+		[](uintptr_t searched, const RegisteredPool& registered) { return searched < registered.m_begin; });
+	if (position == pools.begin() || address >= (position - 1)->m_end)
+		return nullptr;
+
+	--position;
+	s_lastFound = { position->m_begin, position->m_end, position->m_pool, s_generation.load(std::memory_order_relaxed) };
+	return position->m_pool;
+}
\ No newline at end of file
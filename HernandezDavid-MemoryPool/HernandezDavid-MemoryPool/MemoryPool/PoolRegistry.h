@@ -0,0 +1,51 @@
+#ifndef __POOLREGISTRY
+#define __POOLREGISTRY
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+class MemoryPool;
+
+/*
+Address space of every live MemoryPool, to find the pool some memory belongs to from the memory alone
+Handles that don't want to carry their pool around, like UniquePoolPtr, free through it
+Every thread remembers the last pool it found, which is checked first with a couple of comparisons
+The remembered pool is forgotten whenever any pool is destroyed, since another one could take its addresses
+*/
+class PoolRegistry
+{
+public:
+	//Called by the pools themselves when they are created and destroyed
+	static void Register(MemoryPool& pool, const void* memory, size_t bytes);
+	static void Unregister(MemoryPool& pool);
+
+	//Pool whose address space holds *memory*, or nullptr if there is none
+	static inline MemoryPool* FindOwner(const void* memory);
+
+private:
+	static MemoryPool* FindOwnerSlow(const void* memory);
+
+	struct FoundPool
+	{
+		uintptr_t m_begin;
+		uintptr_t m_end;
+		MemoryPool* m_pool;
+		uint64_t m_generation;
+	};
+	static thread_local FoundPool s_lastFound;
+	//Increased every time a pool is unregistered
+	static std::atomic<uint64_t> s_generation;
+};
+
+inline MemoryPool* PoolRegistry::FindOwner(const void* memory)
+{
+	const uintptr_t address = (uintptr_t)memory;
+	const FoundPool& lastFound = s_lastFound;
+	if (address >= lastFound.m_begin && address < lastFound.m_end
+		&& lastFound.m_generation == s_generation.load(std::memory_order_acquire))
+		return lastFound.m_pool;
+	return FindOwnerSlow(memory);
+}
+
+#endif // !__POOLREGISTRY
\ No newline at end of file
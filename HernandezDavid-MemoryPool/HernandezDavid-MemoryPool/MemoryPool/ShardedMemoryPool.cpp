@@ -0,0 +1,78 @@
+#include "ShardedMemoryPool.h"
+#include "VirtualMemory.h"
+
+#include <functional>
+#include <thread>
+#include <assert.h>
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#elif defined(__linux__)
+	#include <sched.h>
+#endif
+
+ShardedMemoryPool::ShardedMemoryPool(uint32_t chunkSizeInBytes, uint32_t chunkCount, uint32_t shardCount, PoolEngine engine)
+	: m_shards(nullptr)
+	, m_shardCount(shardCount)
+	, m_chunkSize(chunkSizeInBytes)
+	, m_chunkCount(chunkCount)
+	, m_memory(nullptr)
+	, m_shardBytes(0u)
+	, m_stolenAllocations(0u)
+{
+	if (m_shardCount == 0u)
+		m_shardCount = (std::thread::hardware_concurrency() != 0u ? std::thread::hardware_concurrency() : 1u);
+	assert(chunkSizeInBytes != 0 && chunkCount >= m_shardCount);
+
+	//Every shard starts on its own page, so trimming one never touches the memory of another
+	//All of them are as far apart as the biggest one needs, so the shard of an address is still a division
+	const uint32_t shardChunks = chunkCount / m_shardCount;
+	const uint32_t biggerShards = chunkCount % m_shardCount;
+	m_shardBytes = VirtualMemory::RoundToPages((size_t)chunkSizeInBytes * (shardChunks + (biggerShards != 0u ? 1u : 0u)));
+	m_memory = (byte*)VirtualMemory::Reserve(m_shardBytes * m_shardCount);
+	assert(m_memory != nullptr && "Could not reserve the address space of the pool");
+	VirtualMemory::Commit(m_memory, m_shardBytes * m_shardCount);
+
+	m_shards = new Shard[m_shardCount];
+	for (uint32_t n = 0u; n < m_shardCount; ++n)
+		m_shards[n].m_pool = new MemoryPool(chunkSizeInBytes, shardChunks + (n < biggerShards ? 1u : 0u), m_memory + m_shardBytes * n, engine);
+}
+
+ShardedMemoryPool::~ShardedMemoryPool()
+{
+	for (uint32_t n = 0u; n < m_shardCount; ++n)
+		delete m_shards[n].m_pool;
+	delete[] m_shards;
+	VirtualMemory::Release(m_memory, m_shardBytes * m_shardCount);
+}
+
+PoolPtr<byte> ShardedMemoryPool::Alloc(uint32_t bytes)
+{
+	return AllocFromShards<PoolPtr<byte>>([bytes](MemoryPool& pool) { return pool.Alloc(bytes); });
+}
+
+uint32_t ShardedMemoryPool::GetUsedChunks()
+{
+	uint32_t usedChunks = 0u;
+	for (uint32_t n = 0u; n < m_shardCount; ++n)
+	{
+		std::lock_guard<std::mutex> shardLock(m_shards[n].m_mutex);
+		usedChunks += m_shards[n].m_pool->GetUsedChunks();
+	}
+	return usedChunks;
+}
+
+uint32_t ShardedMemoryPool::GetCurrentShard() const
+{
+#ifdef _WIN32
+	return GetCurrentProcessorNumber() % m_shardCount;
+#elif defined(__linux__)
+	const int cpu = sched_getcpu();
+	if (cpu >= 0)
+		return (uint32_t)cpu % m_shardCount;
+#endif
+	//Threads that don't know their CPU stick to the shard of their id
+	return (uint32_t)(std::hash<std::thread::id>()(std::this_thread::get_id()) % m_shardCount);
+}
\ No newline at end of file
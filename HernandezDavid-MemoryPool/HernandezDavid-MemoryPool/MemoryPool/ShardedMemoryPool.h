@@ -0,0 +1,112 @@
+#ifndef __SHARDEDMEMORYPOOL
+#define __SHARDEDMEMORYPOOL
+
+#include "MemoryPool.h"
+
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+
+/*
+Pool shared between threads, split in independent shards carved out of a single reservation
+- Every shard is a MemoryPool with its own lock, over a page aligned slice of the reservation
+- Threads allocate from the shard of the CPU they run on (or of their thread id, where the CPU isn't known),
+	so threads on different cores rarely fight for the same lock
+- When a shard has no slot big enough, the allocation is taken from the free memory of the next shards instead of failing
+- Memory is freed into the shard it came from, found from its address, from any thread
+*/
+class ShardedMemoryPool
+{
+public:
+	ShardedMemoryPool(ShardedMemoryPool&) = delete;
+	//The chunks are split evenly between the shards, the first ones taking one more when they don't divide evenly
+	//*shardCount* 0 uses one shard per hardware thread
+	ShardedMemoryPool(uint32_t chunkSizeInBytes, uint32_t chunkCount, uint32_t shardCount = 0u, PoolEngine engine = PoolEngine::Tlsf);
+	~ShardedMemoryPool();
+
+	//Allocate *bytes* space in the pool of uninitialized memory
+	PoolPtr<byte> Alloc(uint32_t bytes);
+
+	//Allocate enough space for *amount* instances of *type* class
+	//Constructor will be called on all of them
+	template<class type>
+	PoolPtr<type> Alloc(uint32_t amount = 1);
+
+	//Release previously allocated memory. It can be released from any thread
+	template<class type>
+	void Free(PoolPtr<type>& toFree);
+
+	inline uint32_t GetShardCount() const { return m_shardCount; }
+	inline uint32_t GetChunkSize() const { return m_chunkSize; }
+	//Chunks of all shards
+	inline uint32_t GetChunkCount() const { return m_chunkCount; }
+	//Used chunks of all shards
+	uint32_t GetUsedChunks();
+	//Allocations taken from a shard other than the one of the calling thread
+	inline uint64_t GetStolenAllocations() const { return m_stolenAllocations.load(std::memory_order_relaxed); }
+
+private:
+	//Every shard takes whole cache lines, which keeps the locks of two shards out of the same one
+	struct alignas(64) Shard
+	{
+		std::mutex m_mutex;
+		MemoryPool* m_pool;
+	};
+
+	//Shard of the CPU running the calling thread
+	uint32_t GetCurrentShard() const;
+	inline uint32_t GetShardOf(const void* data) const { return (uint32_t)(((const byte*)data - m_memory) / m_shardBytes); }
+
+	//Tries the shard of the calling thread first, and then the next ones
+	template<class PtrType, class AllocFunc>
+	PtrType AllocFromShards(AllocFunc alloc);
+
+private:
+	Shard* m_shards;
+	uint32_t m_shardCount;
+	uint32_t m_chunkSize;
+	uint32_t m_chunkCount;
+
+	byte* m_memory;
+	//Bytes between the start of two shards
+	size_t m_shardBytes;
+
+	std::atomic<uint64_t> m_stolenAllocations;
+};
+
+template<class type>
+inline PoolPtr<type> ShardedMemoryPool::Alloc(uint32_t amount)
+{
+	return AllocFromShards<PoolPtr<type>>([amount](MemoryPool& pool) { return pool.Alloc<type>(amount); });
+}
+
+template<class type>
+inline void ShardedMemoryPool::Free(PoolPtr<type>& toFree)
+{
+	if (toFree.IsValid() == false)
+		return;
+	Shard& shard = m_shards[GetShardOf(toFree.GetData())];
+	std::lock_guard<std::mutex> shardLock(shard.m_mutex);
+	shard.m_pool->Free(toFree);
+}
+
+template<class PtrType, class AllocFunc>
+inline PtrType ShardedMemoryPool::AllocFromShards(AllocFunc alloc)
+{
+	const uint32_t homeShard = GetCurrentShard();
+	for (uint32_t n = 0u; n < m_shardCount; ++n)
+	{
+		Shard& shard = m_shards[(homeShard + n) % m_shardCount];
+		std::lock_guard<std::mutex> shardLock(shard.m_mutex);
+		PtrType allocation = alloc(*shard.m_pool);
+		if (allocation.IsValid())
+		{
+			if (n != 0u)
+				m_stolenAllocations.fetch_add(1u, std::memory_order_relaxed);
+			return allocation;
+		}
+	}
+	return PtrType();
+}
+
+#endif // !__SHARDEDMEMORYPOOL
\ No newline at end of file
@@ -0,0 +1,289 @@
+#ifndef __SHAREDPOOLPTR
+#define __SHAREDPOOLPTR
+
+#include "MemoryPool.h"
+#include "PoolRegistry.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <assert.h>
+
+//Reference counts that can be shared between threads
+struct AtomicRefCount
+{
+	typedef std::atomic<uint32_t> Counter;
+
+	static inline uint32_t Load(const Counter& counter) noexcept { return counter.load(std::memory_order_acquire); }
+	static inline void Increment(Counter& counter) noexcept { counter.fetch_add(1u, std::memory_order_relaxed); }
+	//Whether the count reached 0
+	static inline bool Decrement(Counter& counter) noexcept { return counter.fetch_sub(1u, std::memory_order_acq_rel) == 1u; }
+	//Whether the count wasn't 0 and could be increased
+	static inline bool IncrementIfNotZero(Counter& counter) noexcept
+	{
+		uint32_t count = counter.load(std::memory_order_relaxed);
+		while (count != 0u)
+			if (counter.compare_exchange_weak(count, count + 1u, std::memory_order_acq_rel, std::memory_order_relaxed))
+				return true;
+		return false;
+	}
+};
+
+//Plain reference counts, for objects that never leave a thread
+struct LocalRefCount
+{
+	typedef uint32_t Counter;
+
+	static inline uint32_t Load(const Counter& counter) noexcept { return counter; }
+	static inline void Increment(Counter& counter) noexcept { ++counter; }
+	static inline bool Decrement(Counter& counter) noexcept { return --counter == 0u; }
+	static inline bool IncrementIfNotZero(Counter& counter) noexcept
+	{
+		if (counter == 0u)
+			return false;
+		++counter;
+		return true;
+	}
+};
+
+template<class T, class Count>
+class SharedPoolPtr;
+template<class T, class Count>
+class WeakPoolPtr;
+template<class T, class Count = AtomicRefCount, class... Args>
+SharedPoolPtr<T, Count> MakeSharedPoolPtr(MemoryPool& pool, Args&&... args);
+
+//Single pool allocation holding the reference counts right before the object
+template<class T, class Count>
+struct SharedPoolBlock
+{
+	typename Count::Counter m_strong;
+	//Weak references, plus one held by all the strong ones together
+	typename Count::Counter m_weak;
+	alignas(T) unsigned char m_object[sizeof(T)];
+
+	inline T* GetObject() noexcept { return std::launder(reinterpret_cast<T*>(m_object)); }
+
+	inline void ReleaseWeak() noexcept
+	{
+		if (Count::Decrement(m_weak) == false)
+			return;
+		MemoryPool* pool = PoolRegistry::FindOwner(this);
+		assert(pool != nullptr && "SharedPoolPtr memory doesn't belong to any pool");
+		this->~SharedPoolBlock();
+		pool->Deallocate(this);
+	}
+
+	inline void ReleaseStrong() noexcept
+	{
+		if (Count::Decrement(m_strong) == false)
+			return;
+		if (std::is_trivially_destructible<T>::value == false)
+			GetObject()->~T();
+		ReleaseWeak();
+	}
+};
+
+/*
+Reference counted pointer to an object in a MemoryPool, destroyed when the last SharedPoolPtr goes away
+	SharedPoolPtr<Entity> entity = MakeSharedPoolPtr<Entity>(pool, id);
+	SharedPoolPtr<Entity, LocalRefCount> local = MakeSharedPoolPtr<Entity, LocalRefCount>(pool, id);
+- The counts are in front of the object, in the same pool allocation, so there's no control block elsewhere
+- *Count* is AtomicRefCount by default, LocalRefCount skips the atomics when everything stays in one thread
+- Only the block pointer is kept. The pool is found from its address with PoolRegistry when it's freed
+- The memory is freed once the WeakPoolPtrs are gone too
+The pool must outlive every SharedPoolPtr and WeakPoolPtr to its memory
+*/
+template<class T, class Count = AtomicRefCount>
+class SharedPoolPtr
+{
+public:
+	SharedPoolPtr() noexcept : m_block(nullptr) {}
+	SharedPoolPtr(std::nullptr_t) noexcept : m_block(nullptr) {}
+	SharedPoolPtr(const SharedPoolPtr& other) noexcept;
+	SharedPoolPtr(SharedPoolPtr&& other) noexcept : m_block(other.m_block) { other.m_block = nullptr; }
+	~SharedPoolPtr() { Reset(); }
+
+	SharedPoolPtr& operator=(const SharedPoolPtr& other) noexcept;
+	SharedPoolPtr& operator=(SharedPoolPtr&& other) noexcept;
+	SharedPoolPtr& operator=(std::nullptr_t) noexcept { Reset(); return *this; }
+
+	T& operator*() const { return *Get(); }
+	T* operator->() const noexcept { return Get(); }
+	explicit operator bool() const noexcept { return m_block != nullptr; }
+	T* Get() const noexcept { return (m_block ? m_block->GetObject() : nullptr); }
+
+	//Amount of SharedPoolPtrs to the object, 0 if empty
+	uint32_t UseCount() const noexcept { return (m_block ? Count::Load(m_block->m_strong) : 0u); }
+	//Drops this reference, destroying the object if it was the last one
+	void Reset() noexcept;
+
+private:
+	typedef SharedPoolBlock<T, Count> Block;
+
+	//Takes over a reference already counted for *block*
+	explicit SharedPoolPtr(Block* block) noexcept : m_block(block) {}
+
+	Block* m_block;
+
+	friend class WeakPoolPtr<T, Count>;
+	template<class U, class C, class... Args>
+	friend SharedPoolPtr<U, C> MakeSharedPoolPtr(MemoryPool& pool, Args&&... args);
+};
+
+/*
+Non owning reference to an object held by SharedPoolPtrs, that can tell when it has been destroyed
+	WeakPoolPtr<Entity> weak(entity);
+	if (SharedPoolPtr<Entity> locked = weak.Lock())
+Keeps the memory of the object, but not the object, alive
+*/
+template<class T, class Count = AtomicRefCount>
+class WeakPoolPtr
+{
+public:
+	WeakPoolPtr() noexcept : m_block(nullptr) {}
+	WeakPoolPtr(const SharedPoolPtr<T, Count>& shared) noexcept;
+	WeakPoolPtr(const WeakPoolPtr& other) noexcept;
+	WeakPoolPtr(WeakPoolPtr&& other) noexcept : m_block(other.m_block) { other.m_block = nullptr; }
+	~WeakPoolPtr() { Reset(); }
+
+	WeakPoolPtr& operator=(const WeakPoolPtr& other) noexcept;
+	WeakPoolPtr& operator=(WeakPoolPtr&& other) noexcept;
+
+	//SharedPoolPtr to the object, or an empty one if it was already destroyed
+	SharedPoolPtr<T, Count> Lock() const noexcept;
+	bool Expired() const noexcept { return UseCount() == 0u; }
+	uint32_t UseCount() const noexcept { return (m_block ? Count::Load(m_block->m_strong) : 0u); }
+	void Reset() noexcept;
+
+private:
+	typedef SharedPoolBlock<T, Count> Block;
+
+	Block* m_block;
+};
+
+static_assert(sizeof(SharedPoolPtr<int>) == sizeof(int*), "SharedPoolPtr must be as big as a plain pointer");
+
+//Allocate a *T* and its reference counts in *pool*, forwarding *args* to its constructor
+//Returns an empty SharedPoolPtr if the pool is full. If the constructor throws, the memory goes back to the pool
+template<class T, class Count, class... Args>
+inline SharedPoolPtr<T, Count> MakeSharedPoolPtr(MemoryPool& pool, Args&&... args)
+{
+	typedef SharedPoolBlock<T, Count> Block;
+	void* memory = (alignof(Block) <= pool.GetChunkAlignment() ? pool.Allocate(sizeof(Block)) : pool.AllocateAligned(sizeof(Block), alignof(Block)));
+	if (memory == nullptr)
+		return SharedPoolPtr<T, Count>();
+	Block* block = new(memory) Block;
+	try
+	{
+		new(block->m_object) T(std::forward<Args>(args)...);
+	}
+	catch (...)
+	{
+		block->~Block();
+		pool.Deallocate(memory);
+		throw;
+	}
+	block->m_strong = 1u;
+	block->m_weak = 1u;
+	return SharedPoolPtr<T, Count>(block);
+}
+
+template<class T, class Count>
+inline SharedPoolPtr<T, Count>::SharedPoolPtr(const SharedPoolPtr& other) noexcept : m_block(other.m_block)
+{
+	if (m_block)
+		Count::Increment(m_block->m_strong);
+}
+
+template<class T, class Count>
+inline SharedPoolPtr<T, Count>& SharedPoolPtr<T, Count>::operator=(const SharedPoolPtr& other) noexcept
+{
+	//Counting the new reference first makes assigning a pointer to itself safe
+	Block* block = other.m_block;
+	if (block)
+		Count::Increment(block->m_strong);
+	Reset();
+	m_block = block;
+	return *this;
+}
+
+template<class T, class Count>
+inline SharedPoolPtr<T, Count>& SharedPoolPtr<T, Count>::operator=(SharedPoolPtr&& other) noexcept
+{
+	if (this != &other)
+	{
+		Reset();
+		m_block = other.m_block;
+		other.m_block = nullptr;
+	}
+	return *this;
+}
+
+template<class T, class Count>
+inline void SharedPoolPtr<T, Count>::Reset() noexcept
+{
+	Block* block = m_block;
+	m_block = nullptr;
+	if (block)
+		block->ReleaseStrong();
+}
+
+template<class T, class Count>
+inline WeakPoolPtr<T, Count>::WeakPoolPtr(const SharedPoolPtr<T, Count>& shared) noexcept : m_block(shared.m_block)
+{
+	if (m_block)
+		Count::Increment(m_block->m_weak);
+}
+
+template<class T, class Count>
+inline WeakPoolPtr<T, Count>::WeakPoolPtr(const WeakPoolPtr& other) noexcept : m_block(other.m_block)
+{
+	if (m_block)
+		Count::Increment(m_block->m_weak);
+}
+
+template<class T, class Count>
+inline WeakPoolPtr<T, Count>& WeakPoolPtr<T, Count>::operator=(const WeakPoolPtr& other) noexcept
+{
+	Block* block = other.m_block;
+	if (block)
+		Count::Increment(block->m_weak);
+	Reset();
+	m_block = block;
+	return *this;
+}
+
+template<class T, class Count>
+inline WeakPoolPtr<T, Count>& WeakPoolPtr<T, Count>::operator=(WeakPoolPtr&& other) noexcept
+{
+	if (this != &other)
+	{
+		Reset();
+		m_block = other.m_block;
+		other.m_block = nullptr;
+	}
+	return *this;
+}
+
+template<class T, class Count>
+inline SharedPoolPtr<T, Count> WeakPoolPtr<T, Count>::Lock() const noexcept
+{
+	if (m_block && Count::IncrementIfNotZero(m_block->m_strong))
+		return SharedPoolPtr<T, Count>(m_block);
+	return SharedPoolPtr<T, Count>();
+}
+
+template<class T, class Count>
+inline void WeakPoolPtr<T, Count>::Reset() noexcept
+{
+	Block* block = m_block;
+	m_block = nullptr;
+	if (block)
+		block->ReleaseWeak();
+}
+
+#endif // !__SHAREDPOOLPTR
\ No newline at end of file
@@ -0,0 +1,118 @@
+#include "MemoryChunk.h"
+#include "MemoryPool.h"
+#include "SizeClassIndex.h"
+#include "BitUtils.h"
+
+#include <assert.h>
+
+SizeClassIndex::SizeClassIndex()
+	: m_firstChunk(nullptr)
+	, m_links()
+	, m_bucketHeads()
+	, m_nonEmptyBuckets(0u)
+{
+	for (uint32_t n = 0; n < SIZE_CLASS_COUNT; ++n)
+		m_bucketHeads[n] = INVALID_CHUNK_ID;
+}
+
+void SizeClassIndex::Init(const MemoryChunk* firstChunk, uint32_t chunkCount)
+{
+	m_firstChunk = firstChunk;
+	m_links.resize(chunkCount);
+}
+
+void SizeClassIndex::Clear()
+{
+	//Links of slots that aren't in any bucket are never read, so only the heads are emptied
+	for (uint32_t n = 0; n < SIZE_CLASS_COUNT; ++n)
+		m_bucketHeads[n] = INVALID_CHUNK_ID;
+	m_nonEmptyBuckets = 0u;
+}
+
+void SizeClassIndex::Insert(uint32_t slotStart, uint32_t chunks)
+{
+	assert(chunks != 0);
+	const uint32_t sizeClass = SizeClassOf(chunks);
+
+	//New slots are pushed at the front, so the most recently released memory is reused first
+	m_links[slotStart].m_prev = INVALID_CHUNK_ID;
+	m_links[slotStart].m_next = m_bucketHeads[sizeClass];
+	if (m_bucketHeads[sizeClass] != INVALID_CHUNK_ID)
+		m_links[m_bucketHeads[sizeClass]].m_prev = slotStart;
+
+	m_bucketHeads[sizeClass] = slotStart;
+	m_nonEmptyBuckets |= (1u << sizeClass);
+}
+
+void SizeClassIndex::Remove(uint32_t slotStart, uint32_t chunks)
+{
+	assert(chunks != 0);
+	const uint32_t sizeClass = SizeClassOf(chunks);
+	const ClassLinks links = m_links[slotStart];
+
+	if (links.m_prev != INVALID_CHUNK_ID)
+		m_links[links.m_prev].m_next = links.m_next;
+	else
+	{
+		assert(m_bucketHeads[sizeClass] == slotStart);
+		m_bucketHeads[sizeClass] = links.m_next;
+		if (m_bucketHeads[sizeClass] == INVALID_CHUNK_ID)
+			m_nonEmptyBuckets &= ~(1u << sizeClass);
+	}
+
+	if (links.m_next != INVALID_CHUNK_ID)
+		m_links[links.m_next].m_prev = links.m_prev;
+}
+
+void SizeClassIndex::Replace(uint32_t oldStart, uint32_t oldChunks, uint32_t newStart, uint32_t newChunks)
+{
+	const uint32_t sizeClass = SizeClassOf(oldChunks);
+	if (sizeClass != SizeClassOf(newChunks))
+	{
+		Remove(oldStart, oldChunks);
+		Insert(newStart, newChunks);
+		return;
+	}
+
+	//Same bucket, so the new slot can take the place of the old one in the list
+	const ClassLinks links = m_links[oldStart];
+	m_links[newStart] = links;
+	if (links.m_prev != INVALID_CHUNK_ID)
+		m_links[links.m_prev].m_next = newStart;
+	else
+		m_bucketHeads[sizeClass] = newStart;
+	if (links.m_next != INVALID_CHUNK_ID)
+		m_links[links.m_next].m_prev = newStart;
+}
+
+uint32_t SizeClassIndex::FindSlotFor(uint32_t requiredChunks) const
+{
+	//Any slot in a class of at least 2^ceil(log2(required)) chunks is big enough, so the first
+	//non empty bucket from there on can be taken without looking at the slot itself
+	const uint32_t firstFittingClass = Bits::CeilLog2(requiredChunks);
+	if (firstFittingClass < SIZE_CLASS_COUNT)
+	{
+		const uint32_t fittingBuckets = m_nonEmptyBuckets & ~((1u << firstFittingClass) - 1u);
+		if (fittingBuckets != 0)
+			return m_bucketHeads[Bits::CountTrailingZeros(fittingBuckets)];
+	}
+
+	//Nothing bigger is left, but the class the request itself falls in may still hold a slot that fits
+	//Only walked right before failing, so the pool never reports it's full while a fitting slot exists
+	for (uint32_t candidate = m_bucketHeads[SizeClassOf(requiredChunks)]; candidate != INVALID_CHUNK_ID; candidate = m_links[candidate].m_next)
+	{
+		if (m_firstChunk[candidate].GetSlotChunks() >= requiredChunks)
+			return candidate;
+	}
+	return INVALID_CHUNK_ID;
+}
+
+uint32_t SizeClassIndex::GetMetadataBytesPerChunk()
+{
+	return sizeof(ClassLinks);
+}
+
+inline uint32_t SizeClassIndex::SizeClassOf(uint32_t chunks)
+{
+	return Bits::FloorLog2(chunks);
+}
\ No newline at end of file
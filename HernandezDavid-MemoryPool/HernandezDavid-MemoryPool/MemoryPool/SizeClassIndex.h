@@ -0,0 +1,64 @@
+#ifndef __SIZECLASSINDEX
+#define __SIZECLASSINDEX
+
+#include <cstdint>
+#include <vector>
+
+#define SIZE_CLASS_COUNT 32u
+
+struct MemoryChunk;
+
+/*
+Keeps every free slot of a pool in a bucket depending on its size
+- Class 0 holds slots of exactly one chunk (single chunk "fast bin")
+- Class N holds slots of [2^N, 2^(N+1)) chunks
+Buckets are double linked lists of chunk indices, with the links kept in an array parallel to the chunks
+and only used on the first chunk of every free slot. A bitmask keeps track of which buckets hold any slot
+*/
+class SizeClassIndex
+{
+public:
+	SizeClassIndex(SizeClassIndex&) = delete;
+	SizeClassIndex();
+
+	//Must be called before using the index, once the pool chunks exist
+	//Called again with the new chunk count when the pool grows
+	void Init(const MemoryChunk* firstChunk, uint32_t chunkCount);
+	//Forget every slot at once, without going through them
+	void Clear();
+
+	//Add the free slot of *chunks* chunks starting at chunk *slotStart* to the bucket matching its size
+	void Insert(uint32_t slotStart, uint32_t chunks);
+	//Remove the free slot of *chunks* chunks starting at chunk *slotStart*
+	void Remove(uint32_t slotStart, uint32_t chunks);
+	//Replace the free slot starting at *oldStart* by the one starting at *newStart*
+	//Cheaper than removing and inserting when the slot only shrinks from the front, as done when allocating
+	void Replace(uint32_t oldStart, uint32_t oldChunks, uint32_t newStart, uint32_t newChunks);
+
+	//Find a free slot with at least *requiredChunks* of contiguous avaliable chunks
+	//O(1) while a bigger class holds any slot. Otherwise the class *requiredChunks* falls in is walked before giving up
+	//Returns the index of its first chunk, or INVALID_CHUNK_ID if none was found
+	uint32_t FindSlotFor(uint32_t requiredChunks) const;
+
+	//Bytes of metadata used per chunk
+	static uint32_t GetMetadataBytesPerChunk();
+
+private:
+	static uint32_t SizeClassOf(uint32_t chunks);
+
+	//Both links are always read and written together, so they are kept side by side
+	struct ClassLinks
+	{
+		uint32_t m_next;
+		uint32_t m_prev;
+	};
+
+private:
+	const MemoryChunk* m_firstChunk;
+	std::vector<ClassLinks> m_links;
+
+	uint32_t m_bucketHeads[SIZE_CLASS_COUNT];
+	uint32_t m_nonEmptyBuckets;
+};
+
+#endif // !__SIZECLASSINDEX
\ No newline at end of file
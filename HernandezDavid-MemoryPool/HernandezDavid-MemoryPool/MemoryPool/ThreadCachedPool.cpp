@@ -0,0 +1,242 @@
+#include "ThreadCachedPool.h"
+#include "MemoryChunk.h"
+
+#include <algorithm>
+#include <atomic>
+#include <assert.h>
+
+//Ids of the pools still alive, so exiting threads don't flush their caches into destroyed pools
+static std::mutex s_livePoolsMutex;
+static std::vector<std::pair<uint64_t, ThreadCachedPool*>> s_livePools;
+static std::atomic<uint64_t> s_nextPoolId(1u);
+
+//Caches of every pool used by a thread, flushed when the thread exits
+struct ThreadCacheRegistry
+{
+	struct Entry
+	{
+		uint64_t m_poolId;
+		ThreadCachedPool::ThreadCache* m_cache;
+	};
+
+	~ThreadCacheRegistry()
+	{
+		//The lock keeps the pools from being destroyed while flushing into them
+		std::lock_guard<std::mutex> livePoolsLock(s_livePoolsMutex);
+		for (const Entry& entry : m_entries)
+		{
+			for (const std::pair<uint64_t, ThreadCachedPool*>& livePool : s_livePools)
+			{
+				if (livePool.first == entry.m_poolId)
+				{
+					livePool.second->DetachThreadCache(entry.m_cache);
+					break;
+				}
+			}
+		}
+	}
+
+	std::vector<Entry> m_entries;
+};
+
+static thread_local ThreadCacheRegistry t_registry;
+thread_local uint64_t ThreadCachedPool::s_lastPoolId = 0u;
+thread_local ThreadCachedPool::ThreadCache* ThreadCachedPool::s_lastCache = nullptr;
+
+ThreadCachedPool::ThreadCachedPool(uint32_t chunkSizeInBytes, uint32_t chunkCount, PoolEngine engine, const PoolGrowth& growth, PoolPages pages)
+	: m_pool(chunkSizeInBytes, chunkCount, engine, growth, pages)
+	, m_poolMutex()
+	, m_id(s_nextPoolId++)
+	, m_chunkSize(chunkSizeInBytes)
+	, m_threadCaches()
+{
+	std::lock_guard<std::mutex> livePoolsLock(s_livePoolsMutex);
+	s_livePools.push_back(std::make_pair(m_id, this));
+}
+
+ThreadCachedPool::~ThreadCachedPool()
+{
+	{
+		std::lock_guard<std::mutex> livePoolsLock(s_livePoolsMutex);
+		s_livePools.erase(std::find(s_livePools.begin(), s_livePools.end(), std::make_pair(m_id, this)));
+	}
+
+	//No other thread may use the pool anymore, so their caches can be emptied from here
+	for (ThreadCache* cache : m_threadCaches)
+	{
+		for (std::vector<CachedSlot>& slots : cache->m_slots)
+			Flush(slots, (uint32_t)slots.size());
+		delete cache;
+	}
+}
+
+PoolPtr<byte> ThreadCachedPool::Alloc(uint32_t bytes)
+{
+	const uint32_t chunks = (bytes != 0u ? (bytes - 1) / m_chunkSize + 1 : 1u);
+	if (chunks > THREAD_CACHE_SIZE_CLASSES)
+	{
+		std::lock_guard<std::mutex> poolLock(m_poolMutex);
+		return m_pool.Alloc(bytes);
+	}
+
+	std::vector<CachedSlot>& slots = GetThreadCache()->m_slots[chunks - 1];
+	if (slots.empty())
+	{
+		Refill(slots, chunks);
+		if (slots.empty())
+			return PoolPtr<byte>();
+	}
+
+	const CachedSlot slot = slots.back();
+	slots.pop_back();
+#ifdef _DEBUG
+	return PoolPtr<byte>(slot.m_chunk, slot.m_data, bytes);
+#else
+	return PoolPtr<byte>(slot.m_chunk, slot.m_data);
+#endif
+}
+
+void ThreadCachedPool::Free(MemoryChunk* chunk, void* data)
+{
+	//The slot belongs to the caller until it's freed, so its metadata can be read without the lock
+	const uint32_t chunks = chunk->GetSlotChunks();
+	if (chunks > THREAD_CACHE_SIZE_CLASSES)
+	{
+		std::lock_guard<std::mutex> poolLock(m_poolMutex);
+		PoolPtr<byte> toFree(chunk, data);
+		m_pool.Free(toFree);
+		return;
+	}
+
+	std::vector<CachedSlot>& slots = GetThreadCache()->m_slots[chunks - 1];
+#ifdef _DEBUG
+	//Cached slots still look used to the central pool, so double frees have to be caught here
+	for (const CachedSlot& slot : slots)
+		assert(slot.m_chunk != chunk && "Attempted to free memory already freed");
+#endif
+	slots.push_back({ chunk, data });
+	if (slots.size() > THREAD_CACHE_CAPACITY)
+	{
+		std::lock_guard<std::mutex> poolLock(m_poolMutex);
+		Flush(slots, THREAD_CACHE_BATCH);
+	}
+}
+
+void ThreadCachedPool::FlushThreadCache()
+{
+	ThreadCache* cache = GetThreadCache();
+	std::lock_guard<std::mutex> poolLock(m_poolMutex);
+	for (std::vector<CachedSlot>& slots : cache->m_slots)
+		Flush(slots, (uint32_t)slots.size());
+}
+
+uint32_t ThreadCachedPool::GetUsedChunks()
+{
+	std::lock_guard<std::mutex> poolLock(m_poolMutex);
+	return m_pool.GetUsedChunks();
+}
+
+uint32_t ThreadCachedPool::GetCachedChunks()
+{
+	std::lock_guard<std::mutex> poolLock(m_poolMutex);
+	uint32_t cachedChunks = 0u;
+	for (const ThreadCache* cache : m_threadCaches)
+	{
+		for (uint32_t sizeClass = 0u; sizeClass < THREAD_CACHE_SIZE_CLASSES; ++sizeClass)
+			cachedChunks += (uint32_t)cache->m_slots[sizeClass].size() * (sizeClass + 1);
+	}
+	return cachedChunks;
+}
+
+ThreadCachedPool::ThreadCache* ThreadCachedPool::GetThreadCache()
+{
+	if (s_lastPoolId == m_id)
+		return s_lastCache;
+
+	ThreadCache* cache = nullptr;
+	for (const ThreadCacheRegistry::Entry& entry : t_registry.m_entries)
+	{
+		if (entry.m_poolId == m_id)
+		{
+			cache = entry.m_cache;
+			break;
+		}
+	}
+	if (cache == nullptr)
+	{
+		cache = AttachThreadCache();
+		//Entries of destroyed pools are dropped here, so threads using many short lived pools don't pile them up
+		{
+			std::lock_guard<std::mutex> livePoolsLock(s_livePoolsMutex);
+			t_registry.m_entries.erase(std::remove_if(t_registry.m_entries.begin(), t_registry.m_entries.end(),
+				[](const ThreadCacheRegistry::Entry& entry)
+				{
+					return std::find_if(s_livePools.begin(), s_livePools.end(),
+						[&entry](const std::pair<uint64_t, ThreadCachedPool*>& livePool) { return livePool.first == entry.m_poolId; })
+						== s_livePools.end();
+				}), t_registry.m_entries.end());
+		}
+		t_registry.m_entries.push_back({ m_id, cache });
+	}
+
+	s_lastPoolId = m_id;
+	s_lastCache = cache;
+	return cache;
+}
+
+ThreadCachedPool::ThreadCache* ThreadCachedPool::AttachThreadCache()
+{
+	std::lock_guard<std::mutex> poolLock(m_poolMutex);
+	for (ThreadCache* cache : m_threadCaches)
+	{
+		if (cache->m_inUse == false)
+		{
+			cache->m_inUse = true;
+			return cache;
+		}
+	}
+
+	ThreadCache* cache = new ThreadCache();
+	for (std::vector<CachedSlot>& slots : cache->m_slots)
+		slots.reserve(THREAD_CACHE_CAPACITY + 1);
+	cache->m_inUse = true;
+	m_threadCaches.push_back(cache);
+	return cache;
+}
+
+void ThreadCachedPool::DetachThreadCache(ThreadCache* cache)
+{
+	std::lock_guard<std::mutex> poolLock(m_poolMutex);
+	for (std::vector<CachedSlot>& slots : cache->m_slots)
+		Flush(slots, (uint32_t)slots.size());
+	cache->m_inUse = false;
+}
+
+void ThreadCachedPool::Refill(std::vector<CachedSlot>& slots, uint32_t chunks)
+{
+	PoolPtr<byte> batch[THREAD_CACHE_BATCH];
+	uint32_t allocated;
+	{
+		//A single batch carves the slots out of as few free runs as it can
+		std::lock_guard<std::mutex> poolLock(m_poolMutex);
+		allocated = m_pool.AllocBatch(THREAD_CACHE_BATCH, chunks * m_chunkSize, batch);
+	}
+	//Slots carved first end up on top, so they are handed out in address order
+	for (uint32_t n = allocated; n > 0u; --n)
+		slots.push_back({ batch[n - 1].m_chunk, batch[n - 1].m_data });
+}
+
+void ThreadCachedPool::Flush(std::vector<CachedSlot>& slots, uint32_t count)
+{
+	//The oldest slots are given back, the recently freed ones are more likely to still be in cache
+	//They go back in batches, so the ones next to each other are merged and released as one slot
+	PoolPtr<byte> batch[THREAD_CACHE_BATCH];
+	for (uint32_t first = 0u; first < count; first += THREAD_CACHE_BATCH)
+	{
+		const uint32_t batchSize = (count - first < THREAD_CACHE_BATCH ? count - first : THREAD_CACHE_BATCH);
+		for (uint32_t n = 0u; n < batchSize; ++n)
+			batch[n] = PoolPtr<byte>(slots[first + n].m_chunk, slots[first + n].m_data);
+		m_pool.FreeBatch(batch, batchSize);
+	}
+	slots.erase(slots.begin(), slots.begin() + count);
+}
\ No newline at end of file
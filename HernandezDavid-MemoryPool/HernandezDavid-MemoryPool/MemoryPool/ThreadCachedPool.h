@@ -0,0 +1,135 @@
+#ifndef __THREADCACHEDPOOL
+#define __THREADCACHEDPOOL
+
+#include "MemoryPool.h"
+
+#include <mutex>
+#include <vector>
+#include <cstdint>
+
+//Allocations of up to this many chunks go through the thread caches, bigger ones straight to the central pool
+#define THREAD_CACHE_SIZE_CLASSES 8u
+//Slots moved between a thread cache and the central pool at once
+#define THREAD_CACHE_BATCH 16u
+//Slots a thread cache keeps per size class before flushing a batch
+#define THREAD_CACHE_CAPACITY (2u * THREAD_CACHE_BATCH)
+
+/*
+MemoryPool shared between threads, with a cache of free slots per thread and size class in front of it
+- Alloc and Free only touch the cache of the calling thread, with no locks nor atomics
+- Empty caches are refilled with a batch of slots from the central pool, taking its lock once for an AllocBatch
+- Full caches flush a batch of slots back to the central pool, taking its lock once for a FreeBatch
+- Caches are flushed when their thread exits, and reused by new threads
+Cached slots are still used in the central pool, so copies of a freed PoolPtr keep looking valid until the slot is flushed
+The pool must outlive any use from other threads, including their exit
+*/
+class ThreadCachedPool
+{
+public:
+	ThreadCachedPool(ThreadCachedPool&) = delete;
+	ThreadCachedPool(uint32_t chunkSizeInBytes, uint32_t chunkCount, PoolEngine engine = PoolEngine::Tlsf,
+		const PoolGrowth& growth = PoolGrowth(), PoolPages pages = PoolPages::Regular);
+	~ThreadCachedPool();
+
+	//Allocate *bytes* space in the pool of uninitialized memory
+	PoolPtr<byte> Alloc(uint32_t bytes);
+
+	//Allocate enough space for *amount* instances of *type* class, aligned as *type* requires
+	//Constructor will be called on all of them. Trivial types are just zeroed
+	//Over-aligned types skip the caches, and come straight from the central pool
+	template<class type>
+	PoolPtr<type> Alloc(uint32_t amount = 1);
+
+	//Release previously allocated memory. It can be released from any thread
+	template<class type>
+	void Free(PoolPtr<type>& toFree);
+
+	//Give all the slots cached by the calling thread back to the central pool
+	void FlushThreadCache();
+
+	inline uint32_t GetChunkSize() const { return m_chunkSize; }
+	//Chunks used in the central pool, including the ones sitting in thread caches
+	uint32_t GetUsedChunks();
+	//Chunks sitting in the thread caches of all threads. Only accurate while no other thread uses the pool
+	uint32_t GetCachedChunks();
+
+private:
+	struct CachedSlot
+	{
+		MemoryChunk* m_chunk;
+		void* m_data;
+	};
+
+	struct ThreadCache
+	{
+		//Cached slots of every size class, the last one is handed out first
+		std::vector<CachedSlot> m_slots[THREAD_CACHE_SIZE_CLASSES];
+		//Whether a live thread is using this cache
+		bool m_inUse;
+	};
+
+	//Cache of the calling thread, created or taken from an exited thread the first time it uses this pool
+	ThreadCache* GetThreadCache();
+	ThreadCache* AttachThreadCache();
+	//Called by exiting threads. The cache can be taken by another thread afterwards
+	void DetachThreadCache(ThreadCache* cache);
+
+	void Free(MemoryChunk* chunk, void* data);
+	void Refill(std::vector<CachedSlot>& slots, uint32_t chunks);
+	//Give the first *count* slots back to the central pool. The pool mutex must be locked
+	void Flush(std::vector<CachedSlot>& slots, uint32_t count);
+
+	friend struct ThreadCacheRegistry;
+
+private:
+	MemoryPool m_pool;
+	std::mutex m_poolMutex;
+	//Unique for every pool ever created, so thread caches are never matched with a new pool at the same address
+	uint64_t m_id;
+	uint32_t m_chunkSize;
+
+	//All the caches created for this pool, guarded by m_poolMutex
+	std::vector<ThreadCache*> m_threadCaches;
+
+	//Last cache used by the calling thread, which saves looking for it when a thread keeps using the same pool
+	static thread_local uint64_t s_lastPoolId;
+	static thread_local ThreadCache* s_lastCache;
+};
+
+template<class type>
+inline PoolPtr<type> ThreadCachedPool::Alloc(uint32_t amount)
+{
+	//The size would be truncated to 32 bits
+	if ((uint64_t)sizeof(type) * amount > UINT32_MAX)
+		return PoolPtr<type>(nullptr);
+
+	PoolPtr<byte> allocation;
+	if (alignof(type) <= m_pool.GetChunkAlignment())
+		allocation = Alloc(sizeof(type) * amount);
+	else
+	{
+		//Cached slots are only aligned on the chunk alignment
+		std::lock_guard<std::mutex> poolLock(m_poolMutex);
+		allocation = m_pool.AllocAligned(sizeof(type) * amount, alignof(type));
+	}
+#ifdef _DEBUG
+	PoolPtr<type> ret(allocation.m_chunk, allocation.m_data, amount);
+#else
+	PoolPtr<type> ret(allocation.m_chunk, allocation.m_data);
+#endif
+	if (ret.IsValid())
+		MemoryPool::ValueInitialize(ret.GetData(), amount);
+	return ret;
+}
+
+template<class type>
+inline void ThreadCachedPool::Free(PoolPtr<type>& toFree)
+{
+	if (toFree.IsValid())
+		Free(toFree.m_chunk, toFree.m_data);
+	//Mark as invalid the released PoolPtr
+	toFree.m_chunk = nullptr;
+	toFree.m_data = nullptr;
+}
+
+#endif // !__THREADCACHEDPOOL
\ No newline at end of file
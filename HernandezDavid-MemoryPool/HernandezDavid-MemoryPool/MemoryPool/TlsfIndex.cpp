@@ -0,0 +1,132 @@
+#include "MemoryChunk.h"
+#include "MemoryPool.h"
+#include "TlsfIndex.h"
+#include "BitUtils.h"
+
+#include <assert.h>
+
+TlsfIndex::TlsfIndex()
+	: m_firstChunk(nullptr)
+	, m_links()
+	, m_listHeads()
+	, m_secondLevelBitmaps()
+	, m_firstLevelBitmap(0u)
+	, m_freeChunks(0u)
+{
+	for (uint32_t fl = 0; fl < TLSF_FIRST_LEVEL_COUNT; ++fl)
+		for (uint32_t sl = 0; sl < TLSF_SECOND_LEVEL_COUNT; ++sl)
+			m_listHeads[fl][sl] = INVALID_CHUNK_ID;
+}
+
+void TlsfIndex::Init(const MemoryChunk* firstChunk, uint32_t chunkCount)
+{
+	m_firstChunk = firstChunk;
+	m_links.resize(chunkCount);
+}
+
+void TlsfIndex::Clear()
+{
+	//Links of slots that aren't in any list are never read, so only the heads are emptied
+	for (uint32_t fl = 0; fl < TLSF_FIRST_LEVEL_COUNT; ++fl)
+		for (uint32_t sl = 0; sl < TLSF_SECOND_LEVEL_COUNT; ++sl)
+			m_listHeads[fl][sl] = INVALID_CHUNK_ID;
+	for (uint32_t fl = 0; fl < TLSF_FIRST_LEVEL_COUNT; ++fl)
+		m_secondLevelBitmaps[fl] = 0u;
+	m_firstLevelBitmap = 0u;
+	m_freeChunks = 0u;
+}
+
+void TlsfIndex::Insert(uint32_t slotStart, uint32_t chunks)
+{
+	assert(chunks != 0);
+	uint32_t fl, sl;
+	Mapping(chunks, fl, sl);
+
+	m_links[slotStart].m_prev = INVALID_CHUNK_ID;
+	m_links[slotStart].m_next = m_listHeads[fl][sl];
+	if (m_listHeads[fl][sl] != INVALID_CHUNK_ID)
+		m_links[m_listHeads[fl][sl]].m_prev = slotStart;
+
+	m_listHeads[fl][sl] = slotStart;
+	m_secondLevelBitmaps[fl] |= (1u << sl);
+	m_firstLevelBitmap |= (1u << fl);
+	m_freeChunks += chunks;
+}
+
+void TlsfIndex::Remove(uint32_t slotStart, uint32_t chunks)
+{
+	assert(chunks != 0);
+	uint32_t fl, sl;
+	Mapping(chunks, fl, sl);
+	const ListLinks links = m_links[slotStart];
+
+	if (links.m_prev != INVALID_CHUNK_ID)
+		m_links[links.m_prev].m_next = links.m_next;
+	else
+	{
+		assert(m_listHeads[fl][sl] == slotStart);
+		m_listHeads[fl][sl] = links.m_next;
+		if (links.m_next == INVALID_CHUNK_ID)
+		{
+			m_secondLevelBitmaps[fl] &= ~(1u << sl);
+			if (m_secondLevelBitmaps[fl] == 0)
+				m_firstLevelBitmap &= ~(1u << fl);
+		}
+	}
+
+	if (links.m_next != INVALID_CHUNK_ID)
+		m_links[links.m_next].m_prev = links.m_prev;
+	m_freeChunks -= chunks;
+}
+
+uint32_t TlsfIndex::FindSlotFor(uint32_t requiredChunks) const
+{
+	//Rounding the request up to the start of the next list means any slot of the list found is big enough
+	uint32_t roundedChunks = requiredChunks;
+	if (requiredChunks >= TLSF_SECOND_LEVEL_COUNT)
+		roundedChunks += (1u << (Bits::FloorLog2(requiredChunks) - TLSF_SECOND_LEVEL_LOG2)) - 1u;
+
+	uint32_t fl, sl;
+	Mapping(roundedChunks, fl, sl);
+
+	uint32_t secondLevelMap = (fl < TLSF_FIRST_LEVEL_COUNT ? m_secondLevelBitmaps[fl] & (~0u << sl) : 0u);
+	if (secondLevelMap == 0)
+	{
+		const uint32_t firstLevelMap = (fl + 1 < TLSF_FIRST_LEVEL_COUNT ? m_firstLevelBitmap & (~0u << (fl + 1)) : 0u);
+		if (firstLevelMap != 0)
+		{
+			fl = Bits::CountTrailingZeros(firstLevelMap);
+			secondLevelMap = m_secondLevelBitmaps[fl];
+		}
+	}
+	if (secondLevelMap != 0)
+		return m_listHeads[fl][Bits::CountTrailingZeros(secondLevelMap)];
+
+	//Nothing bigger is left. The list the request itself falls in may still hold a slot that fits,
+	//but only its first slot is looked at so the cost stays bounded
+	Mapping(requiredChunks, fl, sl);
+	const uint32_t candidate = m_listHeads[fl][sl];
+	if (candidate != INVALID_CHUNK_ID && m_firstChunk[candidate].GetSlotChunks() >= requiredChunks)
+		return candidate;
+	return INVALID_CHUNK_ID;
+}
+
+uint32_t TlsfIndex::GetMetadataBytesPerChunk()
+{
+	return sizeof(ListLinks);
+}
+
+void TlsfIndex::Mapping(uint32_t chunks, uint32_t& firstLevel, uint32_t& secondLevel)
+{
+	if (chunks < TLSF_SECOND_LEVEL_COUNT)
+	{
+		firstLevel = 0u;
+		secondLevel = chunks;
+	}
+	else
+	{
+		const uint32_t log2 = Bits::FloorLog2(chunks);
+		firstLevel = log2 - TLSF_SECOND_LEVEL_LOG2 + 1u;
+		secondLevel = (chunks >> (log2 - TLSF_SECOND_LEVEL_LOG2)) - TLSF_SECOND_LEVEL_COUNT;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#ifndef __TLSFINDEX
+#define __TLSFINDEX
+
+#include <cstdint>
+#include <vector>
+
+//Every power of two range of sizes is split in 2^TLSF_SECOND_LEVEL_LOG2 lists
+#define TLSF_SECOND_LEVEL_LOG2 4u
+#define TLSF_SECOND_LEVEL_COUNT (1u << TLSF_SECOND_LEVEL_LOG2)
+#define TLSF_FIRST_LEVEL_COUNT 32u
+
+struct MemoryChunk;
+
+/*
+Two-level segregated fit index of the free slots of a pool
+- First level: power of two range the slot size falls in
+- Second level: linear subdivision of that range
+Slots smaller than TLSF_SECOND_LEVEL_COUNT chunks get a list of their exact size
+Every list is a double linked list of chunk indices, and two levels of bitmasks tell which lists hold any slot
+The links are kept in an array parallel to the chunks, not inside the free slots as TLSF usually does:
+chunks may be smaller than the two links, and free pages may have been purged, which writing the links would undo
+Insert, Remove and FindSlotFor are all O(1): no list or slot is ever iterated
+*/
+class TlsfIndex
+{
+public:
+	TlsfIndex(TlsfIndex&) = delete;
+	TlsfIndex();
+
+	//Must be called before using the index, once the pool chunks exist
+	//Called again with the new chunk count when the pool grows
+	void Init(const MemoryChunk* firstChunk, uint32_t chunkCount);
+	//Forget every slot at once, without going through them
+	void Clear();
+
+	//Add the free slot of *chunks* chunks starting at chunk *slotStart* to the list matching its size
+	void Insert(uint32_t slotStart, uint32_t chunks);
+	//Remove the free slot of *chunks* chunks starting at chunk *slotStart*
+	void Remove(uint32_t slotStart, uint32_t chunks);
+
+	//Find a free slot with at least *requiredChunks* of contiguous avaliable chunks
+	//Returns the index of its first chunk, or INVALID_CHUNK_ID if there is none
+	//The request is rounded up to the next list, so any slot found fits without checking its size
+	uint32_t FindSlotFor(uint32_t requiredChunks) const;
+
+	inline uint32_t GetFreeChunks() const { return m_freeChunks; }
+	//Bytes of metadata used per chunk
+	static uint32_t GetMetadataBytesPerChunk();
+
+private:
+	//First and second level indices of the list holding slots of *chunks* chunks
+	static void Mapping(uint32_t chunks, uint32_t& firstLevel, uint32_t& secondLevel);
+
+	struct ListLinks
+	{
+		uint32_t m_next;
+		uint32_t m_prev;
+	};
+
+private:
+	const MemoryChunk* m_firstChunk;
+	std::vector<ListLinks> m_links;
+
+	uint32_t m_listHeads[TLSF_FIRST_LEVEL_COUNT][TLSF_SECOND_LEVEL_COUNT];
+	uint32_t m_secondLevelBitmaps[TLSF_FIRST_LEVEL_COUNT];
+	uint32_t m_firstLevelBitmap;
+
+	uint32_t m_freeChunks;
+};
+
+#endif // !__TLSFINDEX
\ No newline at end of file
@@ -0,0 +1,102 @@
+#ifndef __UNIQUEPOOLPTR
+#define __UNIQUEPOOLPTR
+
+#include "MemoryPool.h"
+#include "PoolRegistry.h"
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <assert.h>
+
+/*
+Owning pointer to an object in a MemoryPool, destroyed and freed when the pointer goes away
+	UniquePoolPtr<Entity> entity = MakeUniquePoolPtr<Entity>(pool, id);
+- Move only, with noexcept moves, so containers move it around instead of copying
+- Only the object pointer is kept. The pool is found from its address with PoolRegistry when it's freed
+The pool must outlive every UniquePoolPtr to its memory
+*/
+template<class T>
+class UniquePoolPtr
+{
+public:
+	UniquePoolPtr() noexcept : m_data(nullptr) {}
+	UniquePoolPtr(std::nullptr_t) noexcept : m_data(nullptr) {}
+	//Takes ownership of an object built in the memory of a pool
+	explicit UniquePoolPtr(T* data) noexcept : m_data(data) {}
+	UniquePoolPtr(const UniquePoolPtr&) = delete;
+	UniquePoolPtr(UniquePoolPtr&& other) noexcept : m_data(other.m_data) { other.m_data = nullptr; }
+	~UniquePoolPtr() { Reset(); }
+
+	UniquePoolPtr& operator=(const UniquePoolPtr&) = delete;
+	UniquePoolPtr& operator=(UniquePoolPtr&& other) noexcept;
+	UniquePoolPtr& operator=(std::nullptr_t) noexcept { Reset(); return *this; }
+
+	T& operator*() const { return *m_data; }
+	T* operator->() const noexcept { return m_data; }
+	explicit operator bool() const noexcept { return m_data != nullptr; }
+	T* Get() const noexcept { return m_data; }
+
+	//Gives up ownership without freeing anything
+	T* Release() noexcept;
+	//Destroys and frees the object, taking ownership of *data* instead
+	void Reset(T* data = nullptr) noexcept;
+
+private:
+	T* m_data;
+};
+
+static_assert(sizeof(UniquePoolPtr<int>) == sizeof(int*), "UniquePoolPtr must be as big as a plain pointer");
+
+//Allocate a *T* in *pool*, forwarding *args* to its constructor
+//Returns an empty UniquePoolPtr if the pool is full. If the constructor throws, the memory goes back to the pool
+template<class T, class... Args>
+inline UniquePoolPtr<T> MakeUniquePoolPtr(MemoryPool& pool, Args&&... args)
+{
+	void* memory = (alignof(T) <= pool.GetChunkAlignment() ? pool.Allocate(sizeof(T)) : pool.AllocateAligned(sizeof(T), alignof(T)));
+	if (memory == nullptr)
+		return UniquePoolPtr<T>();
+	try
+	{
+		return UniquePoolPtr<T>(new(memory) T(std::forward<Args>(args)...));
+	}
+	catch (...)
+	{
+		pool.Deallocate(memory);
+		throw;
+	}
+}
+
+template<class T>
+inline UniquePoolPtr<T>& UniquePoolPtr<T>::operator=(UniquePoolPtr&& other) noexcept
+{
+	if (this != &other)
+		Reset(other.Release());
+	return *this;
+}
+
+template<class T>
+inline T* UniquePoolPtr<T>::Release() noexcept
+{
+	T* data = m_data;
+	m_data = nullptr;
+	return data;
+}
+
+template<class T>
+inline void UniquePoolPtr<T>::Reset(T* data) noexcept
+{
+	T* toFree = m_data;
+	m_data = data;
+	if (toFree == nullptr)
+		return;
+
+	if (std::is_trivially_destructible<T>::value == false)
+		toFree->~T();
+	MemoryPool* pool = PoolRegistry::FindOwner(toFree);
+	assert(pool != nullptr && "UniquePoolPtr memory doesn't belong to any pool");
+	pool->Deallocate(toFree);
+}
+
+#endif // !__UNIQUEPOOLPTR
\ No newline at end of file
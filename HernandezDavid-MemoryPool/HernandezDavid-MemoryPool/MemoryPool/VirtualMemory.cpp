@@ -0,0 +1,181 @@
+#include "VirtualMemory.h"
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+	#include <psapi.h>
+	#ifdef _MSC_VER
+		#pragma comment(lib, "psapi.lib")
+	#endif
+#else
+	#include <sys/mman.h>
+	#include <unistd.h>
+	#include <fstream>
+	#include <string>
+#endif
+
+size_t VirtualMemory::GetPageSize()
+{
+	static size_t pageSize = 0u;
+	if (pageSize == 0u)
+	{
+#ifdef _WIN32
+		//Reservations are done with allocation granularity, commits only need page granularity
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		pageSize = info.dwPageSize;
+#else
+		pageSize = (size_t)sysconf(_SC_PAGESIZE);
+#endif
+	}
+	return pageSize;
+}
+
+size_t VirtualMemory::GetHugePageSize()
+{
+	static size_t hugePageSize = 0u;
+	if (hugePageSize == 0u)
+	{
+		hugePageSize = 2u * 1024u * 1024u;
+#ifdef _WIN32
+		if (GetLargePageMinimum() != 0u)
+			hugePageSize = GetLargePageMinimum();
+#else
+		std::ifstream meminfo("/proc/meminfo");
+		std::string field;
+		size_t kilobytes = 0u;
+		while (meminfo >> field)
+		{
+			if (field == "Hugepagesize:" && meminfo >> kilobytes)
+			{
+				hugePageSize = kilobytes * 1024u;
+				break;
+			}
+		}
+#endif
+	}
+	return hugePageSize;
+}
+
+size_t VirtualMemory::RoundToPages(size_t bytes, size_t pageSize)
+{
+	return (bytes + pageSize - 1) / pageSize * pageSize;
+}
+
+void* VirtualMemory::Reserve(size_t bytes)
+{
+#ifdef _WIN32
+	return VirtualAlloc(nullptr, bytes, MEM_RESERVE, PAGE_NOACCESS);
+#else
+	void* address = mmap(nullptr, bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	return (address != MAP_FAILED ? address : nullptr);
+#endif
+}
+
+void* VirtualMemory::ReserveHuge(size_t bytes, HugePages& obtained)
+{
+	const size_t hugePageSize = GetHugePageSize();
+	obtained = HugePages::None;
+#ifdef _WIN32
+	//Large pages can't be reserved and committed separately, and need the "lock pages in memory" privilege,
+	//so only the alignment is done on Windows. Reserving and releasing a bigger range finds an aligned gap, but
+	//someone else may take it before reserving it again
+	for (int attempt = 0; attempt < 8; ++attempt)
+	{
+		unsigned char* reserved = (unsigned char*)VirtualAlloc(nullptr, bytes + hugePageSize, MEM_RESERVE, PAGE_NOACCESS);
+		if (reserved == nullptr)
+			return nullptr;
+		VirtualFree(reserved, 0, MEM_RELEASE);
+		unsigned char* aligned = (unsigned char*)(((size_t)reserved + hugePageSize - 1) / hugePageSize * hugePageSize);
+		if (VirtualAlloc(aligned, bytes, MEM_RESERVE, PAGE_NOACCESS) != nullptr)
+			return aligned;
+	}
+	return Reserve(bytes);
+#else
+	#ifdef MAP_HUGETLB
+	//Fails if the system huge page pool doesn't have enough free pages for the whole range
+	void* address = mmap(nullptr, bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	if (address != MAP_FAILED)
+	{
+		obtained = HugePages::Explicit;
+		return address;
+	}
+	#endif
+
+	//The kernel only uses transparent huge pages for aligned ranges, so a bigger range is reserved and its edges given back
+	unsigned char* reserved = (unsigned char*)Reserve(bytes + hugePageSize);
+	if (reserved == nullptr)
+		return nullptr;
+	unsigned char* aligned = (unsigned char*)(((size_t)reserved + hugePageSize - 1) / hugePageSize * hugePageSize);
+	if (aligned != reserved)
+		munmap(reserved, aligned - reserved);
+	munmap(aligned + bytes, reserved + hugePageSize - aligned);
+	#ifdef MADV_HUGEPAGE
+	if (madvise(aligned, bytes, MADV_HUGEPAGE) == 0)
+		obtained = HugePages::Transparent;
+	#endif
+	return aligned;
+#endif
+}
+
+bool VirtualMemory::Commit(void* address, size_t bytes)
+{
+	if (bytes == 0u)
+		return true;
+#ifdef _WIN32
+	return VirtualAlloc(address, bytes, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+#else
+	return mprotect(address, bytes, PROT_READ | PROT_WRITE) == 0;
+#endif
+}
+
+void VirtualMemory::Release(void* address, size_t bytes)
+{
+	if (address == nullptr)
+		return;
+#ifdef _WIN32
+	VirtualFree(address, 0, MEM_RELEASE);
+#else
+	munmap(address, bytes);
+#endif
+}
+
+void VirtualMemory::Purge(void* address, size_t bytes, bool lazy)
+{
+	if (bytes == 0u)
+		return;
+#ifdef _WIN32
+	if (lazy)
+		VirtualAlloc(address, bytes, MEM_RESET, PAGE_READWRITE);
+	else
+	{
+		//Decommitting and committing again leaves fresh zeroed pages with nothing behind them
+		VirtualFree(address, bytes, MEM_DECOMMIT);
+		VirtualAlloc(address, bytes, MEM_COMMIT, PAGE_READWRITE);
+	}
+#else
+	#ifdef MADV_FREE
+	if (lazy && madvise(address, bytes, MADV_FREE) == 0)
+		return;
+	#endif
+	madvise(address, bytes, MADV_DONTNEED);
+#endif
+}
+
+size_t VirtualMemory::GetResidentBytes()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return counters.WorkingSetSize;
+	return 0u;
+#else
+	//Second field of statm is the amount of resident pages
+	std::ifstream statm("/proc/self/statm");
+	size_t totalPages = 0u, residentPages = 0u;
+	if (statm >> totalPages >> residentPages)
+		return residentPages * GetPageSize();
+	return 0u;
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#ifndef __VIRTUALMEMORY
+#define __VIRTUALMEMORY
+
+#include <cstddef>
+
+//Thin wrappers over the OS virtual memory calls (VirtualAlloc on Windows, mmap elsewhere)
+//All addresses and sizes must be multiples of the page size
+namespace VirtualMemory
+{
+	//Kind of huge pages obtained by ReserveHuge
+	enum class HugePages
+	{
+		//Regular pages only
+		None,
+		//Pages taken from the huge page pool of the system (MAP_HUGETLB)
+		Explicit,
+		//Regular pages the kernel may merge into huge pages (MADV_HUGEPAGE)
+		Transparent
+	};
+
+	size_t GetPageSize();
+	//Size of the huge pages of the system, usually 2MB
+	size_t GetHugePageSize();
+	//Rounds *bytes* up to a whole amount of pages of *pageSize*
+	size_t RoundToPages(size_t bytes, size_t pageSize = GetPageSize());
+
+	//Reserve *bytes* of address space without any memory behind it
+	//Returns nullptr on failure
+	void* Reserve(size_t bytes);
+	//Same as Reserve, but aligned to the huge page size and backed by huge pages when possible
+	//*bytes* must be a multiple of the huge page size, and so must be all the ranges committed or purged in it
+	//Explicit huge pages are tried first, falling back to transparent ones. *obtained* tells which were used
+	void* ReserveHuge(size_t bytes, HugePages& obtained);
+	//Back part of a reserved range with readable and writable memory, which starts zeroed
+	bool Commit(void* address, size_t bytes);
+	//Give the whole reserved range back to the OS
+	void Release(void* address, size_t bytes);
+	//Give the physical memory behind committed pages back to the OS, keeping them usable
+	//Purged pages read as zeroes after an eager purge. Lazy purges leave them untouched until the OS needs the memory,
+	//so their content is undefined and resident memory doesn't go down right away
+	void Purge(void* address, size_t bytes, bool lazy = false);
+
+	//Bytes of the process currently resident in physical memory, 0 if unknown
+	size_t GetResidentBytes();
+}
+
+#endif // !__VIRTUALMEMORY
\ No newline at end of file
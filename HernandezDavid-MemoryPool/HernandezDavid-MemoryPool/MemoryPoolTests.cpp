@@ -1,11 +1,553 @@
 #include "MemoryPool/MemoryPool.h"
+#include "MemoryPool/MemoryChunk.h"
+#include "MemoryPool/ObjectPool.h"
+#include "MemoryPool/VirtualMemory.h"
+#include "MemoryPool/ThreadCachedPool.h"
+#include "MemoryPool/ConcurrentMemoryPool.h"
+#include "MemoryPool/ShardedMemoryPool.h"
+#include "MemoryPool/OwnedMemoryPool.h"
+#include "MemoryPool/PoolAllocator.h"
+#include "MemoryPool/PoolMemoryResource.h"
+#include "MemoryPool/UniquePoolPtr.h"
+#include "MemoryPool/SharedPoolPtr.h"
+#include "MemoryPool/FrameArena.h"
 #include "ReadWriteFile.h"
 #include "MemoryPoolTests.h"
 #include "Measure.h"
 
 #include <iostream>
+#include <list>
+#include <map>
+#include <memory_resource>
 #include <queue>
 #include <assert.h>
+#include <climits>
+#include <cstring>
+#include <ctime>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+
+//Engines timed by the comparative tests
+static const PoolEngine TESTED_ENGINES[] =
+{
+	PoolEngine::FreeMarkers,
+	PoolEngine::SegregatedFreeMarkers,
+	PoolEngine::Bitmap,
+	PoolEngine::Tlsf,
+	PoolEngine::Buddy
+};
+
+static std::string GetEngineName(PoolEngine engine)
+{
+	switch (engine)
+	{
+	case PoolEngine::FreeMarkers: return "Pool  ";
+	case PoolEngine::SegregatedFreeMarkers: return "Pool (segregated)";
+	case PoolEngine::Bitmap: return "Pool (bitmap)";
+	case PoolEngine::Tlsf: return "Pool (TLSF)";
+	case PoolEngine::Buddy: return "Pool (buddy)";
+	}
+	return "Pool (unknown)";
+}
+
+//Thread counts used by the thread tests
+static const uint32_t TESTED_THREAD_COUNTS[] = { 1u, 2u, 4u, 8u, 16u, 32u };
+
+//MemoryPool with a plain mutex around it, what the thread caches are compared against
+struct LockedPool
+{
+	LockedPool(uint32_t chunkSize, uint32_t chunks) : pool(chunkSize, chunks, PoolEngine::Tlsf) {}
+	PoolPtr<byte> Alloc(uint32_t bytes) { std::lock_guard<std::mutex> lock(mutex); return pool.Alloc(bytes); }
+	void Free(PoolPtr<byte>& toFree) { std::lock_guard<std::mutex> lock(mutex); pool.Free(toFree); }
+	MemoryPool pool;
+	std::mutex mutex;
+};
+
+struct MallocAllocator
+{
+	void* Alloc(uint32_t bytes) { return malloc(bytes); }
+	void Free(void*& toFree) { free(toFree); toFree = nullptr; }
+};
+
+static bool IsAllocated(const PoolPtr<byte>& allocation) { return allocation.IsValid(); }
+static bool IsAllocated(const void* allocation) { return allocation != nullptr; }
+
+//Same workload as the random performance test, keeping up to *maxLive* allocations alive
+template<class Allocator, class Pointer>
+static void ThreadChurn(Allocator& allocator, unsigned int seed, uint32_t ticks, uint32_t maxLive, uint32_t chunkSize)
+{
+	std::minstd_rand random(seed);
+	std::queue<Pointer> allocations;
+	for (uint32_t n = 0u; n < ticks; ++n)
+	{
+		uint32_t randomNumber = random() % 8;
+		if ((randomNumber < 4 || allocations.empty()) && allocations.size() < maxLive)
+		{
+			Pointer allocation = allocator.Alloc((randomNumber + 1) * chunkSize);
+			if (IsAllocated(allocation))
+				allocations.push(allocation);
+		}
+		else
+		{
+			allocator.Free(allocations.front());
+			allocations.pop();
+		}
+	}
+	while (allocations.empty() == false)
+	{
+		allocator.Free(allocations.front());
+		allocations.pop();
+	}
+}
+
+//Runs ThreadChurn on *threads* threads at once, returning how long it took all of them to finish
+template<class Allocator, class Pointer>
+static long long RunThreadChurn(Allocator& allocator, uint32_t threads, int seed, uint32_t ticks, uint32_t maxLive, uint32_t chunkSize)
+{
+	//Threads are created before starting the clock, and wait for the signal to begin
+	std::promise<void> startSignal;
+	std::shared_future<void> start = startSignal.get_future().share();
+	std::vector<std::thread> workers;
+	for (uint32_t n = 0u; n < threads; ++n)
+	{
+		workers.emplace_back([&allocator, start, seed, n, ticks, maxLive, chunkSize]()
+		{
+			start.wait();
+			ThreadChurn<Allocator, Pointer>(allocator, (unsigned int)seed + n, ticks, maxLive, chunkSize);
+		});
+	}
+
+	std::chrono::steady_clock::time_point startTime = Time::GetTime();
+	startSignal.set_value();
+	for (std::thread& worker : workers)
+		worker.join();
+	return Time::GetTimeDiference(startTime);
+}
+
+//Allocations of the concurrent stress test are stamped with the thread and allocation that own them
+struct StressAllocation
+{
+	PoolPtr<byte> memory;
+	uint32_t bytes;
+	uint32_t stamp;
+};
+
+//Random allocations and frees of 1 to 16 chunks, checking nobody else wrote over them when they're freed
+//Returns the amount of allocations found corrupted
+static uint32_t ConcurrentStress(ConcurrentMemoryPool& pool, unsigned int seed, uint32_t threadN, uint32_t ticks, uint32_t maxLive,
+	std::atomic<uint32_t>& failedAllocations)
+{
+	std::minstd_rand random(seed);
+	std::vector<StressAllocation> allocations;
+	uint32_t corrupted = 0u;
+	auto freeAllocation = [&](uint32_t allocationN)
+	{
+		StressAllocation& allocation = allocations[allocationN];
+		uint32_t first, last;
+		memcpy(&first, allocation.memory.GetData(), sizeof(uint32_t));
+		memcpy(&last, allocation.memory.GetData() + allocation.bytes - sizeof(uint32_t), sizeof(uint32_t));
+		if (first != allocation.stamp || last != allocation.stamp)
+			corrupted++;
+		pool.Free(allocation.memory);
+		std::swap(allocation, allocations.back());
+		allocations.pop_back();
+	};
+
+	for (uint32_t n = 0u; n < ticks; ++n)
+	{
+		const uint32_t randomNumber = random();
+		if ((randomNumber % 2 == 0 || allocations.empty()) && allocations.size() < maxLive)
+		{
+			StressAllocation allocation;
+			allocation.bytes = (randomNumber / 2 % 16 + 1) * pool.GetChunkSize();
+			allocation.memory = pool.Alloc(allocation.bytes);
+			if (allocation.memory.IsValid() == false)
+			{
+				failedAllocations++;
+				continue;
+			}
+			allocation.stamp = (threadN << 24) ^ n;
+			memcpy(allocation.memory.GetData(), &allocation.stamp, sizeof(uint32_t));
+			memcpy(allocation.memory.GetData() + allocation.bytes - sizeof(uint32_t), &allocation.stamp, sizeof(uint32_t));
+			allocations.push_back(allocation);
+		}
+		else
+			freeAllocation((randomNumber / 2) % allocations.size());
+	}
+	while (allocations.empty() == false)
+		freeAllocation((uint32_t)allocations.size() - 1);
+	return corrupted;
+}
+
+//Every round all threads wait for each other, then allocate until the pool is exhausted, so they all try to merge at once
+//Returns the amount of chunks allocated over all rounds
+static uint64_t ConcurrentExhaust(ConcurrentMemoryPool& pool, unsigned int seed, uint32_t threads, uint32_t rounds,
+	std::atomic<uint32_t>& arrived)
+{
+	std::minstd_rand random(seed);
+	std::vector<PoolPtr<byte>> allocations;
+	uint64_t allocatedChunks = 0u;
+	for (uint32_t round = 0u; round < rounds; ++round)
+	{
+		//Two barriers a round: one before allocating and one before freeing
+		arrived++;
+		while (arrived.load() < threads * (2u * round + 1u))
+			std::this_thread::yield();
+		for (uint32_t chunks = 1u; ; chunks = random() % 4 + 1)
+		{
+			PoolPtr<byte> allocation = pool.Alloc(chunks * pool.GetChunkSize());
+			if (allocation.IsValid() == false)
+				break;
+			allocations.push_back(allocation);
+			allocatedChunks += chunks;
+		}
+		arrived++;
+		while (arrived.load() < threads * (2u * round + 2u))
+			std::this_thread::yield();
+		for (PoolPtr<byte>& allocation : allocations)
+			pool.Free(allocation);
+		allocations.clear();
+	}
+	return allocatedChunks;
+}
+
+//Single producer, single consumer ring the producer/consumer test hands allocations through
+template<class Pointer>
+struct Handoff
+{
+	explicit Handoff(uint32_t capacity) : slots(capacity), pushed(0u), popped(0u) {}
+	bool Push(const Pointer& allocation)
+	{
+		const uint32_t n = pushed.load(std::memory_order_relaxed);
+		if (n - popped.load(std::memory_order_acquire) == slots.size())
+			return false;
+		slots[n % slots.size()] = allocation;
+		pushed.store(n + 1u, std::memory_order_release);
+		return true;
+	}
+	bool Pop(Pointer& allocation)
+	{
+		const uint32_t n = popped.load(std::memory_order_relaxed);
+		if (n == pushed.load(std::memory_order_acquire))
+			return false;
+		allocation = slots[n % slots.size()];
+		popped.store(n + 1u, std::memory_order_release);
+		return true;
+	}
+	std::vector<Pointer> slots;
+	std::atomic<uint32_t> pushed;
+	std::atomic<uint32_t> popped;
+};
+
+static byte* GetBytes(PoolPtr<byte>& allocation) { return allocation.GetData(); }
+static byte* GetBytes(void* allocation) { return (byte*)allocation; }
+
+//Producers of owned pools must own them to allocate, the rest of allocators don't care
+template<class Allocator>
+static void TakeOwnership(Allocator&) {}
+static void TakeOwnership(OwnedMemoryPool& pool) { pool.TakeOwnership(); }
+
+//Runs *pairs* producers handing *ticks* allocations of 1 to 8 chunks each to their consumer, which frees them
+//Producers retry when their allocator is full. Returns how long it took all of them to finish, and counts the allocations found corrupted
+template<class Allocator, class Pointer>
+static long long RunProducerConsumer(std::vector<std::unique_ptr<Allocator>>& allocators, int seed, uint32_t ticks, uint32_t chunkSize,
+	uint32_t handoffCapacity, std::atomic<uint32_t>& corrupted)
+{
+	std::vector<std::unique_ptr<Handoff<Pointer>>> handoffs;
+	for (size_t n = 0u; n < allocators.size(); ++n)
+		handoffs.emplace_back(new Handoff<Pointer>(handoffCapacity));
+
+	std::promise<void> startSignal;
+	std::shared_future<void> start = startSignal.get_future().share();
+	std::vector<std::thread> workers;
+	for (size_t pairN = 0u; pairN < allocators.size(); ++pairN)
+	{
+		Allocator& allocator = *allocators[pairN];
+		Handoff<Pointer>& handoff = *handoffs[pairN];
+		workers.emplace_back([&allocator, &handoff, start, seed, pairN, ticks, chunkSize]()
+		{
+			TakeOwnership(allocator);
+			std::minstd_rand random((unsigned int)seed + (unsigned int)pairN);
+			start.wait();
+			for (uint32_t n = 0u; n < ticks; ++n)
+			{
+				Pointer allocation = allocator.Alloc((random() % 8 + 1) * chunkSize);
+				while (IsAllocated(allocation) == false)
+				{
+					std::this_thread::yield();
+					allocation = allocator.Alloc((random() % 8 + 1) * chunkSize);
+				}
+				*GetBytes(allocation) = (byte)n;
+				while (handoff.Push(allocation) == false)
+					std::this_thread::yield();
+			}
+		});
+		workers.emplace_back([&allocator, &handoff, &corrupted, start, ticks]()
+		{
+			start.wait();
+			for (uint32_t n = 0u; n < ticks; ++n)
+			{
+				Pointer allocation;
+				while (handoff.Pop(allocation) == false)
+					std::this_thread::yield();
+				if (*GetBytes(allocation) != (byte)n)
+					corrupted++;
+				allocator.Free(allocation);
+			}
+		});
+	}
+
+	std::chrono::steady_clock::time_point startTime = Time::GetTime();
+	startSignal.set_value();
+	for (std::thread& worker : workers)
+		worker.join();
+	return Time::GetTimeDiference(startTime);
+}
+
+//Inserts random keys into the map and erases the ones after random keys, keeping up to *maxLive* of them
+template<class Map>
+static void MapChurn(Map& map, unsigned int seed, uint32_t ticks, uint32_t maxLive)
+{
+	std::minstd_rand random(seed);
+	for (uint32_t n = 0u; n < ticks; ++n)
+	{
+		const uint32_t randomNumber = random();
+		if ((randomNumber % 2 == 0 || map.empty()) && map.size() < maxLive)
+			map[(int)(randomNumber / 2 % (maxLive * 4))] = (int)n;
+		else
+		{
+			typename Map::iterator erased = map.lower_bound((int)(randomNumber / 2 % (maxLive * 4)));
+			map.erase(erased != map.end() ? erased : map.begin());
+		}
+	}
+	map.clear();
+}
+
+//Pushes to the back of the list and pops from the front, keeping up to *maxLive* elements
+template<class List>
+static void ListChurn(List& list, unsigned int seed, uint32_t ticks, uint32_t maxLive)
+{
+	std::minstd_rand random(seed);
+	for (uint32_t n = 0u; n < ticks; ++n)
+	{
+		if ((random() % 2 == 0 || list.empty()) && list.size() < maxLive)
+			list.push_back((int)n);
+		else
+			list.pop_front();
+	}
+	list.clear();
+}
+
+//Grows *buffers* by *stepBytes* in random order, shrinking each back to its first step once it would go past *maxBytes*
+//*resize(buffer, bytes)* resizes one of them keeping its content. Returns how many resizes didn't move the buffer
+template<class Pointer, class Resize>
+static uint32_t BufferGrowth(std::vector<Pointer>& buffers, unsigned int seed, uint32_t ticks, uint32_t stepBytes, uint32_t maxBytes,
+	Resize resize)
+{
+	std::minstd_rand random(seed);
+	std::vector<uint32_t> sizes(buffers.size(), stepBytes);
+	uint32_t inPlace = 0u;
+	for (uint32_t n = 0u; n < ticks; ++n)
+	{
+		const uint32_t bufferN = random() % (uint32_t)buffers.size();
+		const uint32_t bytes = (sizes[bufferN] + stepBytes <= maxBytes ? sizes[bufferN] + stepBytes : stepBytes);
+		const byte* previousData = GetBytes(buffers[bufferN]);
+		resize(buffers[bufferN], bytes);
+		byte* data = GetBytes(buffers[bufferN]);
+		//The first byte tells the buffers apart, and has to survive every move
+		assert(data != nullptr && data[0] == (byte)bufferN);
+		if (data == previousData)
+			inPlace++;
+		data[bytes - 1] = (byte)(bufferN + 1u);
+		sizes[bufferN] = bytes;
+	}
+	return inPlace;
+}
+
+//Leaves holes of 1 to 4 chunks all over the pool, freeing every other one of *allocations* allocations and keeping the rest on *kept*
+static void FragmentPool(MemoryPool& pool, unsigned int seed, uint32_t allocations, std::vector<PoolPtr<byte>>& kept)
+{
+	std::minstd_rand random(seed);
+	std::vector<PoolPtr<byte>> allocated;
+	for (uint32_t n = 0u; n < allocations; ++n)
+		allocated.push_back(pool.Alloc((random() % 4u + 1u) * pool.GetChunkSize()));
+	for (uint32_t n = 0u; n < allocations; ++n)
+	{
+		if (n % 2u == 0u)
+			pool.Free(allocated[n]);
+		else
+			kept.push_back(allocated[n]);
+	}
+}
+
+//Same workload as the random performance test, allocating from a pmr resource
+static void ResourceRandomAllocation(std::pmr::memory_resource& resource, uint32_t ticks, uint32_t chunks, uint32_t chunkSize)
+{
+	std::queue<std::pair<void*, size_t>> allocatedMemory;
+
+	for (uint32_t n = 0u; n < ticks; ++n)
+	{
+		uint32_t randomNumber = std::rand() % 8;
+		//If the number is even, we'll allocate new memory
+		if (randomNumber < 4 || n < chunks / 4 || allocatedMemory.empty())
+		{
+			const size_t bytes = ((size_t)(randomNumber) + 1) * chunkSize;
+			allocatedMemory.push(std::make_pair(resource.allocate(bytes), bytes));
+		}
+		//If the number is odd, we'll free some memory
+		else
+		{
+			resource.deallocate(allocatedMemory.front().first, allocatedMemory.front().second);
+			allocatedMemory.pop();
+		}
+	}
+	while (allocatedMemory.empty() == false)
+	{
+		resource.deallocate(allocatedMemory.front().first, allocatedMemory.front().second);
+		allocatedMemory.pop();
+	}
+}
+
+//Typical game entity used by the object pool tests
+struct Entity
+{
+	Entity() : Entity(0u) {}
+	explicit Entity(uint32_t entityId) : velocity{ 0.f, 0.f, 0.f }, id(entityId)
+	{
+		for (uint32_t n = 0; n < 16; ++n)
+			transform[n] = (n % 5 == 0 ? 1.f : 0.f);
+	}
+	float transform[16];
+	float velocity[3];
+	uint32_t id;
+};
+
+//Counts how many of them are alive, to check New and Delete construct and destroy what they should
+struct CountedObject
+{
+	CountedObject(const std::string& objectName, uint32_t objectValue) : name(objectName), value(objectValue) { alive++; }
+	CountedObject(const CountedObject& other) : name(other.name), value(other.value) { alive++; }
+	~CountedObject() { alive--; }
+	std::string name;
+	uint32_t value;
+	static int alive;
+};
+int CountedObject::alive = 0;
+
+//Spawns and despawns random entities from an ObjectPool every tick
+template<bool recycleObjects>
+static long long ObjectPoolChurn(uint32_t objects, uint32_t ticks)
+{
+	std::vector<Entity*> entities;
+	entities.reserve(objects);
+	ObjectPool<Entity, recycleObjects> pool(objects);
+
+	std::chrono::steady_clock::time_point start = Time::GetTime();
+	for (uint32_t n = 0u; n < ticks; ++n)
+	{
+		uint32_t randomNumber = std::rand();
+		if ((randomNumber % 2 == 0 || entities.empty()) && entities.size() < objects)
+		{
+			Entity* entity = pool.Acquire();
+			entity->id = n;
+			entities.push_back(entity);
+		}
+		else
+		{
+			std::swap(entities[randomNumber / 2 % entities.size()], entities.back());
+			pool.Release(entities.back());
+			entities.pop_back();
+		}
+	}
+	for (Entity* entity : entities)
+		pool.Release(entity);
+	return Time::GetTimeDiference(start);
+}
+
+//std::unique_ptr deleter giving objects back to their pool, which has to carry the pool around
+struct PoolDeleter
+{
+	void operator()(Entity* entity) const { entity->~Entity(); pool->Deallocate(entity); }
+	MemoryPool* pool;
+};
+
+//Spawns and despawns random entities every tick, keeping up to *objects* of them in a vector that starts empty
+//*spawn(id)* returns an owning pointer to a new entity, and dropping it must destroy the entity
+template<class Pointer, class Spawn>
+static long long OwningPointerChurn(uint32_t objects, uint32_t ticks, Spawn spawn)
+{
+	std::vector<Pointer> entities;
+	std::chrono::steady_clock::time_point start = Time::GetTime();
+	for (uint32_t n = 0u; n < ticks; ++n)
+	{
+		uint32_t randomNumber = std::rand();
+		if ((randomNumber % 2 == 0 || entities.empty()) && entities.size() < objects)
+			entities.push_back(spawn(n));
+		else
+		{
+			std::swap(entities[randomNumber / 2 % entities.size()], entities.back());
+			entities.pop_back();
+		}
+	}
+	entities.clear();
+	return Time::GetTimeDiference(start);
+}
+
+//Makes *objects* shared entities, then every tick copies a random one over each slot of a second vector, dropping
+//the reference the slot had. Returns the time making and dropping the entities, and the time copying in *copyTime*
+template<class Pointer, class Make>
+static long long SharedPointerCopies(uint32_t objects, uint32_t ticks, Make make, long long& copyTime)
+{
+	std::vector<Pointer> owners, holders;
+	owners.reserve(objects);
+	holders.resize(objects);
+	long long makeTime = 0;
+	std::chrono::steady_clock::time_point start = Time::GetTime();
+	for (uint32_t n = 0u; n < objects; ++n)
+		owners.push_back(make(n));
+	makeTime += Time::GetTimeDiference(start);
+
+	start = Time::GetTime();
+	for (uint32_t n = 0u; n < ticks; ++n)
+	{
+		const uint32_t offset = std::rand();
+		for (uint32_t m = 0u; m < objects; ++m)
+			holders[m] = owners[(m + offset) % objects];
+	}
+	copyTime = Time::GetTimeDiference(start);
+
+	holders.clear();
+	start = Time::GetTime();
+	owners.clear();
+	return makeTime + Time::GetTimeDiference(start);
+}
+
+PoolTests::TestTimes::TestTimes()
+	: slowest(0)
+	, quickest(LLONG_MAX)
+	, total(0)
+	, samples(0u)
+{}
+
+void PoolTests::TestTimes::AddSample(long long time)
+{
+	if (time < quickest)
+		quickest = time;
+	if (time > slowest)
+		slowest = time;
+	total += time;
+	samples++;
+}
+
+std::string PoolTests::TestTimes::ToString(const std::string& name) const
+{
+	return name + " Slowest: " + std::to_string(slowest)
+		+ "\tQuickest: " + std::to_string(quickest)
+		+ "\tAverage: " + std::to_string(samples != 0 ? total / samples : 0);
+}
 
 
 void PoolTests::InitResultsFile()
@@ -94,6 +636,111 @@ void PoolTests::PoolBasicFunctionality()
 	pool.Free(small1);
 	pool.DumpDetailedDebugChunksToFile(DEFAULT_OUTPUT_FILE, "17-Small release(1)");
 
+	//Constructor arguments are forwarded, and only Delete calls destructors
+	{
+		MemoryPool objectPool(16, 64, PoolEngine::Tlsf);
+		PoolPtr<CountedObject> single = objectPool.New<CountedObject>(std::string("single"), 1u);
+		PoolPtr<CountedObject> array = objectPool.NewArray<CountedObject>(4, std::string("array"), 2u);
+		assert(CountedObject::alive == 5 && single->name == "single" && array[3].name == "array" && array[3].value == 2u);
+		objectPool.Delete(single);
+		objectPool.DeleteArray(array, 4);
+		assert(CountedObject::alive == 0 && objectPool.GetUsedChunks() == 0u);
+
+		PoolPtr<uint32_t> zeroed = objectPool.Alloc<uint32_t>(8);
+		assert(zeroed[0] == 0u && zeroed[7] == 0u);
+		objectPool.DeleteArray(zeroed, 8);
+	}
+
+	//Over-aligned allocations, on chunks that are only aligned on 4 bytes
+	for (PoolEngine engine : TESTED_ENGINES)
+	{
+		MemoryPool alignedPool(12, 1024, engine);
+		PoolPtr<testStructAligned> aligned = alignedPool.Alloc<testStructAligned>(2);
+		assert(aligned.IsValid() && (uintptr_t)aligned.GetData() % alignof(testStructAligned) == 0u);
+		for (uint32_t alignment = 1u; alignment <= 1024u; alignment *= 2u)
+		{
+			PoolPtr<byte> bytes = alignedPool.AllocAligned(100, alignment);
+			assert(bytes.IsValid() && (uintptr_t)bytes.GetData() % alignment == 0u);
+			void* memory = alignedPool.AllocateAligned(100, alignment);
+			assert(memory != nullptr && (uintptr_t)memory % alignment == 0u);
+			alignedPool.Deallocate(memory, 100);
+			alignedPool.Free(bytes);
+		}
+		alignedPool.Free(aligned);
+		assert(alignedPool.GetUsedChunks() == 0u && "Aligned allocations left chunks behind");
+	}
+	{
+		//Thread caches only hold slots aligned on the chunk alignment, so over-aligned types skip them
+		ThreadCachedPool cachedPool(12, 1024);
+		PoolPtr<testStructAligned> aligned = cachedPool.Alloc<testStructAligned>();
+		assert(aligned.IsValid() && (uintptr_t)aligned.GetData() % alignof(testStructAligned) == 0u);
+		cachedPool.Free(aligned);
+		cachedPool.FlushThreadCache();
+		assert(cachedPool.GetUsedChunks() == 0u && "Aligned allocations left chunks behind");
+	}
+	{
+		//The lock-free pool has no aligned allocations, so over-aligned types are refused
+		ConcurrentMemoryPool concurrentPool(12, 1024);
+		assert(concurrentPool.GetChunkAlignment() == 4u && concurrentPool.Alloc<testStructAligned>().IsValid() == false);
+		PoolPtr<uint32_t> zeroed = concurrentPool.Alloc<uint32_t>(8);
+		assert(zeroed.IsValid() && zeroed[0] == 0u && zeroed[7] == 0u);
+		concurrentPool.Free(zeroed);
+		assert(concurrentPool.GetUsedChunks() == 0u);
+	}
+
+	//Chunks that don't divide evenly between the shards still end up in one
+	{
+		ShardedMemoryPool shardedPool(32, 10, 4);
+		PoolPtr<byte> allocations[11];
+		for (uint32_t n = 0u; n < 10u; ++n)
+			allocations[n] = shardedPool.Alloc(32);
+		allocations[10] = shardedPool.Alloc(32);
+		assert(shardedPool.GetChunkCount() == 10u && allocations[9].IsValid() && allocations[10].IsValid() == false);
+		for (PoolPtr<byte>& allocation : allocations)
+			shardedPool.Free(allocation);
+		assert(shardedPool.GetUsedChunks() == 0u);
+	}
+
+	//Empty allocations take a chunk of their own, and sizes close to 4GB fail instead of wrapping around
+	for (PoolEngine engine : TESTED_ENGINES)
+	{
+		MemoryPool sizePool(32, 64, engine);
+		void* empty = sizePool.Allocate(0);
+		void* next = sizePool.Allocate(32);
+		assert(empty != nullptr && next != nullptr && empty != next && sizePool.GetUsableSize(empty) == 32u);
+		void* moved = sizePool.Reallocate(next, 0);
+		assert(moved == next && sizePool.GetUsedChunks() == 2u);
+		PoolPtr<byte> emptyPtr = sizePool.Alloc(0);
+		assert(emptyPtr.IsValid() && sizePool.GetUsableSize(emptyPtr) == 32u);
+		assert(sizePool.Allocate(0xFFFFFFF0u) == nullptr && sizePool.AllocateAligned(0xFFFFFFF0u, 64) == nullptr);
+		assert(sizePool.Alloc(UINT32_MAX).IsValid() == false && sizePool.Alloc<uint64_t>(0x20000000u).IsValid() == false);
+		sizePool.Free(emptyPtr);
+		sizePool.Deallocate(moved, 0);
+		sizePool.Deallocate(empty);
+		assert(sizePool.GetUsedChunks() == 0u && "Empty allocations left chunks behind");
+	}
+
+	//Free slots of 5 and 7 chunks fall in the same size class, with the 5 chunk one on top
+	//A 6 chunk request only fits in the slot under it, and has to be found while nothing bigger is free
+	for (PoolEngine engine : { PoolEngine::FreeMarkers, PoolEngine::SegregatedFreeMarkers, PoolEngine::Bitmap })
+	{
+		MemoryPool fragmentedPool(32, 64, engine);
+		PoolPtr<byte> five = fragmentedPool.Alloc(5 * 32);
+		PoolPtr<byte> gap = fragmentedPool.Alloc(32);
+		PoolPtr<byte> seven = fragmentedPool.Alloc(7 * 32);
+		PoolPtr<byte> rest = fragmentedPool.Alloc(51 * 32);
+		assert(rest.IsValid() && fragmentedPool.GetUsedChunks() == 64u);
+		byte* sevenData = seven.GetData();
+		fragmentedPool.Free(seven);
+		fragmentedPool.Free(five);
+		PoolPtr<byte> six = fragmentedPool.Alloc(6 * 32);
+		assert(six.IsValid() && six.GetData() == sevenData && "A slot that fits was missed");
+		fragmentedPool.Free(six);
+		fragmentedPool.Free(gap);
+		fragmentedPool.Free(rest);
+		assert(fragmentedPool.GetUsedChunks() == 0u);
+	}
+
 	file.Load(false);
 	file.PushBackLine("Basic functionality working as expected.");
 	file.Save();
@@ -114,23 +761,12 @@ void PoolTests::ComparativeRandomTests(uint32_t chunks, uint32_t chunkSize, uint
 	for (uint32_t n = 0; n < tests; n++)
 		seeds.push_back(rand());
 
-	long long poolQuickest = LLONG_MAX;
-	long long poolSlowest = 0;
-	long long poolAverage = 0;
-	for (uint32_t n = 0; n < tests; n++)
+	std::vector<TestTimes> poolTimes, rawPoolTimes;
+	for (PoolEngine engine : TESTED_ENGINES)
 	{
-		srand(seeds[n]);
-		MemoryPool pool(chunkSize, chunks);
-		start = Time::GetTime();
-		PoolRandomAllocation(pool, ticks, chunks, chunkSize);
-		long long time = Time::GetTimeDiference(start);
-		if (time < poolQuickest)
-			poolQuickest = time;
-		if (time > poolSlowest)
-			poolSlowest = time;
-		poolAverage += time;
+		poolTimes.push_back(PoolRandomTest(engine, seeds, chunks, chunkSize, ticks, false));
+		rawPoolTimes.push_back(PoolRandomTest(engine, seeds, chunks, chunkSize, ticks, true));
 	}
-	poolAverage /= tests;
 
 	long long mallocQuickest = LLONG_MAX;
 	long long mallocSlowest = 0;
@@ -169,9 +805,11 @@ void PoolTests::ComparativeRandomTests(uint32_t chunks, uint32_t chunkSize, uint
 	file.PushBackLine("Tests ran for " + std::to_string(ticks) + " ticks.");
 	file.PushBackLine("Ran " + std::to_string(tests) + " tests.");
 	file.PushBackLine("");
-	file.PushBackLine("Pool   Slowest: " + std::to_string(poolSlowest)
-		+ "\tQuickest: " + std::to_string(poolQuickest)
-		+ "\tAverage: " + std::to_string(poolAverage));
+	for (uint32_t n = 0; n < poolTimes.size(); ++n)
+	{
+		file.PushBackLine(poolTimes[n].ToString(GetEngineName(TESTED_ENGINES[n])));
+		file.PushBackLine(rawPoolTimes[n].ToString(GetEngineName(TESTED_ENGINES[n]) + " raw pointers"));
+	}
 	file.PushBackLine("Malloc Slowest: " + std::to_string(mallocSlowest)
 		+ "\tQuickest: " + std::to_string(mallocQuickest)
 		+ "\tAverage: " + std::to_string(mallocAverage));
@@ -179,9 +817,36 @@ void PoolTests::ComparativeRandomTests(uint32_t chunks, uint32_t chunkSize, uint
 		+ "\tQuickest: " + std::to_string(newQuickest)
 		+ "\tAverage: " + std::to_string(newAverage));
 	file.PushBackLine("");
+	PushMetadataReport(file, chunks, chunkSize);
+	file.PushBackLine("");
 	file.Save();
 }
 
+void PoolTests::PushMetadataReport(ReadWriteFile& file, uint32_t chunks, uint32_t chunkSize)
+{
+	//Layout every chunk had before the metadata was packed, kept here only to compare against
+	struct LegacyMemoryChunk
+	{
+		void* m_data;
+		uint32_t m_avaliableContiguousChunks;
+		uint32_t m_usedChunks;
+		bool m_used;
+		uint32_t m_chunkN;
+		uint32_t m_slotStart;
+		uint32_t m_markerSlot;
+		uint32_t m_nextInClass;
+		uint32_t m_prevInClass;
+	};
+
+	file.PushBackLine("Metadata bytes per chunk (previous layout: " + std::to_string(sizeof(LegacyMemoryChunk)) + " + free slot markers)");
+	for (PoolEngine engine : TESTED_ENGINES)
+	{
+		MemoryPool pool(chunkSize, chunks, engine);
+		const double bytesPerChunk = (double)pool.GetMetadataSize() / chunks;
+		file.PushBackLine(GetEngineName(engine) + " " + std::to_string(bytesPerChunk));
+	}
+}
+
 void PoolTests::ComparativeSimpleTests(uint32_t chunks, uint32_t chunkSize, uint32_t tests, uint32_t ticks)
 {
 	ReadWriteFile file(DEFAULT_OUTPUT_FILE);
@@ -195,30 +860,9 @@ void PoolTests::ComparativeSimpleTests(uint32_t chunks, uint32_t chunkSize, uint
 	struct big { medium a, b; };
 
 	std::chrono::steady_clock::time_point start;
-	long long poolSlowest = 0;
-	long long poolQuickest = LLONG_MAX;
-	long long poolAverage = 0;
-	for (uint32_t n = 0; n < tests; ++n)
-	{
-		MemoryPool pool(chunkSize, chunks);
-		start = Time::GetTime();
-		for (uint32_t m = 0; m < ticks; ++m)
-		{
-			PoolPtr<small> ptr1 = pool.Alloc<small>(2);
-			PoolPtr<medium> ptr2 = pool.Alloc<medium>();
-			PoolPtr<big> ptr3 = pool.Alloc<big>();
-			pool.Free(ptr1);
-			pool.Free(ptr2);
-			pool.Free(ptr3);
-		}
-		long long time = Time::GetTimeDiference(start);
-		if (poolSlowest < time)
-			poolSlowest = time;
-		if (poolQuickest > time)
-			poolQuickest = time;
-		poolAverage += time;
-	}
-	poolAverage /= tests;
+	std::vector<TestTimes> poolTimes;
+	for (PoolEngine engine : TESTED_ENGINES)
+		poolTimes.push_back(PoolSimpleTest(engine, chunks, chunkSize, tests, ticks));
 
 	long long mallocSlowest = 0;
 	long long mallocQuickest = LLONG_MAX;
@@ -271,9 +915,8 @@ void PoolTests::ComparativeSimpleTests(uint32_t chunks, uint32_t chunkSize, uint
 	file.PushBackLine("Test ran for " + std::to_string(ticks) + " ticks.");
 	file.PushBackLine("Ran " + std::to_string(tests) + " tests.");
 	file.PushBackLine("");
-	file.PushBackLine("Pool   Slowest: " + std::to_string(poolSlowest)
-		+ "\tQuickest: " + std::to_string(poolQuickest)
-		+ "\tAverage: " + std::to_string(poolAverage));
+	for (uint32_t n = 0; n < poolTimes.size(); ++n)
+		file.PushBackLine(poolTimes[n].ToString(GetEngineName(TESTED_ENGINES[n])));
 	file.PushBackLine("Malloc Slowest: " + std::to_string(mallocSlowest)
 		+ "\tQuickest: " + std::to_string(mallocQuickest)
 		+ "\tAverage: " + std::to_string(mallocAverage));
@@ -284,40 +927,1471 @@ void PoolTests::ComparativeSimpleTests(uint32_t chunks, uint32_t chunkSize, uint
 	file.Save();
 }
 
-void PoolTests::PoolRandomAllocation(MemoryPool& pool, uint32_t ticks, uint32_t chunks, uint32_t chunkSize)
+void PoolTests::ComparativeObjectPoolTests(uint32_t objects, uint32_t tests, uint32_t ticks)
 {
-	std::queue<PoolPtr<byte>> allocatedChunks;
+	ReadWriteFile file(DEFAULT_OUTPUT_FILE);
+	file.Load();
+	file.PushBackLine(std::string("-------------- OBJECT POOL TEST --------------"));
+	file.PushBackLine("Using pools of " + std::to_string(objects) + " entities of " + std::to_string(sizeof(Entity)) + " bytes each one.");
+	file.PushBackLine("This test will randomly spawn or despawn an entity every tick");
 
-	for (uint32_t n = 0u; n < ticks; ++n)
+	std::vector<int> seeds;
+	srand((unsigned int)time(nullptr));
+	for (uint32_t n = 0; n < tests; n++)
+		seeds.push_back(rand());
+
+	TestTimes objectPoolTimes, recyclingPoolTimes, memoryPoolTimes, memoryPoolNewTimes, newTimes;
+	for (uint32_t n = 0; n < tests; n++)
 	{
-		uint32_t randomNumber = std::rand() % 8;
-		//If the number is even, we'll allocate new memory
-		if (randomNumber < 4  || n < chunks / 4 || allocatedChunks.empty())
+		srand(seeds[n]);
+		objectPoolTimes.AddSample(ObjectPoolChurn<false>(objects, ticks));
+		srand(seeds[n]);
+		recyclingPoolTimes.AddSample(ObjectPoolChurn<true>(objects, ticks));
+	}
+
+	std::vector<PoolPtr<Entity>> poolEntities;
+	poolEntities.reserve(objects);
+	for (uint32_t n = 0; n < tests; n++)
+	{
+		srand(seeds[n]);
+		MemoryPool pool(sizeof(Entity), objects);
+		std::chrono::steady_clock::time_point start = Time::GetTime();
+		for (uint32_t m = 0u; m < ticks; ++m)
 		{
-			PoolPtr<byte> newChunk = pool.Alloc((randomNumber+1) * chunkSize);
-			if (newChunk.IsValid())
-				allocatedChunks.push(newChunk);
+			uint32_t randomNumber = std::rand();
+			if ((randomNumber % 2 == 0 || poolEntities.empty()) && poolEntities.size() < objects)
+			{
+				PoolPtr<Entity> entity = pool.Alloc<Entity>();
+				entity->id = m;
+				poolEntities.push_back(entity);
+			}
 			else
 			{
-				//Safeguard in case RNG gets real evil and decides to keep on allocating non-stop
-				pool.Free(allocatedChunks.front());
-				allocatedChunks.pop();
+				std::swap(poolEntities[randomNumber / 2 % poolEntities.size()], poolEntities.back());
+				pool.Free(poolEntities.back());
+				poolEntities.pop_back();
 			}
 		}
-		//If the number is odd, we'll free some memory
-		else
-		{
-			pool.Free(allocatedChunks.front());
-			allocatedChunks.pop();
-		}
+		for (PoolPtr<Entity>& entity : poolEntities)
+			pool.Free(entity);
+		poolEntities.clear();
+		memoryPoolTimes.AddSample(Time::GetTimeDiference(start));
 	}
-	while (allocatedChunks.empty() == false)
-	{
+
+	for (uint32_t n = 0; n < tests; n++)
+	{
+		srand(seeds[n]);
+		MemoryPool pool(sizeof(Entity), objects);
+		std::chrono::steady_clock::time_point start = Time::GetTime();
+		for (uint32_t m = 0u; m < ticks; ++m)
+		{
+			uint32_t randomNumber = std::rand();
+			if ((randomNumber % 2 == 0 || poolEntities.empty()) && poolEntities.size() < objects)
+				poolEntities.push_back(pool.New<Entity>(m));
+			else
+			{
+				std::swap(poolEntities[randomNumber / 2 % poolEntities.size()], poolEntities.back());
+				pool.Delete(poolEntities.back());
+				poolEntities.pop_back();
+			}
+		}
+		for (PoolPtr<Entity>& entity : poolEntities)
+			pool.Delete(entity);
+		poolEntities.clear();
+		memoryPoolNewTimes.AddSample(Time::GetTimeDiference(start));
+	}
+
+	std::vector<Entity*> newEntities;
+	newEntities.reserve(objects);
+	for (uint32_t n = 0; n < tests; n++)
+	{
+		srand(seeds[n]);
+		std::chrono::steady_clock::time_point start = Time::GetTime();
+		for (uint32_t m = 0u; m < ticks; ++m)
+		{
+			uint32_t randomNumber = std::rand();
+			if ((randomNumber % 2 == 0 || newEntities.empty()) && newEntities.size() < objects)
+			{
+				Entity* entity = new Entity;
+				entity->id = m;
+				newEntities.push_back(entity);
+			}
+			else
+			{
+				std::swap(newEntities[randomNumber / 2 % newEntities.size()], newEntities.back());
+				delete newEntities.back();
+				newEntities.pop_back();
+			}
+		}
+		for (Entity* entity : newEntities)
+			delete entity;
+		newEntities.clear();
+		newTimes.AddSample(Time::GetTimeDiference(start));
+	}
+
+	file.PushBackLine("Tests ran for " + std::to_string(ticks) + " ticks.");
+	file.PushBackLine("Ran " + std::to_string(tests) + " tests.");
+	file.PushBackLine("");
+	file.PushBackLine(objectPoolTimes.ToString("ObjectPool            "));
+	file.PushBackLine(recyclingPoolTimes.ToString("ObjectPool (recycling)"));
+	file.PushBackLine(memoryPoolTimes.ToString("MemoryPool::Alloc<T>  "));
+	file.PushBackLine(memoryPoolNewTimes.ToString("MemoryPool::New<T>    "));
+	file.PushBackLine(newTimes.ToString("New                   "));
+	file.PushBackLine("");
+	file.Save();
+}
+
+void PoolTests::ComparativeUniquePointerTests(uint32_t objects, uint32_t tests, uint32_t ticks)
+{
+	ReadWriteFile file(DEFAULT_OUTPUT_FILE);
+	file.Load();
+	file.PushBackLine(std::string("-------------- UNIQUE POINTER TEST --------------"));
+	file.PushBackLine("Using pools of " + std::to_string(objects) + " entities of " + std::to_string(sizeof(Entity)) + " bytes each one.");
+	file.PushBackLine("This test will randomly spawn or despawn an entity every tick, keeping them in a std::vector that starts empty.");
+	file.PushBackLine("Pointer sizes: UniquePoolPtr " + std::to_string(sizeof(UniquePoolPtr<Entity>))
+		+ ", std::unique_ptr " + std::to_string(sizeof(std::unique_ptr<Entity>))
+		+ ", std::unique_ptr with a pool deleter " + std::to_string(sizeof(std::unique_ptr<Entity, PoolDeleter>))
+		+ ", PoolPtr " + std::to_string(sizeof(PoolPtr<Entity>)) + " bytes.");
+	file.PushBackLine("Tests ran for " + std::to_string(ticks) + " ticks.");
+	file.PushBackLine("Ran " + std::to_string(tests) + " tests.");
+	file.PushBackLine("");
+
+	//Moving must not throw, or vectors would copy when they grow, which they can't
+	static_assert(std::is_nothrow_move_constructible<UniquePoolPtr<Entity>>::value, "UniquePoolPtr moves must be noexcept");
+
+	std::vector<int> seeds;
+	srand((unsigned int)time(nullptr));
+	for (uint32_t n = 0; n < tests; n++)
+		seeds.push_back(rand());
+
+	TestTimes uniquePoolTimes, uniqueTimes, deleterTimes, poolPtrTimes;
+	for (uint32_t n = 0; n < tests; n++)
+	{
+		{
+			MemoryPool pool(sizeof(Entity), objects);
+			srand(seeds[n]);
+			uniquePoolTimes.AddSample(OwningPointerChurn<UniquePoolPtr<Entity>>(objects, ticks,
+				[&pool](uint32_t id) { return MakeUniquePoolPtr<Entity>(pool, id); }));
+		}
+		srand(seeds[n]);
+		uniqueTimes.AddSample(OwningPointerChurn<std::unique_ptr<Entity>>(objects, ticks,
+			[](uint32_t id) { return std::unique_ptr<Entity>(new Entity(id)); }));
+		{
+			MemoryPool pool(sizeof(Entity), objects);
+			srand(seeds[n]);
+			deleterTimes.AddSample(OwningPointerChurn<std::unique_ptr<Entity, PoolDeleter>>(objects, ticks,
+				[&pool](uint32_t id) { return std::unique_ptr<Entity, PoolDeleter>(new(pool.Allocate(sizeof(Entity))) Entity(id), PoolDeleter{ &pool }); }));
+		}
+	}
+
+	//Plain PoolPtrs have to be deleted by hand, which is what the owning pointers save
+	for (uint32_t n = 0; n < tests; n++)
+	{
+		MemoryPool pool(sizeof(Entity), objects);
+		std::vector<PoolPtr<Entity>> entities;
+		srand(seeds[n]);
+		std::chrono::steady_clock::time_point start = Time::GetTime();
+		for (uint32_t m = 0u; m < ticks; ++m)
+		{
+			uint32_t randomNumber = std::rand();
+			if ((randomNumber % 2 == 0 || entities.empty()) && entities.size() < objects)
+				entities.push_back(pool.New<Entity>(m));
+			else
+			{
+				std::swap(entities[randomNumber / 2 % entities.size()], entities.back());
+				pool.Delete(entities.back());
+				entities.pop_back();
+			}
+		}
+		for (PoolPtr<Entity>& entity : entities)
+			pool.Delete(entity);
+		entities.clear();
+		poolPtrTimes.AddSample(Time::GetTimeDiference(start));
+	}
+
+	file.PushBackLine(uniquePoolTimes.ToString("UniquePoolPtr                 "));
+	file.PushBackLine(uniqueTimes.ToString("std::unique_ptr (new)         "));
+	file.PushBackLine(deleterTimes.ToString("std::unique_ptr (pool deleter)"));
+	file.PushBackLine(poolPtrTimes.ToString("PoolPtr (New/Delete)          "));
+	file.PushBackLine("");
+	file.Save();
+}
+
+void PoolTests::ComparativeSharedPointerTests(uint32_t objects, uint32_t tests, uint32_t ticks)
+{
+	typedef SharedPoolPtr<Entity, AtomicRefCount> AtomicShared;
+	typedef SharedPoolPtr<Entity, LocalRefCount> LocalShared;
+	//Room for the object and either its reference counts or the control block of std::shared_ptr
+	const uint32_t chunkSize = (uint32_t)sizeof(Entity) + 32u;
+
+	ReadWriteFile file(DEFAULT_OUTPUT_FILE);
+	file.Load();
+	file.PushBackLine(std::string("-------------- SHARED POINTER TEST --------------"));
+	file.PushBackLine("Using pools of " + std::to_string(objects) + " chunks of " + std::to_string(chunkSize) + " bytes each one.");
+	file.PushBackLine("This test will make " + std::to_string(objects) + " shared entities and drop them (Make), and every tick copy");
+	file.PushBackLine("a random one of them over each of " + std::to_string(objects) + " other shared pointers, dropping the reference they had (Copy).");
+	file.PushBackLine("Allocation sizes: SharedPoolPtr " + std::to_string(sizeof(SharedPoolBlock<Entity, AtomicRefCount>))
+		+ ", SharedPoolPtr with LocalRefCount " + std::to_string(sizeof(SharedPoolBlock<Entity, LocalRefCount>)) + " bytes.");
+	file.PushBackLine("Tests ran for " + std::to_string(ticks) + " ticks.");
+	file.PushBackLine("Ran " + std::to_string(tests) + " tests.");
+	file.PushBackLine("");
+
+	//Weak pointers keep the memory, but not the object
+	{
+		MemoryPool pool(chunkSize, objects);
+		WeakPoolPtr<Entity> weak;
+		{
+			AtomicShared entity = MakeSharedPoolPtr<Entity>(pool, 7u);
+			weak = entity;
+			assert(weak.UseCount() == 1u && weak.Lock()->id == 7u);
+		}
+		assert(weak.Expired() && !weak.Lock() && pool.GetUsedChunks() != 0u);
+		weak.Reset();
+		assert(pool.GetUsedChunks() == 0u);
+	}
+
+	std::vector<int> seeds;
+	srand((unsigned int)time(nullptr));
+	for (uint32_t n = 0; n < tests; n++)
+		seeds.push_back(rand());
+
+	TestTimes atomicMake, atomicCopy, localMake, localCopy, allocateMake, allocateCopy, heapMake, heapCopy;
+	long long copyTime = 0;
+	for (uint32_t n = 0; n < tests; n++)
+	{
+		{
+			MemoryPool pool(chunkSize, objects);
+			srand(seeds[n]);
+			atomicMake.AddSample(SharedPointerCopies<AtomicShared>(objects, ticks,
+				[&pool](uint32_t id) { return MakeSharedPoolPtr<Entity, AtomicRefCount>(pool, id); }, copyTime));
+			atomicCopy.AddSample(copyTime);
+		}
+		{
+			MemoryPool pool(chunkSize, objects);
+			srand(seeds[n]);
+			localMake.AddSample(SharedPointerCopies<LocalShared>(objects, ticks,
+				[&pool](uint32_t id) { return MakeSharedPoolPtr<Entity, LocalRefCount>(pool, id); }, copyTime));
+			localCopy.AddSample(copyTime);
+		}
+		{
+			MemoryPool pool(chunkSize, objects);
+			srand(seeds[n]);
+			allocateMake.AddSample(SharedPointerCopies<std::shared_ptr<Entity>>(objects, ticks,
+				[&pool](uint32_t id) { return std::allocate_shared<Entity>(PoolAllocator<Entity>(pool), id); }, copyTime));
+			allocateCopy.AddSample(copyTime);
+		}
+		srand(seeds[n]);
+		heapMake.AddSample(SharedPointerCopies<std::shared_ptr<Entity>>(objects, ticks,
+			[](uint32_t id) { return std::make_shared<Entity>(id); }, copyTime));
+		heapCopy.AddSample(copyTime);
+	}
+
+	file.PushBackLine(atomicMake.ToString("Make SharedPoolPtr                 "));
+	file.PushBackLine(localMake.ToString("Make SharedPoolPtr (LocalRefCount) "));
+	file.PushBackLine(allocateMake.ToString("Make std::shared_ptr (pool)        "));
+	file.PushBackLine(heapMake.ToString("Make std::shared_ptr (make_shared) "));
+	file.PushBackLine(atomicCopy.ToString("Copy SharedPoolPtr                 "));
+	file.PushBackLine(localCopy.ToString("Copy SharedPoolPtr (LocalRefCount) "));
+	file.PushBackLine(allocateCopy.ToString("Copy std::shared_ptr (pool)        "));
+	file.PushBackLine(heapCopy.ToString("Copy std::shared_ptr (make_shared) "));
+	file.PushBackLine("");
+	file.Save();
+}
+
+void PoolTests::ComparativeFrameTests(uint32_t chunkSize, uint32_t tests, uint32_t ticks)
+{
+	const uint32_t poolChunks = FRAME_TEST_ALLOCATIONS * ((FRAME_TEST_MAX_BYTES + chunkSize - 1) / chunkSize);
+	//Every allocation may need up to the default alignment minus one of padding
+	const uint32_t arenaBytes = FRAME_TEST_ALLOCATIONS * (FRAME_TEST_MAX_BYTES + (uint32_t)alignof(std::max_align_t));
+
+	ReadWriteFile file(DEFAULT_OUTPUT_FILE);
+	file.Load();
+	file.PushBackLine(std::string("-------------- FRAME TEST --------------"));
+	file.PushBackLine("Using pools of " + std::to_string(poolChunks) + " chunks of " + std::to_string(chunkSize) + " bytes each one,");
+	file.PushBackLine("and a FrameArena of " + std::to_string(arenaBytes) + " bytes.");
+	file.PushBackLine("Every tick does " + std::to_string(FRAME_TEST_ALLOCATIONS) + " allocations of 1 to " + std::to_string(FRAME_TEST_MAX_BYTES)
+		+ " bytes and drops all of them at the end of the tick,");
+	file.PushBackLine("freeing them one by one (Alloc/Free), or all at once with MemoryPool::Reset or FrameArena::Reset.");
+	file.PushBackLine("Times are microseconds per tick.");
+	file.PushBackLine("Tests ran for " + std::to_string(ticks) + " ticks.");
+	file.PushBackLine("Ran " + std::to_string(tests) + " tests.");
+	file.PushBackLine("");
+
+	//Reset leaves every engine as if it had just been created
+	for (PoolEngine engine : TESTED_ENGINES)
+	{
+		//A power of two, so the buddy engine can give the whole pool at once
+		MemoryPool pool(chunkSize, 1024u, engine);
+		for (uint32_t n = 0; n < 100u; ++n)
+			pool.Alloc(chunkSize * (n % 7u + 1u));
+		PoolPtr<byte> stale = pool.Alloc(chunkSize);
+		pool.Reset();
+		assert(pool.GetUsedChunks() == 0u);
+#ifdef _DEBUG
+		assert(stale.IsValid() == false && "PoolPtrs from before a Reset must be invalid in debug");
+#endif
+		PoolPtr<byte> whole = pool.Alloc(chunkSize * pool.GetChunkCount());
+		assert(whole.IsValid());
+		pool.Free(whole);
+	}
+	{
+		MemoryPool pool(arenaBytes, 1u);
+		FrameArena arena(pool, arenaBytes);
+		{
+			ArenaScope scope(arena);
+			arena.Allocate(100u);
+			assert(arena.New<uint64_t>(7u) != nullptr && arena.GetUsedBytes() == 112u);
+		}
+		assert(arena.GetUsedBytes() == 0u && arena.Allocate(arenaBytes + 1u) == nullptr);
+	}
+
+	std::vector<int> seeds;
+	srand((unsigned int)time(nullptr));
+	for (uint32_t n = 0; n < tests; n++)
+		seeds.push_back(rand());
+
+	std::vector<uint32_t> sizes(FRAME_TEST_ALLOCATIONS);
+	std::vector<void*> allocations(FRAME_TEST_ALLOCATIONS);
+	const uint32_t engineCount = (uint32_t)std::size(TESTED_ENGINES);
+	std::vector<TestTimes> freeTimes(engineCount), resetTimes(engineCount);
+	TestTimes arenaTimes, mallocTimes;
+	for (uint32_t n = 0; n < tests; n++)
+	{
+		srand(seeds[n]);
+		for (uint32_t& size : sizes)
+			size = std::rand() % FRAME_TEST_MAX_BYTES + 1u;
+
+		for (uint32_t engineN = 0; engineN < engineCount; ++engineN)
+		{
+			MemoryPool pool(chunkSize, poolChunks, TESTED_ENGINES[engineN]);
+			std::chrono::steady_clock::time_point start = Time::GetTime();
+			for (uint32_t tick = 0u; tick < ticks; ++tick)
+			{
+				for (uint32_t m = 0u; m < FRAME_TEST_ALLOCATIONS; ++m)
+				{
+					allocations[m] = pool.Allocate(sizes[m]);
+					*(byte*)allocations[m] = (byte)m;
+				}
+				for (uint32_t m = 0u; m < FRAME_TEST_ALLOCATIONS; ++m)
+					pool.Deallocate(allocations[m]);
+			}
+			freeTimes[engineN].AddSample(Time::GetTimeDiference(start) / ticks);
+
+			start = Time::GetTime();
+			for (uint32_t tick = 0u; tick < ticks; ++tick)
+			{
+				for (uint32_t m = 0u; m < FRAME_TEST_ALLOCATIONS; ++m)
+				{
+					allocations[m] = pool.Allocate(sizes[m]);
+					*(byte*)allocations[m] = (byte)m;
+				}
+				pool.Reset();
+			}
+			resetTimes[engineN].AddSample(Time::GetTimeDiference(start) / ticks);
+		}
+		{
+			MemoryPool pool(arenaBytes, 1u);
+			FrameArena arena(pool, arenaBytes);
+			std::chrono::steady_clock::time_point start = Time::GetTime();
+			for (uint32_t tick = 0u; tick < ticks; ++tick)
+			{
+				for (uint32_t m = 0u; m < FRAME_TEST_ALLOCATIONS; ++m)
+				{
+					allocations[m] = arena.Allocate(sizes[m]);
+					*(byte*)allocations[m] = (byte)m;
+				}
+				arena.Reset();
+			}
+			arenaTimes.AddSample(Time::GetTimeDiference(start) / ticks);
+		}
+		{
+			std::chrono::steady_clock::time_point start = Time::GetTime();
+			for (uint32_t tick = 0u; tick < ticks; ++tick)
+			{
+				for (uint32_t m = 0u; m < FRAME_TEST_ALLOCATIONS; ++m)
+				{
+					allocations[m] = malloc(sizes[m]);
+					*(byte*)allocations[m] = (byte)m;
+				}
+				for (uint32_t m = 0u; m < FRAME_TEST_ALLOCATIONS; ++m)
+					free(allocations[m]);
+			}
+			mallocTimes.AddSample(Time::GetTimeDiference(start) / ticks);
+		}
+	}
+
+	for (uint32_t engineN = 0; engineN < engineCount; ++engineN)
+	{
+		file.PushBackLine(freeTimes[engineN].ToString(GetEngineName(TESTED_ENGINES[engineN]) + " Alloc/Free "));
+		file.PushBackLine(resetTimes[engineN].ToString(GetEngineName(TESTED_ENGINES[engineN]) + " Alloc/Reset"));
+	}
+	file.PushBackLine(arenaTimes.ToString("FrameArena       "));
+	file.PushBackLine(mallocTimes.ToString("Malloc           "));
+	file.PushBackLine("");
+	file.Save();
+}
+
+void PoolTests::ComparativeGrowthTests(uint32_t chunks, uint32_t chunkSize, uint32_t tests, uint32_t ticks)
+{
+	ReadWriteFile file(DEFAULT_OUTPUT_FILE);
+	file.Load();
+	file.PushBackLine(std::string("-------------- GROWTH TEST --------------"));
+	file.PushBackLine("Using pools of up to " + std::to_string(chunks) + "  chunks of " + std::to_string(chunkSize) + " bytes each one.");
+	file.PushBackLine("Same workload as the random performance test, on a fixed pool, on a growable pool that never needs to grow,");
+	file.PushBackLine("and on a growable pool that starts with 1/16 of the chunks and doubles when full.");
+
+	std::vector<int> seeds;
+	srand((unsigned int)time(nullptr));
+	for (uint32_t n = 0; n < tests; n++)
+		seeds.push_back(rand());
+
+	const uint32_t initialChunks = (chunks / 16 != 0 ? chunks / 16 : 1);
+	TestTimes fixedTimes, reservedTimes, growingTimes;
+	uint32_t grownChunks = 0u;
+	for (uint32_t n = 0; n < tests; n++)
+	{
+		srand(seeds[n]);
+		{
+			MemoryPool pool(chunkSize, chunks);
+			std::chrono::steady_clock::time_point start = Time::GetTime();
+			PoolRandomAllocation(pool, ticks, chunks, chunkSize);
+			fixedTimes.AddSample(Time::GetTimeDiference(start));
+		}
+		srand(seeds[n]);
+		{
+			MemoryPool pool(chunkSize, chunks, PoolEngine::FreeMarkers, PoolGrowth(4 * chunks));
+			std::chrono::steady_clock::time_point start = Time::GetTime();
+			PoolRandomAllocation(pool, ticks, chunks, chunkSize);
+			reservedTimes.AddSample(Time::GetTimeDiference(start));
+		}
+		srand(seeds[n]);
+		{
+			MemoryPool pool(chunkSize, initialChunks, PoolEngine::FreeMarkers, PoolGrowth(chunks, PoolGrowthPolicy::Double));
+			std::chrono::steady_clock::time_point start = Time::GetTime();
+			PoolRandomAllocation(pool, ticks, chunks, chunkSize);
+			growingTimes.AddSample(Time::GetTimeDiference(start));
+			grownChunks += pool.GetChunkCount();
+		}
+	}
+
+	file.PushBackLine("Tests ran for " + std::to_string(ticks) + " ticks.");
+	file.PushBackLine("Ran " + std::to_string(tests) + " tests.");
+	file.PushBackLine("");
+	file.PushBackLine(fixedTimes.ToString("Fixed pool          "));
+	file.PushBackLine(reservedTimes.ToString("Growable, not grown "));
+	file.PushBackLine(growingTimes.ToString("Growable, growing   "));
+	file.PushBackLine("Growing pools ended with " + std::to_string(grownChunks / tests) + " chunks on average.");
+	file.PushBackLine("");
+	file.Save();
+}
+
+void PoolTests::ComparativeTrimTests(uint32_t chunkSize)
+{
+	ReadWriteFile file(DEFAULT_OUTPUT_FILE);
+	file.Load();
+	file.PushBackLine(std::string("-------------- TRIM TEST --------------"));
+	file.PushBackLine("Using pools of " + std::to_string(TRIM_TEST_POOL_BYTES / (1024u * 1024u)) + "MB with chunks of " + std::to_string(chunkSize) + " bytes each one.");
+	file.PushBackLine("Pools are filled with 16 chunk allocations and 63 of every 64 of them are freed.");
+	file.PushBackLine("Resident memory is measured after filling, after freeing, and after Trim.");
+	file.PushBackLine("Then the pool is filled and freed again with a purge decay of " + std::to_string(TRIM_TEST_DECAY_MS)
+		+ "ms, and measured after a while of small allocations.");
+	file.PushBackLine("All sizes are in KB above the resident memory before creating the pool.");
+	file.PushBackLine("");
+	for (PoolEngine engine : TESTED_ENGINES)
+		PoolTrimTest(engine, chunkSize, file);
+	file.PushBackLine("");
+	file.Save();
+}
+
+void PoolTests::ComparativeHugePageTests(uint32_t chunkSize, uint32_t tests, uint32_t ticks)
+{
+	ReadWriteFile file(DEFAULT_OUTPUT_FILE);
+	file.Load();
+	file.PushBackLine(std::string("-------------- HUGE PAGE TEST --------------"));
+	file.PushBackLine("Using TLSF pools of " + std::to_string(HUGE_PAGE_TEST_POOL_BYTES / (1024u * 1024u)) + "MB with chunks of " + std::to_string(chunkSize) + " bytes each one.");
+	file.PushBackLine("Pools are filled up to half their size, and then every tick one random allocation is replaced by a new one");
+	file.PushBackLine("and " + std::to_string(HUGE_PAGE_TEST_TOUCHES) + " random allocations are read and written. Only the ticks are measured.");
+
+	std::vector<int> seeds;
+	srand((unsigned int)time(nullptr));
+	for (uint32_t n = 0; n < tests; n++)
+		seeds.push_back(rand());
+
+	file.PushBackLine("Tests ran for " + std::to_string(ticks) + " ticks.");
+	file.PushBackLine("Ran " + std::to_string(tests) + " tests.");
+	file.PushBackLine("");
+	const PoolPages testedPages[] = { PoolPages::Regular, PoolPages::Huge };
+	for (PoolPages pages : testedPages)
+	{
+		TestTimes times;
+		long long tlbMisses = 0;
+		VirtualMemory::HugePages obtained = VirtualMemory::HugePages::None;
+		PoolHugePageTest(pages, seeds, chunkSize, ticks, times, tlbMisses, obtained);
+
+		std::string name = "Regular pages      ";
+		if (pages == PoolPages::Huge)
+		{
+			name = (obtained == VirtualMemory::HugePages::Explicit ? "Huge (explicit)    "
+				: obtained == VirtualMemory::HugePages::Transparent ? "Huge (transparent) "
+				: "Huge (unavailable) ");
+		}
+		file.PushBackLine(times.ToString(name));
+		file.PushBackLine(std::string("    dTLB misses per test: ") + (tlbMisses >= 0 ? std::to_string(tlbMisses / tests) : std::string("unavailable")));
+	}
+	file.PushBackLine("");
+	file.Save();
+}
+
+void PoolTests::ComparativeThreadTests(uint32_t chunks, uint32_t chunkSize, uint32_t tests, uint32_t ticks)
+{
+	ReadWriteFile file(DEFAULT_OUTPUT_FILE);
+	file.Load();
+	file.PushBackLine(std::string("-------------- THREAD TEST --------------"));
+	file.PushBackLine("Using TLSF pools of " + std::to_string(chunks) + " chunks of " + std::to_string(chunkSize) + " bytes per thread.");
+	file.PushBackLine("Every thread does the random performance test workload on the same pool, keeping up to "
+		+ std::to_string(chunks / 8) + " allocations alive.");
+	file.PushBackLine("Compares a locked pool, a thread cached pool, the lock-free pool, a pool with a shard per hardware thread and malloc.");
+	file.PushBackLine("Times are for all threads to finish, so with enough cores they'd stay flat as threads are added.");
+	file.PushBackLine("Running on " + std::to_string(std::thread::hardware_concurrency()) + " hardware threads.");
+
+	std::vector<int> seeds;
+	srand((unsigned int)time(nullptr));
+	for (uint32_t n = 0; n < tests; n++)
+		seeds.push_back(rand());
+
+	file.PushBackLine("Tests ran for " + std::to_string(ticks) + " ticks per thread.");
+	file.PushBackLine("Ran " + std::to_string(tests) + " tests.");
+	file.PushBackLine("");
+	const uint32_t maxLive = (chunks / 8 != 0 ? chunks / 8 : 1);
+	for (uint32_t threads : TESTED_THREAD_COUNTS)
+	{
+		TestTimes lockedTimes, cachedTimes, concurrentTimes, shardedTimes, mallocTimes;
+		for (uint32_t n = 0; n < tests; n++)
+		{
+			{
+				LockedPool pool(chunkSize, chunks * threads);
+				lockedTimes.AddSample(RunThreadChurn<LockedPool, PoolPtr<byte>>(pool, threads, seeds[n], ticks, maxLive, chunkSize));
+			}
+			{
+				ThreadCachedPool pool(chunkSize, chunks * threads);
+				cachedTimes.AddSample(RunThreadChurn<ThreadCachedPool, PoolPtr<byte>>(pool, threads, seeds[n], ticks, maxLive, chunkSize));
+				assert(pool.GetUsedChunks() == pool.GetCachedChunks());
+			}
+			{
+				ConcurrentMemoryPool pool(chunkSize, chunks * threads);
+				concurrentTimes.AddSample(RunThreadChurn<ConcurrentMemoryPool, PoolPtr<byte>>(pool, threads, seeds[n], ticks, maxLive, chunkSize));
+			}
+			{
+				ShardedMemoryPool pool(chunkSize, chunks * threads);
+				shardedTimes.AddSample(RunThreadChurn<ShardedMemoryPool, PoolPtr<byte>>(pool, threads, seeds[n], ticks, maxLive, chunkSize));
+			}
+			MallocAllocator allocator;
+			mallocTimes.AddSample(RunThreadChurn<MallocAllocator, void*>(allocator, threads, seeds[n], ticks, maxLive, chunkSize));
+		}
+		const std::string threadCount = (threads < 10 ? " " : "") + std::to_string(threads) + " threads ";
+		file.PushBackLine(lockedTimes.ToString(threadCount + "Locked pool       "));
+		file.PushBackLine(cachedTimes.ToString(threadCount + "Thread cached pool"));
+		file.PushBackLine(concurrentTimes.ToString(threadCount + "Lock-free pool    "));
+		file.PushBackLine(shardedTimes.ToString(threadCount + "Sharded pool      "));
+		file.PushBackLine(mallocTimes.ToString(threadCount + "Malloc            "));
+	}
+	file.PushBackLine("");
+	file.Save();
+}
+
+void PoolTests::ConcurrentStressTests(uint32_t chunks, uint32_t chunkSize, uint32_t tests, uint32_t ticks)
+{
+	ReadWriteFile file(DEFAULT_OUTPUT_FILE);
+	file.Load();
+	file.PushBackLine(std::string("-------------- CONCURRENT STRESS TEST --------------"));
+	file.PushBackLine("Using lock-free pools of " + std::to_string(chunks) + " chunks of " + std::to_string(chunkSize) + " bytes per thread.");
+	file.PushBackLine("Every thread allocates and frees 1 to 16 chunks at random, keeping up to " + std::to_string(chunks / 8)
+		+ " allocations alive, which may be more than the pool can hold.");
+	file.PushBackLine("Allocations are stamped on both ends and checked when freed. Once all threads finish the pool must be empty and consistent.");
+
+	std::vector<int> seeds;
+	srand((unsigned int)time(nullptr));
+	for (uint32_t n = 0; n < tests; n++)
+		seeds.push_back(rand());
+
+	file.PushBackLine("Tests ran for " + std::to_string(ticks) + " ticks per thread.");
+	file.PushBackLine("Ran " + std::to_string(tests) + " tests.");
+	file.PushBackLine("");
+	const uint32_t maxLive = (chunks / 8 != 0 ? chunks / 8 : 1);
+	for (uint32_t threads : TESTED_THREAD_COUNTS)
+	{
+		TestTimes times;
+		std::atomic<uint32_t> corrupted(0u);
+		std::atomic<uint32_t> failedAllocations(0u);
+		uint32_t inconsistentPools = 0u;
+		for (uint32_t n = 0; n < tests; n++)
+		{
+			ConcurrentMemoryPool pool(chunkSize, chunks * threads);
+			std::promise<void> startSignal;
+			std::shared_future<void> start = startSignal.get_future().share();
+			std::vector<std::thread> workers;
+			for (uint32_t threadN = 0u; threadN < threads; ++threadN)
+			{
+				workers.emplace_back([&, start, threadN]()
+				{
+					start.wait();
+					corrupted += ConcurrentStress(pool, (unsigned int)seeds[n] + threadN, threadN, ticks, maxLive, failedAllocations);
+				});
+			}
+			std::chrono::steady_clock::time_point startTime = Time::GetTime();
+			startSignal.set_value();
+			for (std::thread& worker : workers)
+				worker.join();
+			times.AddSample(Time::GetTimeDiference(startTime));
+
+			if (pool.GetUsedChunks() != 0u || pool.CheckIntegrity() == false)
+				inconsistentPools++;
+		}
+		const std::string threadCount = (threads < 10 ? " " : "") + std::to_string(threads) + " threads ";
+		file.PushBackLine(times.ToString(threadCount));
+		file.PushBackLine("    Corrupted allocations: " + std::to_string(corrupted) + "\tInconsistent pools: " + std::to_string(inconsistentPools)
+			+ "\tFailed allocations: " + std::to_string(failedAllocations));
+		assert(corrupted == 0u && inconsistentPools == 0u);
+	}
+	file.PushBackLine("");
+
+	file.PushBackLine("All threads allocating until the pool is exhausted at the same moment, so they all need a merge at once.");
+	file.PushBackLine("A thread that waits for a merge nobody is doing hangs the test.");
+	for (uint32_t threads : TESTED_THREAD_COUNTS)
+	{
+		TestTimes times;
+		std::atomic<uint64_t> allocatedChunks(0u);
+		uint32_t inconsistentPools = 0u;
+		for (uint32_t n = 0; n < tests; n++)
+		{
+			ConcurrentMemoryPool pool(chunkSize, chunks * threads);
+			std::atomic<uint32_t> arrived(0u);
+			std::vector<std::thread> workers;
+			std::chrono::steady_clock::time_point startTime = Time::GetTime();
+			for (uint32_t threadN = 0u; threadN < threads; ++threadN)
+			{
+				workers.emplace_back([&, threadN]()
+				{
+					allocatedChunks += ConcurrentExhaust(pool, (unsigned int)seeds[n] + threadN, threads, 16u, arrived);
+				});
+			}
+			for (std::thread& worker : workers)
+				worker.join();
+			times.AddSample(Time::GetTimeDiference(startTime));
+
+			if (pool.GetUsedChunks() != 0u || pool.CheckIntegrity() == false)
+				inconsistentPools++;
+		}
+		const std::string threadCount = (threads < 10 ? " " : "") + std::to_string(threads) + " threads ";
+		file.PushBackLine(times.ToString(threadCount));
+		file.PushBackLine("    Chunks allocated per round: " + std::to_string(allocatedChunks / ((uint64_t)tests * 16u))
+			+ " of " + std::to_string(chunks * threads) + "\tInconsistent pools: " + std::to_string(inconsistentPools));
+		assert(inconsistentPools == 0u);
+	}
+	file.PushBackLine("");
+	file.Save();
+}
+
+void PoolTests::ComparativeProducerConsumerTests(uint32_t chunks, uint32_t chunkSize, uint32_t tests, uint32_t ticks)
+{
+	ReadWriteFile file(DEFAULT_OUTPUT_FILE);
+	file.Load();
+	file.PushBackLine(std::string("-------------- PRODUCER/CONSUMER TEST --------------"));
+	file.PushBackLine("Using TLSF pools of " + std::to_string(chunks) + " chunks of " + std::to_string(chunkSize) + " bytes, one per producer.");
+	file.PushBackLine("Every producer allocates 1 to 8 chunks at random and hands them to its consumer, which frees them, with up to "
+		+ std::to_string(chunks / 16) + " allocations waiting.");
+	file.PushBackLine("Compares owned pools, freed remotely and drained by the producer, pools with a lock around them and malloc.");
+	file.PushBackLine("Running on " + std::to_string(std::thread::hardware_concurrency()) + " hardware threads.");
+
+	std::vector<int> seeds;
+	srand((unsigned int)time(nullptr));
+	for (uint32_t n = 0; n < tests; n++)
+		seeds.push_back(rand());
+
+	file.PushBackLine("Tests ran for " + std::to_string(ticks) + " allocations per producer.");
+	file.PushBackLine("Ran " + std::to_string(tests) + " tests.");
+	file.PushBackLine("");
+	const uint32_t handoffCapacity = (chunks / 16 != 0 ? chunks / 16 : 1);
+	for (uint32_t threads : TESTED_THREAD_COUNTS)
+	{
+		//Every pair is a producer and a consumer thread
+		if (threads < 2u)
+			continue;
+		const uint32_t pairs = threads / 2u;
+		TestTimes ownedTimes, lockedTimes, mallocTimes;
+		std::atomic<uint32_t> corrupted(0u);
+		for (uint32_t n = 0; n < tests; n++)
+		{
+			{
+				std::vector<std::unique_ptr<OwnedMemoryPool>> pools;
+				for (uint32_t pairN = 0u; pairN < pairs; ++pairN)
+					pools.emplace_back(new OwnedMemoryPool(chunkSize, chunks));
+				ownedTimes.AddSample(RunProducerConsumer<OwnedMemoryPool, PoolPtr<byte>>(pools, seeds[n], ticks, chunkSize, handoffCapacity, corrupted));
+			}
+			{
+				std::vector<std::unique_ptr<LockedPool>> pools;
+				for (uint32_t pairN = 0u; pairN < pairs; ++pairN)
+					pools.emplace_back(new LockedPool(chunkSize, chunks));
+				lockedTimes.AddSample(RunProducerConsumer<LockedPool, PoolPtr<byte>>(pools, seeds[n], ticks, chunkSize, handoffCapacity, corrupted));
+			}
+			std::vector<std::unique_ptr<MallocAllocator>> allocators;
+			for (uint32_t pairN = 0u; pairN < pairs; ++pairN)
+				allocators.emplace_back(new MallocAllocator());
+			mallocTimes.AddSample(RunProducerConsumer<MallocAllocator, void*>(allocators, seeds[n], ticks, chunkSize, handoffCapacity, corrupted));
+		}
+		const std::string threadCount = (threads < 10 ? " " : "") + std::to_string(threads) + " threads ";
+		file.PushBackLine(ownedTimes.ToString(threadCount + "Owned pool "));
+		file.PushBackLine(lockedTimes.ToString(threadCount + "Locked pool"));
+		file.PushBackLine(mallocTimes.ToString(threadCount + "Malloc     "));
+		assert(corrupted == 0u);
+	}
+	file.PushBackLine("");
+	file.Save();
+}
+
+void PoolTests::ComparativeContainerTests(uint32_t chunks, uint32_t chunkSize, uint32_t tests, uint32_t ticks)
+{
+	typedef std::map<int, int, std::less<int>, PoolAllocator<std::pair<const int, int>>> PoolMap;
+	typedef std::list<int, PoolAllocator<int>> PoolList;
+
+	ReadWriteFile file(DEFAULT_OUTPUT_FILE);
+	file.Load();
+	file.PushBackLine(std::string("-------------- CONTAINER TEST --------------"));
+	file.PushBackLine("Using TLSF pools of " + std::to_string(chunks * 4) + " chunks of " + std::to_string(chunkSize) + " bytes each one.");
+	file.PushBackLine("A std::map<int, int> inserts and erases random keys, and a std::list<int> pushes to the back and pops from the front,");
+	file.PushBackLine("both keeping up to " + std::to_string(chunks / 4) + " elements, with the default allocator and with PoolAllocator.");
+
+	std::vector<int> seeds;
+	srand((unsigned int)time(nullptr));
+	for (uint32_t n = 0; n < tests; n++)
+		seeds.push_back(rand());
+
+	//Shared pointers can keep their control block and object in the pool too
+	{
+		MemoryPool pool(chunkSize, chunks * 4, PoolEngine::Tlsf);
+		{
+			std::shared_ptr<Entity> entity = std::allocate_shared<Entity>(PoolAllocator<Entity>(pool));
+			assert(pool.GetUsedChunks() != 0u);
+		}
+		assert(pool.GetUsedChunks() == 0u);
+	}
+
+	const uint32_t maxLive = (chunks / 4 != 0 ? chunks / 4 : 1);
+	TestTimes mapTimes, poolMapTimes, listTimes, poolListTimes;
+	for (uint32_t n = 0; n < tests; n++)
+	{
+		{
+			std::map<int, int> map;
+			std::chrono::steady_clock::time_point start = Time::GetTime();
+			MapChurn(map, (unsigned int)seeds[n], ticks, maxLive);
+			mapTimes.AddSample(Time::GetTimeDiference(start));
+		}
+		{
+			MemoryPool pool(chunkSize, chunks * 4, PoolEngine::Tlsf);
+			PoolMap map((PoolMap::allocator_type(pool)));
+			std::chrono::steady_clock::time_point start = Time::GetTime();
+			MapChurn(map, (unsigned int)seeds[n], ticks, maxLive);
+			poolMapTimes.AddSample(Time::GetTimeDiference(start));
+		}
+		{
+			std::list<int> list;
+			std::chrono::steady_clock::time_point start = Time::GetTime();
+			ListChurn(list, (unsigned int)seeds[n], ticks, maxLive);
+			listTimes.AddSample(Time::GetTimeDiference(start));
+		}
+		{
+			MemoryPool pool(chunkSize, chunks * 4, PoolEngine::Tlsf);
+			PoolList list((PoolList::allocator_type(pool)));
+			std::chrono::steady_clock::time_point start = Time::GetTime();
+			ListChurn(list, (unsigned int)seeds[n], ticks, maxLive);
+			poolListTimes.AddSample(Time::GetTimeDiference(start));
+		}
+	}
+
+	file.PushBackLine("Tests ran for " + std::to_string(ticks) + " ticks.");
+	file.PushBackLine("Ran " + std::to_string(tests) + " tests.");
+	file.PushBackLine("");
+	file.PushBackLine(mapTimes.ToString("Map  (std::allocator)"));
+	file.PushBackLine(poolMapTimes.ToString("Map  (PoolAllocator) "));
+	file.PushBackLine(listTimes.ToString("List (std::allocator)"));
+	file.PushBackLine(poolListTimes.ToString("List (PoolAllocator) "));
+	file.PushBackLine("");
+	file.Save();
+}
+
+void PoolTests::ComparativeResourceTests(uint32_t chunks, uint32_t chunkSize, uint32_t tests, uint32_t ticks)
+{
+	//Pools can grow up to what the whole test allocates, since the monotonic resource never gives anything back
+	const uint64_t maxChunks = (uint64_t)chunks + (uint64_t)ticks * 32u;
+	const PoolGrowth growth((uint32_t)(maxChunks < MAX_CHUNK_COUNT ? maxChunks : MAX_CHUNK_COUNT));
+
+	ReadWriteFile file(DEFAULT_OUTPUT_FILE);
+	file.Load();
+	file.PushBackLine(std::string("-------------- MEMORY RESOURCE TEST --------------"));
+	file.PushBackLine("Using growable TLSF pools of " + std::to_string(chunks) + " chunks of " + std::to_string(chunkSize)
+		+ " bytes, up to " + std::to_string(growth.m_maxChunkCount) + " chunks.");
+	file.PushBackLine("Same workload as the random performance test, through std::pmr::memory_resource.");
+	file.PushBackLine("Standard pool and monotonic resources are timed over the default resource and over PoolMemoryResource.");
+
+	std::vector<int> seeds;
+	srand((unsigned int)time(nullptr));
+	for (uint32_t n = 0; n < tests; n++)
+		seeds.push_back(rand());
+
+	//Over-aligned allocations must keep their alignment and go back to the pool
+	{
+		MemoryPool pool(chunkSize, chunks, PoolEngine::Tlsf, growth);
+		PoolMemoryResource resource(pool);
+		for (size_t alignment = 1u; alignment <= 8192u; alignment *= 2u)
+		{
+			void* memory = resource.allocate(chunkSize, alignment);
+			assert((uintptr_t)memory % alignment == 0u);
+			resource.deallocate(memory, chunkSize, alignment);
+		}
+		assert(pool.GetUsedChunks() == 0u);
+	}
+
+	TestTimes poolTimes, newDeleteTimes, unsynchronizedTimes, unsynchronizedPoolTimes, monotonicTimes, monotonicPoolTimes;
+	for (uint32_t n = 0; n < tests; n++)
+	{
+		{
+			MemoryPool pool(chunkSize, chunks, PoolEngine::Tlsf, growth);
+			PoolMemoryResource resource(pool);
+			srand(seeds[n]);
+			std::chrono::steady_clock::time_point start = Time::GetTime();
+			ResourceRandomAllocation(resource, ticks, chunks, chunkSize);
+			poolTimes.AddSample(Time::GetTimeDiference(start));
+		}
+		{
+			srand(seeds[n]);
+			std::chrono::steady_clock::time_point start = Time::GetTime();
+			ResourceRandomAllocation(*std::pmr::new_delete_resource(), ticks, chunks, chunkSize);
+			newDeleteTimes.AddSample(Time::GetTimeDiference(start));
+		}
+		{
+			std::pmr::unsynchronized_pool_resource resource;
+			srand(seeds[n]);
+			std::chrono::steady_clock::time_point start = Time::GetTime();
+			ResourceRandomAllocation(resource, ticks, chunks, chunkSize);
+			unsynchronizedTimes.AddSample(Time::GetTimeDiference(start));
+		}
+		{
+			MemoryPool pool(chunkSize, chunks, PoolEngine::Tlsf, growth);
+			PoolMemoryResource upstream(pool);
+			{
+				std::pmr::unsynchronized_pool_resource resource(&upstream);
+				srand(seeds[n]);
+				std::chrono::steady_clock::time_point start = Time::GetTime();
+				ResourceRandomAllocation(resource, ticks, chunks, chunkSize);
+				unsynchronizedPoolTimes.AddSample(Time::GetTimeDiference(start));
+			}
+		}
+		{
+			std::pmr::monotonic_buffer_resource resource;
+			srand(seeds[n]);
+			std::chrono::steady_clock::time_point start = Time::GetTime();
+			ResourceRandomAllocation(resource, ticks, chunks, chunkSize);
+			monotonicTimes.AddSample(Time::GetTimeDiference(start));
+		}
+		{
+			MemoryPool pool(chunkSize, chunks, PoolEngine::Tlsf, growth);
+			PoolMemoryResource upstream(pool);
+			{
+				std::pmr::monotonic_buffer_resource resource(&upstream);
+				srand(seeds[n]);
+				std::chrono::steady_clock::time_point start = Time::GetTime();
+				ResourceRandomAllocation(resource, ticks, chunks, chunkSize);
+				monotonicPoolTimes.AddSample(Time::GetTimeDiference(start));
+			}
+		}
+	}
+
+	file.PushBackLine("Tests ran for " + std::to_string(ticks) + " ticks.");
+	file.PushBackLine("Ran " + std::to_string(tests) + " tests.");
+	file.PushBackLine("");
+	file.PushBackLine(poolTimes.ToString("PoolMemoryResource                    "));
+	file.PushBackLine(newDeleteTimes.ToString("new_delete_resource                   "));
+	file.PushBackLine(unsynchronizedTimes.ToString("unsynchronized_pool_resource          "));
+	file.PushBackLine(unsynchronizedPoolTimes.ToString("unsynchronized_pool_resource over pool"));
+	file.PushBackLine(monotonicTimes.ToString("monotonic_buffer_resource             "));
+	file.PushBackLine(monotonicPoolTimes.ToString("monotonic_buffer_resource over pool   "));
+	file.PushBackLine("");
+	file.Save();
+}
+
+void PoolTests::ComparativeReallocTests(uint32_t chunks, uint32_t chunkSize, uint32_t tests, uint32_t ticks)
+{
+	const uint32_t stepBytes = (chunkSize / 2u != 0u ? chunkSize / 2u : 1u);
+	const uint32_t maxBytes = (chunks / 16u != 0u ? chunks / 16u : 1u) * chunkSize;
+	const uint32_t poolChunks = chunks * 4u;
+
+	ReadWriteFile file(DEFAULT_OUTPUT_FILE);
+	file.Load();
+	file.PushBackLine(std::string("-------------- REALLOC TEST --------------"));
+	file.PushBackLine("Using pools of " + std::to_string(poolChunks) + " chunks of " + std::to_string(chunkSize) + " bytes each one.");
+	file.PushBackLine(std::to_string(REALLOC_TEST_BUFFERS) + " buffers grow " + std::to_string(stepBytes) + " bytes at a time in random order, up to "
+		+ std::to_string(maxBytes) + " bytes, and then shrink back.");
+	file.PushBackLine("Realloc grows into the free chunks following the buffer when it can, Alloc + copy always moves it.");
+	file.PushBackLine("Tests ran for " + std::to_string(ticks) + " ticks.");
+	file.PushBackLine("Ran " + std::to_string(tests) + " tests.");
+	file.PushBackLine("");
+
+	std::vector<int> seeds;
+	srand((unsigned int)time(nullptr));
+	for (uint32_t n = 0; n < tests; n++)
+		seeds.push_back(rand());
+
+	for (PoolEngine engine : TESTED_ENGINES)
+	{
+		TestTimes reallocTimes, copyTimes;
+		uint64_t inPlace = 0u;
+		for (uint32_t n = 0; n < tests; n++)
+		{
+			{
+				MemoryPool pool(chunkSize, poolChunks, engine);
+				std::vector<PoolPtr<byte>> buffers;
+				for (uint32_t bufferN = 0u; bufferN < REALLOC_TEST_BUFFERS; ++bufferN)
+				{
+					buffers.push_back(pool.Alloc(stepBytes));
+					buffers.back()[0] = (byte)bufferN;
+				}
+				std::chrono::steady_clock::time_point start = Time::GetTime();
+				inPlace += BufferGrowth(buffers, (unsigned int)seeds[n], ticks, stepBytes, maxBytes,
+					[&pool](PoolPtr<byte>& buffer, uint32_t bytes)
+					{
+						const bool resized = pool.Realloc(buffer, bytes);
+						(void)resized;
+						assert(resized && "Realloc test pool is too small");
+					});
+				reallocTimes.AddSample(Time::GetTimeDiference(start));
+				for (PoolPtr<byte>& buffer : buffers)
+					pool.Free(buffer);
+				assert(pool.GetUsedChunks() == 0u);
+			}
+			{
+				MemoryPool pool(chunkSize, poolChunks, engine);
+				std::vector<PoolPtr<byte>> buffers;
+				for (uint32_t bufferN = 0u; bufferN < REALLOC_TEST_BUFFERS; ++bufferN)
+				{
+					buffers.push_back(pool.Alloc(stepBytes));
+					buffers.back()[0] = (byte)bufferN;
+				}
+				std::chrono::steady_clock::time_point start = Time::GetTime();
+				BufferGrowth(buffers, (unsigned int)seeds[n], ticks, stepBytes, maxBytes,
+					[&pool](PoolPtr<byte>& buffer, uint32_t bytes)
+					{
+						PoolPtr<byte> moved = pool.Alloc(bytes);
+						const uint32_t usedBytes = pool.GetUsableSize(buffer);
+						memcpy(moved.GetData(), buffer.GetData(), (usedBytes < bytes ? usedBytes : bytes));
+						pool.Free(buffer);
+						buffer = moved;
+					});
+				copyTimes.AddSample(Time::GetTimeDiference(start));
+				for (PoolPtr<byte>& buffer : buffers)
+					pool.Free(buffer);
+			}
+		}
+		const uint64_t resizes = (uint64_t)ticks * tests;
+		file.PushBackLine(reallocTimes.ToString(GetEngineName(engine) + " Realloc     ") + "\tIn place: "
+			+ std::to_string(resizes != 0u ? inPlace * 100u / resizes : 0u) + "%");
+		file.PushBackLine(copyTimes.ToString(GetEngineName(engine) + " Alloc + copy"));
+	}
+
+	TestTimes mallocTimes;
+	uint64_t inPlace = 0u;
+	for (uint32_t n = 0; n < tests; n++)
+	{
+		std::vector<void*> buffers;
+		for (uint32_t bufferN = 0u; bufferN < REALLOC_TEST_BUFFERS; ++bufferN)
+		{
+			buffers.push_back(malloc(stepBytes));
+			((byte*)buffers.back())[0] = (byte)bufferN;
+		}
+		std::chrono::steady_clock::time_point start = Time::GetTime();
+		inPlace += BufferGrowth(buffers, (unsigned int)seeds[n], ticks, stepBytes, maxBytes,
+			[](void*& buffer, uint32_t bytes) { buffer = realloc(buffer, bytes); });
+		mallocTimes.AddSample(Time::GetTimeDiference(start));
+		for (void* buffer : buffers)
+			free(buffer);
+	}
+	const uint64_t resizes = (uint64_t)ticks * tests;
+	file.PushBackLine(mallocTimes.ToString("realloc                 ") + "\tIn place: "
+		+ std::to_string(resizes != 0u ? inPlace * 100u / resizes : 0u) + "%");
+	file.PushBackLine("");
+	file.Save();
+}
+
+void PoolTests::ComparativeBatchTests(uint32_t chunks, uint32_t chunkSize, uint32_t tests, uint32_t ticks)
+{
+	//Room for the fragmented part and a whole batch, wherever the holes are
+	const uint32_t poolChunks = chunks * 4u + BATCH_TEST_MAX_SIZE * 2u;
+
+	ReadWriteFile file(DEFAULT_OUTPUT_FILE);
+	file.Load();
+	file.PushBackLine(std::string("-------------- BATCH TEST --------------"));
+	file.PushBackLine("Using pools of " + std::to_string(poolChunks) + " chunks of " + std::to_string(chunkSize) + " bytes each one,");
+	file.PushBackLine("with " + std::to_string(chunks / 2u) + " allocations of 1 to 4 chunks spread over them.");
+	file.PushBackLine("Every tick allocates a batch of single chunk allocations and frees it, with Alloc/Free and with AllocBatch/FreeBatch.");
+	file.PushBackLine("Times are nanoseconds per allocation and free.");
+	file.PushBackLine("Tests ran for " + std::to_string(ticks) + " ticks.");
+	file.PushBackLine("Ran " + std::to_string(tests) + " tests.");
+	file.PushBackLine("");
+
+	std::vector<int> seeds;
+	srand((unsigned int)time(nullptr));
+	for (uint32_t n = 0; n < tests; n++)
+		seeds.push_back(rand());
+
+	std::vector<PoolPtr<byte>> batch(BATCH_TEST_MAX_SIZE);
+	for (PoolEngine engine : TESTED_ENGINES)
+	{
+		uint32_t crossover = 0u;
+		for (uint32_t batchSize = 1u; batchSize <= BATCH_TEST_MAX_SIZE; batchSize *= 2u)
+		{
+			TestTimes singleTimes, batchTimes;
+			const long long allocations = (long long)ticks * batchSize;
+			for (uint32_t n = 0; n < tests; n++)
+			{
+				{
+					MemoryPool pool(chunkSize, poolChunks, engine);
+					std::vector<PoolPtr<byte>> kept;
+					FragmentPool(pool, (unsigned int)seeds[n], chunks, kept);
+					std::chrono::steady_clock::time_point start = Time::GetTime();
+					for (uint32_t tick = 0u; tick < ticks; ++tick)
+					{
+						for (uint32_t allocationN = 0u; allocationN < batchSize; ++allocationN)
+							batch[allocationN] = pool.Alloc(chunkSize);
+						for (uint32_t allocationN = 0u; allocationN < batchSize; ++allocationN)
+							pool.Free(batch[allocationN]);
+					}
+					singleTimes.AddSample(Time::GetTimeDiference<std::chrono::nanoseconds>(start) / allocations);
+					for (PoolPtr<byte>& allocation : kept)
+						pool.Free(allocation);
+				}
+				{
+					MemoryPool pool(chunkSize, poolChunks, engine);
+					std::vector<PoolPtr<byte>> kept;
+					FragmentPool(pool, (unsigned int)seeds[n], chunks, kept);
+					std::chrono::steady_clock::time_point start = Time::GetTime();
+					for (uint32_t tick = 0u; tick < ticks; ++tick)
+					{
+						const uint32_t allocated = pool.AllocBatch(batchSize, chunkSize, batch.data());
+						assert(allocated == batchSize && "Batch test pool is too small");
+						pool.FreeBatch(batch.data(), allocated);
+					}
+					batchTimes.AddSample(Time::GetTimeDiference<std::chrono::nanoseconds>(start) / allocations);
+					for (PoolPtr<byte>& allocation : kept)
+						pool.Free(allocation);
+					assert(pool.GetUsedChunks() == 0u);
+				}
+			}
+			const std::string batchName = (batchSize < 10u ? "  " : (batchSize < 100u ? " " : "")) + std::to_string(batchSize);
+			file.PushBackLine(singleTimes.ToString(GetEngineName(engine) + " " + batchName + " Alloc/Free     "));
+			file.PushBackLine(batchTimes.ToString(GetEngineName(engine) + " " + batchName + " AllocBatch/FreeBatch"));
+			if (crossover == 0u && batchTimes.total < singleTimes.total)
+				crossover = batchSize;
+		}
+		file.PushBackLine(GetEngineName(engine) + (crossover != 0u
+			? " batches are quicker from " + std::to_string(crossover) + " allocations on."
+			: " batches are never quicker."));
+		file.PushBackLine("");
+	}
+	file.Save();
+}
+
+void PoolTests::ComparativeLatencyTests(uint32_t chunks, uint32_t chunkSize, uint32_t tests, uint32_t ticks)
+{
+	ReadWriteFile file(DEFAULT_OUTPUT_FILE);
+	file.Load();
+	file.PushBackLine(std::string("-------------- LATENCY TEST --------------"));
+	file.PushBackLine("Using a pool with " + std::to_string(chunks) + "  chunks of " + std::to_string(chunkSize) + " bytes each one.");
+	file.PushBackLine("This test will randomly allocate between " + std::to_string(chunkSize)
+		+ " and " + std::to_string(16 * chunkSize) + " bytes or free a random allocation every tick");
+	file.PushBackLine("Every single Alloc/Free is timed, in nanoseconds.");
+
+	std::vector<int> seeds;
+	srand((unsigned int)time(nullptr));
+	for (uint32_t n = 0; n < tests; n++)
+		seeds.push_back(rand());
+
+	file.PushBackLine("Tests ran for " + std::to_string(ticks) + " ticks.");
+	file.PushBackLine("Ran " + std::to_string(tests) + " tests.");
+	file.PushBackLine("");
+	for (PoolEngine engine : TESTED_ENGINES)
+	{
+		TestTimes allocTimes, freeTimes;
+		PoolLatencyTest(engine, seeds, chunks, chunkSize, ticks, allocTimes, freeTimes);
+		file.PushBackLine(allocTimes.ToString(GetEngineName(engine) + " Alloc"));
+		file.PushBackLine(freeTimes.ToString(GetEngineName(engine) + " Free "));
+	}
+
+	TestTimes mallocTimes, freeTimes;
+	MallocLatencyTest(seeds, chunks, chunkSize, ticks, mallocTimes, freeTimes);
+	file.PushBackLine(mallocTimes.ToString("Malloc"));
+	file.PushBackLine(freeTimes.ToString("Free  "));
+	file.PushBackLine("");
+	file.Save();
+}
+
+void PoolTests::ComparativeFragmentationTests(uint32_t chunks, uint32_t chunkSize, uint32_t tests)
+{
+	ReadWriteFile file(DEFAULT_OUTPUT_FILE);
+	file.Load();
+	file.PushBackLine(std::string("-------------- FRAGMENTATION TEST --------------"));
+	file.PushBackLine("Using a pool with " + std::to_string(chunks) + "  chunks of " + std::to_string(chunkSize) + " bytes each one.");
+	file.PushBackLine("This test will keep allocating (and sometimes freeing random allocations) until an allocation fails.");
+	file.PushBackLine("Requested: bytes requested by live allocations / pool size.   Used: chunks taken out of the free memory / chunk count.");
+
+	std::vector<int> seeds;
+	srand((unsigned int)time(nullptr));
+	for (uint32_t n = 0; n < tests; n++)
+		seeds.push_back(rand());
+
+	file.PushBackLine("Ran " + std::to_string(tests) + " tests.");
+	file.PushBackLine("");
+	file.PushBackLine("Sizes between " + std::to_string(chunkSize) + " and " + std::to_string(8 * chunkSize) + " bytes:");
+	for (PoolEngine engine : TESTED_ENGINES)
+		file.PushBackLine(PoolFragmentationTest(engine, seeds, chunks, chunkSize, false));
+	file.PushBackLine("Power of two sizes between " + std::to_string(chunkSize) + " and " + std::to_string(8 * chunkSize) + " bytes:");
+	for (PoolEngine engine : TESTED_ENGINES)
+		file.PushBackLine(PoolFragmentationTest(engine, seeds, chunks, chunkSize, true));
+	file.PushBackLine("");
+	file.Save();
+}
+
+std::string PoolTests::PoolFragmentationTest(PoolEngine engine, const std::vector<int>& seeds, uint32_t chunks, uint32_t chunkSize, bool powerOfTwoSizes)
+{
+	double requestedTotal = 0.0;
+	double usedTotal = 0.0;
+	std::vector<std::pair<PoolPtr<byte>, uint32_t>> allocations;
+	for (uint32_t n = 0; n < seeds.size(); n++)
+	{
+		srand(seeds[n]);
+		MemoryPool pool(chunkSize, chunks, engine);
+		uint64_t requestedBytes = 0u;
+		while (true)
+		{
+			uint32_t randomNumber = std::rand();
+			//One of every four ticks frees memory, so holes of all sizes are left behind
+			if (randomNumber % 4 == 0 && allocations.empty() == false)
+			{
+				uint32_t toFree = (randomNumber / 4) % allocations.size();
+				std::swap(allocations[toFree], allocations.back());
+				requestedBytes -= allocations.back().second;
+				pool.Free(allocations.back().first);
+				allocations.pop_back();
+				continue;
+			}
+
+			uint32_t bytes = (powerOfTwoSizes
+				? (1u << (randomNumber / 4 % 4)) * chunkSize
+				: (randomNumber / 4 % 8 + 1) * chunkSize);
+			PoolPtr<byte> allocation = pool.Alloc(bytes);
+			if (allocation.IsValid() == false)
+				break;
+			allocations.push_back(std::make_pair(allocation, bytes));
+			requestedBytes += bytes;
+		}
+
+		requestedTotal += (double)requestedBytes / ((uint64_t)chunks * chunkSize);
+		usedTotal += (double)pool.GetUsedChunks() / chunks;
+		for (std::pair<PoolPtr<byte>, uint32_t>& allocation : allocations)
+			pool.Free(allocation.first);
+		allocations.clear();
+	}
+	return GetEngineName(engine)
+		+ " Requested: " + std::to_string((int)(100.0 * requestedTotal / seeds.size())) + "%"
+		+ "\tUsed: " + std::to_string((int)(100.0 * usedTotal / seeds.size())) + "%";
+}
+
+void PoolTests::PoolTrimTest(PoolEngine engine, uint32_t chunkSize, ReadWriteFile& file)
+{
+	const size_t baseResident = VirtualMemory::GetResidentBytes();
+	auto residentKB = [baseResident]()
+	{
+		const size_t resident = VirtualMemory::GetResidentBytes();
+		return std::to_string(resident > baseResident ? (resident - baseResident) / 1024u : 0u);
+	};
+
+	const uint32_t chunks = TRIM_TEST_POOL_BYTES / chunkSize;
+	const uint32_t allocationBytes = 16u * chunkSize;
+	MemoryPool pool(chunkSize, chunks, engine);
+	std::vector<PoolPtr<byte>> allocations;
+	auto fill = [&]()
+	{
+		for (PoolPtr<byte> allocation = pool.Alloc(allocationBytes); allocation.IsValid(); allocation = pool.Alloc(allocationBytes))
+		{
+			//Touching the memory so it's actually resident
+			memset(allocation.GetData(), 1, allocationBytes);
+			allocations.push_back(allocation);
+		}
+	};
+	auto freeMost = [&]()
+	{
+		std::vector<PoolPtr<byte>> kept;
+		for (uint32_t n = 0; n < allocations.size(); n++)
+		{
+			if (n % 64 == 0)
+				kept.push_back(allocations[n]);
+			else
+				pool.Free(allocations[n]);
+		}
+		allocations.swap(kept);
+	};
+
+	fill();
+	const std::string filled = residentKB();
+	freeMost();
+	const std::string freed = residentKB();
+	const size_t trimmedBytes = pool.Trim();
+	const std::string trimmed = residentKB();
+
+	fill();
+	pool.SetPurgeDecay(TRIM_TEST_DECAY_MS);
+	freeMost();
+	const std::chrono::steady_clock::time_point start = Time::GetTime();
+	while (Time::GetTimeDiference<std::chrono::milliseconds>(start) < 4 * TRIM_TEST_DECAY_MS)
+	{
+		PoolPtr<byte> allocation = pool.Alloc(chunkSize);
+		pool.Free(allocation);
+	}
+	const std::string decayed = residentKB();
+
+	for (PoolPtr<byte>& allocation : allocations)
+		pool.Free(allocation);
+
+	file.PushBackLine(GetEngineName(engine) + " Filled: " + filled + "\tFreed: " + freed
+		+ "\tTrimmed: " + trimmed + " (" + std::to_string(trimmedBytes / 1024u) + " purged)\tDecayed: " + decayed);
+}
+
+void PoolTests::PoolHugePageTest(PoolPages pages, const std::vector<int>& seeds, uint32_t chunkSize, uint32_t ticks,
+	TestTimes& times, long long& tlbMisses, VirtualMemory::HugePages& obtained)
+{
+	const uint32_t chunks = HUGE_PAGE_TEST_POOL_BYTES / chunkSize;
+	std::vector<PoolPtr<byte>> allocations;
+	for (uint32_t n = 0; n < seeds.size(); n++)
+	{
+		srand(seeds[n]);
+		MemoryPool pool(chunkSize, chunks, PoolEngine::Tlsf, PoolGrowth(), pages);
+		obtained = pool.GetHugePages();
+
+		//rand() may not go past 32767, so two of them are needed to reach all of the allocations
+		auto randomAllocation = [&allocations]() { return (((uint32_t)std::rand() << 15) ^ (uint32_t)std::rand()) % allocations.size(); };
+		for (uint32_t usedChunks = 0u; usedChunks < chunks / 2;)
+		{
+			const uint32_t allocationChunks = std::rand() % 8 + 1;
+			allocations.push_back(pool.Alloc(allocationChunks * chunkSize));
+			allocations.back()[0] = 1;
+			usedChunks += allocationChunks;
+		}
+
+		const int counter = DTlbMisses::Start();
+		std::chrono::steady_clock::time_point start = Time::GetTime();
+		for (uint32_t tick = 0u; tick < ticks; ++tick)
+		{
+			PoolPtr<byte>& replaced = allocations[randomAllocation()];
+			pool.Free(replaced);
+			replaced = pool.Alloc((std::rand() % 8 + 1) * chunkSize);
+			replaced[0] = 1;
+			for (uint32_t touch = 0u; touch < HUGE_PAGE_TEST_TOUCHES; ++touch)
+				allocations[randomAllocation()][0]++;
+		}
+		times.AddSample(Time::GetTimeDiference(start));
+		const long long misses = DTlbMisses::Stop(counter);
+		tlbMisses = (misses >= 0 && tlbMisses >= 0 ? tlbMisses + misses : -1);
+
+		for (PoolPtr<byte>& allocation : allocations)
+			pool.Free(allocation);
+		allocations.clear();
+	}
+}
+
+void PoolTests::PoolLatencyTest(PoolEngine engine, const std::vector<int>& seeds, uint32_t chunks, uint32_t chunkSize, uint32_t ticks,
+	TestTimes& allocTimes, TestTimes& freeTimes)
+{
+	std::vector<PoolPtr<byte>> allocations;
+	for (uint32_t n = 0; n < seeds.size(); n++)
+	{
+		srand(seeds[n]);
+		MemoryPool pool(chunkSize, chunks, engine);
+		for (uint32_t m = 0u; m < ticks; ++m)
+		{
+			uint32_t randomNumber = std::rand();
+			bool allocate = (randomNumber % 2 == 0 || allocations.empty());
+			if (allocate)
+			{
+				std::chrono::steady_clock::time_point start = Time::GetTime();
+				PoolPtr<byte> allocation = pool.Alloc((randomNumber / 2 % 16 + 1) * chunkSize);
+				allocTimes.AddSample(Time::GetTimeDiference<std::chrono::nanoseconds>(start));
+				//If the pool is full, free some memory instead
+				if (allocation.IsValid())
+					allocations.push_back(allocation);
+				else
+					allocate = false;
+			}
+			//Freeing random allocations instead of the oldest one fragments the pool much more
+			if (allocate == false && allocations.empty() == false)
+			{
+				uint32_t toFree = (randomNumber / 2) % allocations.size();
+				std::swap(allocations[toFree], allocations.back());
+				std::chrono::steady_clock::time_point start = Time::GetTime();
+				pool.Free(allocations.back());
+				freeTimes.AddSample(Time::GetTimeDiference<std::chrono::nanoseconds>(start));
+				allocations.pop_back();
+			}
+		}
+		for (PoolPtr<byte>& allocation : allocations)
+			pool.Free(allocation);
+		allocations.clear();
+	}
+}
+
+void PoolTests::MallocLatencyTest(const std::vector<int>& seeds, uint32_t chunks, uint32_t chunkSize, uint32_t ticks,
+	TestTimes& allocTimes, TestTimes& freeTimes)
+{
+	std::vector<void*> allocations;
+	for (uint32_t n = 0; n < seeds.size(); n++)
+	{
+		srand(seeds[n]);
+		for (uint32_t m = 0u; m < ticks; ++m)
+		{
+			uint32_t randomNumber = std::rand();
+			bool allocate = (randomNumber % 2 == 0 || allocations.empty());
+			if (allocate)
+			{
+				std::chrono::steady_clock::time_point start = Time::GetTime();
+				void* allocation = malloc((randomNumber / 2 % 16 + 1) * chunkSize);
+				allocTimes.AddSample(Time::GetTimeDiference<std::chrono::nanoseconds>(start));
+				allocations.push_back(allocation);
+			}
+			//Live allocations are capped around what a full pool would hold
+			if (allocate == false || allocations.size() * 8u > chunks)
+			{
+				uint32_t toFree = (randomNumber / 2) % allocations.size();
+				std::swap(allocations[toFree], allocations.back());
+				std::chrono::steady_clock::time_point start = Time::GetTime();
+				free(allocations.back());
+				freeTimes.AddSample(Time::GetTimeDiference<std::chrono::nanoseconds>(start));
+				allocations.pop_back();
+			}
+		}
+		for (void* allocation : allocations)
+			free(allocation);
+		allocations.clear();
+	}
+}
+
+PoolTests::TestTimes PoolTests::PoolRandomTest(PoolEngine engine, const std::vector<int>& seeds, uint32_t chunks, uint32_t chunkSize, uint32_t ticks,
+	bool rawPointers)
+{
+	TestTimes times;
+	for (uint32_t n = 0; n < seeds.size(); n++)
+	{
+		srand(seeds[n]);
+		MemoryPool pool(chunkSize, chunks, engine);
+		std::chrono::steady_clock::time_point start = Time::GetTime();
+		if (rawPointers)
+			PoolRawRandomAllocation(pool, ticks, chunks, chunkSize);
+		else
+			PoolRandomAllocation(pool, ticks, chunks, chunkSize);
+		times.AddSample(Time::GetTimeDiference(start));
+	}
+	return times;
+}
+
+PoolTests::TestTimes PoolTests::PoolSimpleTest(PoolEngine engine, uint32_t chunks, uint32_t chunkSize, uint32_t tests, uint32_t ticks)
+{
+	struct small { byte a[32]; };
+	struct medium { small a, b; };
+	struct big { medium a, b; };
+
+	TestTimes times;
+	for (uint32_t n = 0; n < tests; ++n)
+	{
+		MemoryPool pool(chunkSize, chunks, engine);
+		std::chrono::steady_clock::time_point start = Time::GetTime();
+		for (uint32_t m = 0; m < ticks; ++m)
+		{
+			PoolPtr<small> ptr1 = pool.Alloc<small>(2);
+			PoolPtr<medium> ptr2 = pool.Alloc<medium>();
+			PoolPtr<big> ptr3 = pool.Alloc<big>();
+			pool.Free(ptr1);
+			pool.Free(ptr2);
+			pool.Free(ptr3);
+		}
+		times.AddSample(Time::GetTimeDiference(start));
+	}
+	return times;
+}
+
+void PoolTests::PoolRandomAllocation(MemoryPool& pool, uint32_t ticks, uint32_t chunks, uint32_t chunkSize)
+{
+	std::queue<PoolPtr<byte>> allocatedChunks;
+
+	for (uint32_t n = 0u; n < ticks; ++n)
+	{
+		uint32_t randomNumber = std::rand() % 8;
+		//If the number is even, we'll allocate new memory
+		if (randomNumber < 4  || n < chunks / 4 || allocatedChunks.empty())
+		{
+			PoolPtr<byte> newChunk = pool.Alloc((randomNumber+1) * chunkSize);
+			if (newChunk.IsValid())
+				allocatedChunks.push(newChunk);
+			else
+			{
+				//Safeguard in case RNG gets real evil and decides to keep on allocating non-stop
+				pool.Free(allocatedChunks.front());
+				allocatedChunks.pop();
+			}
+		}
+		//If the number is odd, we'll free some memory
+		else
+		{
+			pool.Free(allocatedChunks.front());
+			allocatedChunks.pop();
+		}
+	}
+	while (allocatedChunks.empty() == false)
+	{
 		pool.Free(allocatedChunks.front());
 		allocatedChunks.pop();
 	}
 }
 
+void PoolTests::PoolRawRandomAllocation(MemoryPool& pool, uint32_t ticks, uint32_t chunks, uint32_t chunkSize)
+{
+	std::queue<void*> allocatedMemory;
+
+	for (uint32_t n = 0u; n < ticks; ++n)
+	{
+		uint32_t randomNumber = std::rand() % 8;
+		//If the number is even, we'll allocate new memory
+		if (randomNumber < 4 || n < chunks / 4 || allocatedMemory.empty())
+		{
+			void* newMemory = pool.Allocate(((size_t)(randomNumber) + 1) * chunkSize);
+			if (newMemory != nullptr)
+				allocatedMemory.push(newMemory);
+			else
+			{
+				//Safeguard in case RNG gets real evil and decides to keep on allocating non-stop
+				pool.Deallocate(allocatedMemory.front());
+				allocatedMemory.pop();
+			}
+		}
+		//If the number is odd, we'll free some memory
+		else
+		{
+			pool.Deallocate(allocatedMemory.front());
+			allocatedMemory.pop();
+		}
+	}
+	while (allocatedMemory.empty() == false)
+	{
+		pool.Deallocate(allocatedMemory.front());
+		allocatedMemory.pop();
+	}
+}
+
 void PoolTests::MallocRandomAllocation(uint32_t ticks, uint32_t chunks, uint32_t chunkSize)
 {
 	std::queue<void*> allocatedMemory;
@@ -2,15 +2,48 @@
 #define __MEMPOOLTESTS
 
 #include <string>
+#include <vector>
+#include <cstdint>
 
 #define DEFAULT_CHUNK_SIZE 32
 #define DEFAULT_CHUNK_COUNT 512
 #define DEFAULT_SIMPLE_TEST_COUNT 1000
 #define DEFAULT_RANDOM_TEST_COUNT 1000
+#define DEFAULT_LATENCY_TEST_COUNT 100
+#define DEFAULT_FRAGMENTATION_TEST_COUNT 100
+#define DEFAULT_OBJECT_POOL_TEST_COUNT 100
+#define DEFAULT_GROWTH_TEST_COUNT 100
+#define DEFAULT_HUGE_PAGE_TEST_COUNT 10
+#define HUGE_PAGE_TEST_POOL_BYTES (256u * 1024u * 1024u)
+//Random allocations read and written every tick of the huge page test
+#define HUGE_PAGE_TEST_TOUCHES 64u
+#define DEFAULT_THREAD_TEST_COUNT 20
+#define DEFAULT_CONCURRENT_STRESS_TEST_COUNT 20
+#define DEFAULT_PRODUCER_CONSUMER_TEST_COUNT 20
+#define DEFAULT_CONTAINER_TEST_COUNT 100
+#define DEFAULT_RESOURCE_TEST_COUNT 100
+#define DEFAULT_REALLOC_TEST_COUNT 100
+//Buffers grown at the same time by the realloc test
+#define REALLOC_TEST_BUFFERS 8u
+#define DEFAULT_BATCH_TEST_COUNT 100
+//Batch sizes timed by the batch test, doubling from 1 up to this one
+#define BATCH_TEST_MAX_SIZE 128u
+#define DEFAULT_UNIQUE_POINTER_TEST_COUNT 100
+#define DEFAULT_SHARED_POINTER_TEST_COUNT 100
+#define DEFAULT_FRAME_TEST_COUNT 10
+//Allocations done and dropped every tick of the frame test, of 1 to FRAME_TEST_MAX_BYTES bytes
+#define FRAME_TEST_ALLOCATIONS 10000u
+#define FRAME_TEST_MAX_BYTES 256u
+#define TRIM_TEST_POOL_BYTES (64u * 1024u * 1024u)
+#define TRIM_TEST_DECAY_MS 50u
 #define DEFAULT_TEST_TICKS 1000
 #define DEFAULT_OUTPUT_FILE "MemoryPoolTestOutput.txt"
 
 class MemoryPool;
+class ReadWriteFile;
+enum class PoolEngine;
+enum class PoolPages;
+namespace VirtualMemory { enum class HugePages; }
 
 class PoolTests
 {
@@ -26,6 +59,25 @@ class PoolTests
 		char a[8];
 	};
 
+	struct alignas(64) testStructAligned
+	{
+		testStructAligned() : a{ 'a','l','i','g','n','e','d' } {}
+		char a[7];
+	};
+
+	//Slowest, quickest and average times of a batch of tests
+	struct TestTimes
+	{
+		TestTimes();
+		void AddSample(long long time);
+		std::string ToString(const std::string& name) const;
+
+		long long slowest;
+		long long quickest;
+		long long total;
+		uint32_t samples;
+	};
+
 public:
 	//void RunAllTests() const;
 
@@ -35,9 +87,58 @@ public:
 
 	static void ComparativeRandomTests(uint32_t chunks, uint32_t chunkSize, uint32_t tests, uint32_t ticks);
 	static void ComparativeSimpleTests(uint32_t chunks, uint32_t chunkSize, uint32_t tests, uint32_t ticks);
+	//Entity churn with ObjectPool, MemoryPool::Alloc<T> and new
+	static void ComparativeObjectPoolTests(uint32_t objects, uint32_t tests, uint32_t ticks);
+	//Fixed pools against growable ones, both when they grow and when they don't
+	static void ComparativeGrowthTests(uint32_t chunks, uint32_t chunkSize, uint32_t tests, uint32_t ticks);
+	//Times every single operation to find the worst case cost of Alloc and Free
+	static void ComparativeLatencyTests(uint32_t chunks, uint32_t chunkSize, uint32_t tests, uint32_t ticks);
+	//Fills the pools until an allocation fails to see how much of them could actually be used
+	static void ComparativeFragmentationTests(uint32_t chunks, uint32_t chunkSize, uint32_t tests);
+	//Resident memory of big pools after freeing most of them, before and after trimming, and with decay purging
+	static void ComparativeTrimTests(uint32_t chunkSize);
+	//Many threads sharing a pool, with a lock around it, with thread caches, and malloc
+	static void ComparativeThreadTests(uint32_t chunks, uint32_t chunkSize, uint32_t tests, uint32_t ticks);
+	//Hammers the lock-free pool from many threads, checking no allocation is handed out twice and the pool ends consistent
+	static void ConcurrentStressTests(uint32_t chunks, uint32_t chunkSize, uint32_t tests, uint32_t ticks);
+	//Producer threads allocate and hand the memory to consumer threads, which free it
+	static void ComparativeProducerConsumerTests(uint32_t chunks, uint32_t chunkSize, uint32_t tests, uint32_t ticks);
+	//Insert/erase churn on std::map and std::list, with the default allocator and with PoolAllocator
+	static void ComparativeContainerTests(uint32_t chunks, uint32_t chunkSize, uint32_t tests, uint32_t ticks);
+	//Random performance test workload on PoolMemoryResource, the standard pmr resources, and the standard ones over PoolMemoryResource
+	static void ComparativeResourceTests(uint32_t chunks, uint32_t chunkSize, uint32_t tests, uint32_t ticks);
+	//Growing buffers with Realloc, with Alloc + copy + Free, and with realloc
+	static void ComparativeReallocTests(uint32_t chunks, uint32_t chunkSize, uint32_t tests, uint32_t ticks);
+	//Alloc and Free one at a time against AllocBatch and FreeBatch, for growing batch sizes
+	static void ComparativeBatchTests(uint32_t chunks, uint32_t chunkSize, uint32_t tests, uint32_t ticks);
+	//Entity churn in a std::vector of UniquePoolPtr, of std::unique_ptr with new and with a pool deleter, and of PoolPtr
+	static void ComparativeUniquePointerTests(uint32_t objects, uint32_t tests, uint32_t ticks);
+	//Making, copying and dropping SharedPoolPtrs with both count policies and std::shared_ptrs from allocate_shared and make_shared
+	static void ComparativeSharedPointerTests(uint32_t objects, uint32_t tests, uint32_t ticks);
+	//Ticks of short lived allocations dropped at the end of the tick, with Alloc/Free, pool Reset, a FrameArena and malloc
+	static void ComparativeFrameTests(uint32_t chunkSize, uint32_t tests, uint32_t ticks);
+	//Random access over a big pool with regular and huge pages, reporting time and data TLB misses
+	static void ComparativeHugePageTests(uint32_t chunkSize, uint32_t tests, uint32_t ticks);
 
 private:
+	//*rawPointers* uses Allocate/Deallocate instead of PoolPtrs
+	static TestTimes PoolRandomTest(PoolEngine engine, const std::vector<int>& seeds, uint32_t chunks, uint32_t chunkSize, uint32_t ticks,
+		bool rawPointers);
+	static TestTimes PoolSimpleTest(PoolEngine engine, uint32_t chunks, uint32_t chunkSize, uint32_t tests, uint32_t ticks);
+	static std::string PoolFragmentationTest(PoolEngine engine, const std::vector<int>& seeds, uint32_t chunks, uint32_t chunkSize, bool powerOfTwoSizes);
+	static void PoolTrimTest(PoolEngine engine, uint32_t chunkSize, ReadWriteFile& file);
+	static void PoolHugePageTest(PoolPages pages, const std::vector<int>& seeds, uint32_t chunkSize, uint32_t ticks,
+		TestTimes& times, long long& tlbMisses, VirtualMemory::HugePages& obtained);
+	static void PoolLatencyTest(PoolEngine engine, const std::vector<int>& seeds, uint32_t chunks, uint32_t chunkSize, uint32_t ticks,
+		TestTimes& allocTimes, TestTimes& freeTimes);
+	static void MallocLatencyTest(const std::vector<int>& seeds, uint32_t chunks, uint32_t chunkSize, uint32_t ticks,
+		TestTimes& allocTimes, TestTimes& freeTimes);
+
+	//Writes how many bytes of bookkeeping every engine needs per chunk
+	static void PushMetadataReport(ReadWriteFile& file, uint32_t chunks, uint32_t chunkSize);
+
 	static void PoolRandomAllocation(MemoryPool& pool, uint32_t ticks, uint32_t chunks, uint32_t chunkSize);
+	static void PoolRawRandomAllocation(MemoryPool& pool, uint32_t ticks, uint32_t chunks, uint32_t chunkSize);
 	static void MallocRandomAllocation(uint32_t ticks, uint32_t chunks, uint32_t chunkSize);
 	static void NewRandomAllocation(uint32_t ticks, uint32_t chunks, uint32_t chunkSize);
 };
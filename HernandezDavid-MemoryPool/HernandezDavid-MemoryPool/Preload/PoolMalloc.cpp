@@ -0,0 +1,339 @@
+/*
+malloc replacement to run unmodified programs over MemoryPools, built as a shared library and loaded with LD_PRELOAD
+POSIX and glibc only, it isn't part of the Visual Studio project but builds with the Makefile next to it. See the README for how to use it
+
+- Requests up to MAX_POOLED_SIZE go to one of a set of growable pools, with chunks of every power of two from MIN_POOLED_SIZE
+	Every allocation is a single chunk of the smallest class that fits, so it's aligned on the chunk size
+	Every class has its own lock
+- Bigger requests, or the ones of a full class, get their own mapping, with a header right before the returned address
+- Pointers that aren't ours (allocated while the pools were being built, or by the pools themselves) are forwarded to glibc
+- fork takes every class lock first, so the child never starts with a lock held by a thread that doesn't exist there
+*/
+#include "../MemoryPool/MemoryPool.h"
+#include "../MemoryPool/BitUtils.h"
+#include "../MemoryPool/VirtualMemory.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+#include <dlfcn.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#define MIN_POOLED_SIZE_LOG2 4u
+#define MAX_POOLED_SIZE_LOG2 15u
+#define MIN_POOLED_SIZE (1u << MIN_POOLED_SIZE_LOG2)
+#define MAX_POOLED_SIZE (1u << MAX_POOLED_SIZE_LOG2)
+#define POOLED_CLASS_COUNT (MAX_POOLED_SIZE_LOG2 - MIN_POOLED_SIZE_LOG2 + 1u)
+//Address space every class may grow into, and what it starts with
+#define POOLED_CLASS_RESERVED_BYTES (256u * 1024u * 1024u)
+#define POOLED_CLASS_INITIAL_BYTES (64u * 1024u)
+//Header in front of mapped allocations. Checked to tell them apart from glibc ones, which are never in a pool
+#define LARGE_HEADER_SIZE 16u
+#define LARGE_HEADER_MAGIC 0x9E3779B97F4A7C15ull
+
+//The glibc allocator, for whatever isn't ours
+extern "C"
+{
+	void* __libc_malloc(size_t bytes);
+	void* __libc_calloc(size_t count, size_t bytes);
+	void* __libc_realloc(void* memory, size_t bytes);
+	void* __libc_memalign(size_t alignment, size_t bytes);
+	void __libc_free(void* memory);
+}
+
+namespace
+{
+	//Every class takes whole cache lines, which keeps the locks of two classes out of the same one
+	struct alignas(64) SizeClass
+	{
+		//Everything is initialized in place, so the classes are ready before any static constructor runs
+		std::mutex m_mutex;
+		MemoryPool* m_pool = nullptr;
+	};
+
+	enum InitState { NotInitialized, Initializing, Initialized };
+
+	SizeClass s_sizeClasses[POOLED_CLASS_COUNT];
+	alignas(MemoryPool) unsigned char s_poolStorage[POOLED_CLASS_COUNT][sizeof(MemoryPool)];
+	std::atomic<int> s_initState(NotInitialized);
+	//Set while a thread is inside the pools, so anything they allocate themselves comes from glibc instead of locking again
+	thread_local bool s_insidePools __attribute__((tls_model("initial-exec"))) = false;
+
+	//Marks the calling thread as inside the pools while alive
+	struct PoolScope
+	{
+		PoolScope() { s_insidePools = true; }
+		~PoolScope() { s_insidePools = false; }
+	};
+
+	//Before fork: every class lock is taken, always in the same order, so no other thread is left inside a pool
+	void LockAllClasses()
+	{
+		for (SizeClass& sizeClass : s_sizeClasses)
+			sizeClass.m_mutex.lock();
+	}
+
+	//After fork, in both processes: the thread that forked owns every lock, in the child too, so it releases them
+	void UnlockAllClasses()
+	{
+		for (uint32_t n = POOLED_CLASS_COUNT; n-- > 0u;)
+			s_sizeClasses[n].m_mutex.unlock();
+	}
+
+	//Whether the pools can be used by this thread right now, building them on the first call
+	bool ArePoolsReady()
+	{
+		if (s_insidePools)
+			return false;
+		if (s_initState.load(std::memory_order_acquire) == Initialized)
+			return true;
+
+		int expected = NotInitialized;
+		if (s_initState.compare_exchange_strong(expected, Initializing, std::memory_order_acq_rel) == false)
+			return false;
+		//The pools are never destroyed, since memory may still be freed after static destructors run
+		PoolScope scope;
+		for (uint32_t n = 0u; n < POOLED_CLASS_COUNT; ++n)
+		{
+			const uint32_t chunkSize = MIN_POOLED_SIZE << n;
+			s_sizeClasses[n].m_pool = new(s_poolStorage[n]) MemoryPool(chunkSize, POOLED_CLASS_INITIAL_BYTES / chunkSize,
+				PoolEngine::Tlsf, PoolGrowth(POOLED_CLASS_RESERVED_BYTES / chunkSize));
+		}
+		//Registered once the locks are in use. Whatever glibc allocates for it is its own memory, since the scope is still set
+		pthread_atfork(LockAllClasses, UnlockAllClasses, UnlockAllClasses);
+		s_initState.store(Initialized, std::memory_order_release);
+		return true;
+	}
+
+	inline uint32_t GetSizeClass(size_t bytes)
+	{
+		return (bytes <= MIN_POOLED_SIZE ? 0u : Bits::CeilLog2((uint32_t)bytes) - MIN_POOLED_SIZE_LOG2);
+	}
+
+	//Class owning *memory*, or POOLED_CLASS_COUNT if none does
+	inline uint32_t FindSizeClass(const void* memory)
+	{
+		if (s_initState.load(std::memory_order_acquire) != Initialized)
+			return POOLED_CLASS_COUNT;
+		for (uint32_t n = 0u; n < POOLED_CLASS_COUNT; ++n)
+		{
+			if (s_sizeClasses[n].m_pool->Owns(memory))
+				return n;
+		}
+		return POOLED_CLASS_COUNT;
+	}
+
+	void* LargeAlloc(size_t bytes, size_t alignment)
+	{
+		if (alignment < LARGE_HEADER_SIZE)
+			alignment = LARGE_HEADER_SIZE;
+		if (bytes > SIZE_MAX - alignment - VirtualMemory::GetPageSize())
+			return nullptr;
+		//The mapping is page aligned, so the first aligned address past the header is at most *alignment* bytes in
+		const size_t mappingSize = VirtualMemory::RoundToPages(bytes + alignment);
+		void* mapping = mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (mapping == MAP_FAILED)
+			return nullptr;
+		byte* memory = (byte*)(((uintptr_t)mapping + LARGE_HEADER_SIZE + alignment - 1u) & ~(uintptr_t)(alignment - 1u));
+		const uint64_t header[2] = { mappingSize, (uint64_t)(memory - (byte*)mapping) ^ mappingSize ^ LARGE_HEADER_MAGIC };
+		memcpy(memory - LARGE_HEADER_SIZE, header, LARGE_HEADER_SIZE);
+		return memory;
+	}
+
+	//Size of the mapping of a large allocation, and its distance to the start of it. False if *memory* isn't one
+	bool GetLargeMapping(const void* memory, size_t& mappingSize, size_t& offset)
+	{
+		uint64_t header[2];
+		memcpy(header, (const byte*)memory - LARGE_HEADER_SIZE, LARGE_HEADER_SIZE);
+		mappingSize = (size_t)header[0];
+		offset = (size_t)(header[1] ^ header[0] ^ LARGE_HEADER_MAGIC);
+		return mappingSize % VirtualMemory::GetPageSize() == 0u && offset >= LARGE_HEADER_SIZE && offset < mappingSize
+			&& ((uintptr_t)memory - offset) % VirtualMemory::GetPageSize() == 0u;
+	}
+
+	void* PoolAlloc(size_t bytes, size_t alignment = MIN_POOLED_SIZE)
+	{
+		if (ArePoolsReady() == false)
+			return (alignment <= MIN_POOLED_SIZE ? __libc_malloc(bytes) : __libc_memalign(alignment, bytes));
+
+		//Chunks are aligned on their size, so aligned requests just take a class at least as big as the alignment
+		const size_t classBytes = (bytes > alignment ? bytes : alignment);
+		if (classBytes <= MAX_POOLED_SIZE)
+		{
+			SizeClass& sizeClass = s_sizeClasses[GetSizeClass(classBytes)];
+			PoolScope scope;
+			std::lock_guard<std::mutex> classLock(sizeClass.m_mutex);
+			void* memory = sizeClass.m_pool->Allocate(classBytes);
+			if (memory != nullptr)
+				return memory;
+		}
+		return LargeAlloc(bytes, alignment);
+	}
+
+	void PoolFree(void* memory)
+	{
+		if (memory == nullptr)
+			return;
+		const uint32_t classN = FindSizeClass(memory);
+		if (classN != POOLED_CLASS_COUNT)
+		{
+			SizeClass& sizeClass = s_sizeClasses[classN];
+			PoolScope scope;
+			std::lock_guard<std::mutex> classLock(sizeClass.m_mutex);
+			sizeClass.m_pool->Deallocate(memory);
+			return;
+		}
+		size_t mappingSize, offset;
+		if (GetLargeMapping(memory, mappingSize, offset))
+			munmap((byte*)memory - offset, mappingSize);
+		else
+			__libc_free(memory);
+	}
+
+	//Bytes usable from *memory*, which is ours. 0 if it belongs to glibc
+	size_t GetUsableSize(const void* memory)
+	{
+		const uint32_t classN = FindSizeClass(memory);
+		if (classN != POOLED_CLASS_COUNT)
+			return MIN_POOLED_SIZE << classN;
+		size_t mappingSize, offset;
+		if (GetLargeMapping(memory, mappingSize, offset))
+			return mappingSize - offset;
+		return 0u;
+	}
+
+	void* NewOrThrow(size_t bytes, size_t alignment = MIN_POOLED_SIZE)
+	{
+		void* memory = PoolAlloc(bytes != 0u ? bytes : 1u, alignment);
+		if (memory == nullptr)
+			throw std::bad_alloc();
+		return memory;
+	}
+}
+
+extern "C"
+{
+	void* malloc(size_t bytes)
+	{
+		return PoolAlloc(bytes);
+	}
+
+	void free(void* memory)
+	{
+		PoolFree(memory);
+	}
+
+	void* calloc(size_t count, size_t bytes)
+	{
+		if (bytes != 0u && count > SIZE_MAX / bytes)
+		{
+			errno = ENOMEM;
+			return nullptr;
+		}
+		if (ArePoolsReady() == false)
+			return __libc_calloc(count, bytes);
+		void* memory = PoolAlloc(count * bytes);
+		//Fresh mappings are already zeroed, only pooled memory may have been used before
+		if (memory != nullptr && FindSizeClass(memory) != POOLED_CLASS_COUNT)
+			memset(memory, 0, count * bytes);
+		return memory;
+	}
+
+	void* realloc(void* memory, size_t bytes)
+	{
+		if (memory == nullptr)
+			return PoolAlloc(bytes);
+		if (bytes == 0u)
+		{
+			PoolFree(memory);
+			return nullptr;
+		}
+		const size_t usableSize = GetUsableSize(memory);
+		if (usableSize == 0u)
+			return __libc_realloc(memory, bytes);
+		//Kept in place unless it grows out of it or would fit in a class less than half its size
+		if (bytes <= usableSize && bytes > usableSize / 2u)
+			return memory;
+		void* newMemory = PoolAlloc(bytes);
+		if (newMemory == nullptr)
+			return nullptr;
+		memcpy(newMemory, memory, (bytes < usableSize ? bytes : usableSize));
+		PoolFree(memory);
+		return newMemory;
+	}
+
+	int posix_memalign(void** memory, size_t alignment, size_t bytes)
+	{
+		if (alignment < sizeof(void*) || (alignment & (alignment - 1u)) != 0u)
+			return EINVAL;
+		*memory = PoolAlloc(bytes, alignment);
+		return (*memory != nullptr ? 0 : ENOMEM);
+	}
+
+	void* aligned_alloc(size_t alignment, size_t bytes)
+	{
+		if (alignment == 0u || (alignment & (alignment - 1u)) != 0u)
+		{
+			errno = EINVAL;
+			return nullptr;
+		}
+		return PoolAlloc(bytes, alignment);
+	}
+
+	void* memalign(size_t alignment, size_t bytes)
+	{
+		//Like glibc, any alignment is taken, rounded up to the next power of two
+		if (alignment <= MIN_POOLED_SIZE)
+			return PoolAlloc(bytes);
+		if (alignment > SIZE_MAX / 2u + 1u)
+		{
+			errno = EINVAL;
+			return nullptr;
+		}
+		size_t powerOfTwo = MIN_POOLED_SIZE;
+		while (powerOfTwo < alignment)
+			powerOfTwo <<= 1u;
+		return PoolAlloc(bytes, powerOfTwo);
+	}
+
+	size_t malloc_usable_size(void* memory)
+	{
+		if (memory == nullptr)
+			return 0u;
+		const size_t usableSize = GetUsableSize(memory);
+		if (usableSize != 0u)
+			return usableSize;
+		//Only reached for glibc memory, so the lookup can't recurse into this library
+		typedef size_t (*UsableSizeFunc)(void*);
+		static UsableSizeFunc libcUsableSize = (UsableSizeFunc)dlsym(RTLD_NEXT, "malloc_usable_size");
+		return (libcUsableSize != nullptr ? libcUsableSize(memory) : 0u);
+	}
+}
+
+void* operator new(size_t bytes) { return NewOrThrow(bytes); }
+void* operator new[](size_t bytes) { return NewOrThrow(bytes); }
+void* operator new(size_t bytes, const std::nothrow_t&) noexcept { return PoolAlloc(bytes != 0u ? bytes : 1u); }
+void* operator new[](size_t bytes, const std::nothrow_t&) noexcept { return PoolAlloc(bytes != 0u ? bytes : 1u); }
+void* operator new(size_t bytes, std::align_val_t alignment) { return NewOrThrow(bytes, (size_t)alignment); }
+void* operator new[](size_t bytes, std::align_val_t alignment) { return NewOrThrow(bytes, (size_t)alignment); }
+void* operator new(size_t bytes, std::align_val_t alignment, const std::nothrow_t&) noexcept { return PoolAlloc(bytes != 0u ? bytes : 1u, (size_t)alignment); }
+void* operator new[](size_t bytes, std::align_val_t alignment, const std::nothrow_t&) noexcept { return PoolAlloc(bytes != 0u ? bytes : 1u, (size_t)alignment); }
+
+void operator delete(void* memory) noexcept { PoolFree(memory); }
+void operator delete[](void* memory) noexcept { PoolFree(memory); }
+void operator delete(void* memory, size_t) noexcept { PoolFree(memory); }
+void operator delete[](void* memory, size_t) noexcept { PoolFree(memory); }
+void operator delete(void* memory, const std::nothrow_t&) noexcept { PoolFree(memory); }
+void operator delete[](void* memory, const std::nothrow_t&) noexcept { PoolFree(memory); }
+void operator delete(void* memory, std::align_val_t) noexcept { PoolFree(memory); }
+void operator delete[](void* memory, std::align_val_t) noexcept { PoolFree(memory); }
+void operator delete(void* memory, size_t, std::align_val_t) noexcept { PoolFree(memory); }
+void operator delete[](void* memory, size_t, std::align_val_t) noexcept { PoolFree(memory); }
+void operator delete(void* memory, std::align_val_t, const std::nothrow_t&) noexcept { PoolFree(memory); }
+void operator delete[](void* memory, std::align_val_t, const std::nothrow_t&) noexcept { PoolFree(memory); }
\ No newline at end of file
@@ -9,6 +9,22 @@ int main(int argc, char** argv)
 	int basicFunctionalityTest = -1;
 	int simplePerfTestIterations = -1;
 	int randomPerfTestIterations = -1;
+	int latencyTestIterations = -1;
+	int fragmentationTestIterations = -1;
+	int objectPoolTestIterations = -1;
+	int growthTestIterations = -1;
+	int trimTest = -1;
+	int hugePageTestIterations = -1;
+	int threadTestIterations = -1;
+	int stressTestIterations = -1;
+	int producerConsumerTestIterations = -1;
+	int containerTestIterations = -1;
+	int resourceTestIterations = -1;
+	int reallocTestIterations = -1;
+	int batchTestIterations = -1;
+	int uniquePointerTestIterations = -1;
+	int sharedPointerTestIterations = -1;
+	int frameTestIterations = -1;
 	int ticksPerTest = DEFAULT_TEST_TICKS;
 	int pauseAtEnd = 0;
 
@@ -30,7 +46,7 @@ int main(int argc, char** argv)
 	int c;
 	
 	try {
-		while ((c = getopt_long(argc, argv, "fc:b:t:s::r::p", longOptions, &optionIndex)) != -1)
+		while ((c = getopt_long(argc, argv, "fc:b:t:s::r::l::g::o::w::mu::x::y::q::k::e::a::n::j::i::v::p", longOptions, &optionIndex)) != -1)
 		{
 			switch (c)
 			{
@@ -59,6 +75,54 @@ int main(int argc, char** argv)
 			case 'r':
 				randomPerfTestIterations = (optarg ? std::stoi(optarg) : DEFAULT_RANDOM_TEST_COUNT);
 				break;
+			case 'l':
+				latencyTestIterations = (optarg ? std::stoi(optarg) : DEFAULT_LATENCY_TEST_COUNT);
+				break;
+			case 'g':
+				fragmentationTestIterations = (optarg ? std::stoi(optarg) : DEFAULT_FRAGMENTATION_TEST_COUNT);
+				break;
+			case 'o':
+				objectPoolTestIterations = (optarg ? std::stoi(optarg) : DEFAULT_OBJECT_POOL_TEST_COUNT);
+				break;
+			case 'w':
+				growthTestIterations = (optarg ? std::stoi(optarg) : DEFAULT_GROWTH_TEST_COUNT);
+				break;
+			case 'm':
+				trimTest = 1;
+				break;
+			case 'u':
+				hugePageTestIterations = (optarg ? std::stoi(optarg) : DEFAULT_HUGE_PAGE_TEST_COUNT);
+				break;
+			case 'x':
+				threadTestIterations = (optarg ? std::stoi(optarg) : DEFAULT_THREAD_TEST_COUNT);
+				break;
+			case 'y':
+				stressTestIterations = (optarg ? std::stoi(optarg) : DEFAULT_CONCURRENT_STRESS_TEST_COUNT);
+				break;
+			case 'q':
+				producerConsumerTestIterations = (optarg ? std::stoi(optarg) : DEFAULT_PRODUCER_CONSUMER_TEST_COUNT);
+				break;
+			case 'k':
+				containerTestIterations = (optarg ? std::stoi(optarg) : DEFAULT_CONTAINER_TEST_COUNT);
+				break;
+			case 'e':
+				resourceTestIterations = (optarg ? std::stoi(optarg) : DEFAULT_RESOURCE_TEST_COUNT);
+				break;
+			case 'a':
+				reallocTestIterations = (optarg ? std::stoi(optarg) : DEFAULT_REALLOC_TEST_COUNT);
+				break;
+			case 'n':
+				batchTestIterations = (optarg ? std::stoi(optarg) : DEFAULT_BATCH_TEST_COUNT);
+				break;
+			case 'j':
+				uniquePointerTestIterations = (optarg ? std::stoi(optarg) : DEFAULT_UNIQUE_POINTER_TEST_COUNT);
+				break;
+			case 'i':
+				sharedPointerTestIterations = (optarg ? std::stoi(optarg) : DEFAULT_SHARED_POINTER_TEST_COUNT);
+				break;
+			case 'v':
+				frameTestIterations = (optarg ? std::stoi(optarg) : DEFAULT_FRAME_TEST_COUNT);
+				break;
 			case 't':
 				ticksPerTest = std::stoi(optarg);
 				break;
@@ -86,11 +150,35 @@ int main(int argc, char** argv)
 		return 1;
 	}
 
-	if (basicFunctionalityTest == -1 && simplePerfTestIterations == -1 && randomPerfTestIterations == -1)
+	if (basicFunctionalityTest == -1 && simplePerfTestIterations == -1 && randomPerfTestIterations == -1
+		&& latencyTestIterations == -1 && fragmentationTestIterations == -1
+		&& objectPoolTestIterations == -1 && growthTestIterations == -1 && trimTest == -1
+		&& hugePageTestIterations == -1 && threadTestIterations == -1
+		&& stressTestIterations == -1 && producerConsumerTestIterations == -1
+		&& containerTestIterations == -1 && resourceTestIterations == -1
+		&& reallocTestIterations == -1 && batchTestIterations == -1
+		&& uniquePointerTestIterations == -1 && sharedPointerTestIterations == -1
+		&& frameTestIterations == -1)
 	{
 		basicFunctionalityTest = 1;
 		simplePerfTestIterations = DEFAULT_SIMPLE_TEST_COUNT;
 		randomPerfTestIterations = DEFAULT_RANDOM_TEST_COUNT;
+		latencyTestIterations = DEFAULT_LATENCY_TEST_COUNT;
+		fragmentationTestIterations = DEFAULT_FRAGMENTATION_TEST_COUNT;
+		objectPoolTestIterations = DEFAULT_OBJECT_POOL_TEST_COUNT;
+		growthTestIterations = DEFAULT_GROWTH_TEST_COUNT;
+		trimTest = 1;
+		hugePageTestIterations = DEFAULT_HUGE_PAGE_TEST_COUNT;
+		threadTestIterations = DEFAULT_THREAD_TEST_COUNT;
+		stressTestIterations = DEFAULT_CONCURRENT_STRESS_TEST_COUNT;
+		producerConsumerTestIterations = DEFAULT_PRODUCER_CONSUMER_TEST_COUNT;
+		containerTestIterations = DEFAULT_CONTAINER_TEST_COUNT;
+		resourceTestIterations = DEFAULT_RESOURCE_TEST_COUNT;
+		reallocTestIterations = DEFAULT_REALLOC_TEST_COUNT;
+		batchTestIterations = DEFAULT_BATCH_TEST_COUNT;
+		uniquePointerTestIterations = DEFAULT_UNIQUE_POINTER_TEST_COUNT;
+		sharedPointerTestIterations = DEFAULT_SHARED_POINTER_TEST_COUNT;
+		frameTestIterations = DEFAULT_FRAME_TEST_COUNT;
 	}
 
 	std::cout << "- Chunks: " << chunksToAllocate
@@ -108,7 +196,90 @@ int main(int argc, char** argv)
 		std::cout << "will be executed " << randomPerfTestIterations << " times";
 	else
 		std::cout << "won't be executed";
-	if (simplePerfTestIterations != -1 || randomPerfTestIterations != -1)
+	std::cout << std::endl << "- Latency test ";
+	if (latencyTestIterations != -1)
+		std::cout << "will be executed " << latencyTestIterations << " times";
+	else
+		std::cout << "won't be executed";
+	std::cout << std::endl << "- Fragmentation test ";
+	if (fragmentationTestIterations != -1)
+		std::cout << "will be executed " << fragmentationTestIterations << " times";
+	else
+		std::cout << "won't be executed";
+	std::cout << std::endl << "- Object pool test ";
+	if (objectPoolTestIterations != -1)
+		std::cout << "will be executed " << objectPoolTestIterations << " times";
+	else
+		std::cout << "won't be executed";
+	std::cout << std::endl << "- Growth test ";
+	if (growthTestIterations != -1)
+		std::cout << "will be executed " << growthTestIterations << " times";
+	else
+		std::cout << "won't be executed";
+	std::cout << std::endl << "- Trim test " << (trimTest != 1
+		? "won't be executed"
+		: "will be executed");
+	std::cout << std::endl << "- Huge page test ";
+	if (hugePageTestIterations != -1)
+		std::cout << "will be executed " << hugePageTestIterations << " times";
+	else
+		std::cout << "won't be executed";
+	std::cout << std::endl << "- Thread test ";
+	if (threadTestIterations != -1)
+		std::cout << "will be executed " << threadTestIterations << " times";
+	else
+		std::cout << "won't be executed";
+	std::cout << std::endl << "- Concurrent stress test ";
+	if (stressTestIterations != -1)
+		std::cout << "will be executed " << stressTestIterations << " times";
+	else
+		std::cout << "won't be executed";
+	std::cout << std::endl << "- Producer/consumer test ";
+	if (producerConsumerTestIterations != -1)
+		std::cout << "will be executed " << producerConsumerTestIterations << " times";
+	else
+		std::cout << "won't be executed";
+	std::cout << std::endl << "- Container test ";
+	if (containerTestIterations != -1)
+		std::cout << "will be executed " << containerTestIterations << " times";
+	else
+		std::cout << "won't be executed";
+	std::cout << std::endl << "- Memory resource test ";
+	if (resourceTestIterations != -1)
+		std::cout << "will be executed " << resourceTestIterations << " times";
+	else
+		std::cout << "won't be executed";
+	std::cout << std::endl << "- Realloc test ";
+	if (reallocTestIterations != -1)
+		std::cout << "will be executed " << reallocTestIterations << " times";
+	else
+		std::cout << "won't be executed";
+	std::cout << std::endl << "- Batch test ";
+	if (batchTestIterations != -1)
+		std::cout << "will be executed " << batchTestIterations << " times";
+	else
+		std::cout << "won't be executed";
+	std::cout << std::endl << "- Unique pointer test ";
+	if (uniquePointerTestIterations != -1)
+		std::cout << "will be executed " << uniquePointerTestIterations << " times";
+	else
+		std::cout << "won't be executed";
+	std::cout << std::endl << "- Shared pointer test ";
+	if (sharedPointerTestIterations != -1)
+		std::cout << "will be executed " << sharedPointerTestIterations << " times";
+	else
+		std::cout << "won't be executed";
+	std::cout << std::endl << "- Frame test ";
+	if (frameTestIterations != -1)
+		std::cout << "will be executed " << frameTestIterations << " times";
+	else
+		std::cout << "won't be executed";
+	if (simplePerfTestIterations != -1 || randomPerfTestIterations != -1 || latencyTestIterations != -1
+		|| objectPoolTestIterations != -1 || growthTestIterations != -1 || hugePageTestIterations != -1
+		|| threadTestIterations != -1 || stressTestIterations != -1 || producerConsumerTestIterations != -1
+		|| containerTestIterations != -1 || resourceTestIterations != -1 || reallocTestIterations != -1
+		|| batchTestIterations != -1 || uniquePointerTestIterations != -1
+		|| sharedPointerTestIterations != -1 || frameTestIterations != -1)
 		std::cout << std::endl << "- Each performance test will have " << ticksPerTest << " ticks";
 	std::cout << std::endl;
 
@@ -119,6 +290,38 @@ int main(int argc, char** argv)
 		PoolTests::ComparativeSimpleTests(chunksToAllocate, chunkSizeInBytes, simplePerfTestIterations, ticksPerTest);
 	if (randomPerfTestIterations > 0)
 		PoolTests::ComparativeRandomTests(chunksToAllocate, chunkSizeInBytes, randomPerfTestIterations, ticksPerTest);
+	if (latencyTestIterations > 0)
+		PoolTests::ComparativeLatencyTests(chunksToAllocate, chunkSizeInBytes, latencyTestIterations, ticksPerTest);
+	if (fragmentationTestIterations > 0)
+		PoolTests::ComparativeFragmentationTests(chunksToAllocate, chunkSizeInBytes, fragmentationTestIterations);
+	if (objectPoolTestIterations > 0)
+		PoolTests::ComparativeObjectPoolTests(chunksToAllocate, objectPoolTestIterations, ticksPerTest);
+	if (growthTestIterations > 0)
+		PoolTests::ComparativeGrowthTests(chunksToAllocate, chunkSizeInBytes, growthTestIterations, ticksPerTest);
+	if (trimTest == 1)
+		PoolTests::ComparativeTrimTests(chunkSizeInBytes);
+	if (hugePageTestIterations > 0)
+		PoolTests::ComparativeHugePageTests(chunkSizeInBytes, hugePageTestIterations, ticksPerTest);
+	if (threadTestIterations > 0)
+		PoolTests::ComparativeThreadTests(chunksToAllocate, chunkSizeInBytes, threadTestIterations, ticksPerTest);
+	if (stressTestIterations > 0)
+		PoolTests::ConcurrentStressTests(chunksToAllocate, chunkSizeInBytes, stressTestIterations, ticksPerTest);
+	if (producerConsumerTestIterations > 0)
+		PoolTests::ComparativeProducerConsumerTests(chunksToAllocate, chunkSizeInBytes, producerConsumerTestIterations, ticksPerTest);
+	if (containerTestIterations > 0)
+		PoolTests::ComparativeContainerTests(chunksToAllocate, chunkSizeInBytes, containerTestIterations, ticksPerTest);
+	if (resourceTestIterations > 0)
+		PoolTests::ComparativeResourceTests(chunksToAllocate, chunkSizeInBytes, resourceTestIterations, ticksPerTest);
+	if (reallocTestIterations > 0)
+		PoolTests::ComparativeReallocTests(chunksToAllocate, chunkSizeInBytes, reallocTestIterations, ticksPerTest);
+	if (batchTestIterations > 0)
+		PoolTests::ComparativeBatchTests(chunksToAllocate, chunkSizeInBytes, batchTestIterations, ticksPerTest);
+	if (uniquePointerTestIterations > 0)
+		PoolTests::ComparativeUniquePointerTests(chunksToAllocate, uniquePointerTestIterations, ticksPerTest);
+	if (sharedPointerTestIterations > 0)
+		PoolTests::ComparativeSharedPointerTests(chunksToAllocate, sharedPointerTestIterations, ticksPerTest);
+	if (frameTestIterations > 0)
+		PoolTests::ComparativeFrameTests(chunkSizeInBytes, frameTestIterations, ticksPerTest);
 
 	if (pauseAtEnd)
 		system("pause");